@@ -0,0 +1,50 @@
+#include "AllocCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions for the benchmark binary only.
+// The nothrow, array and sized-delete forms forward to these by default.
+
+namespace {
+
+std::atomic<std::size_t> g_allocations{0};
+
+void* Allocate(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(std::size_t size, std::align_val_t align)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t a = static_cast<std::size_t>(align);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    const std::size_t n = ((size ? size : 1) + a - 1) / a * a;
+    if (void* p = std::aligned_alloc(a, n)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+std::size_t AllocCounter::Allocations()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)                          { return Allocate(size); }
+void* operator new[](std::size_t size)                        { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t al)     { return AllocateAligned(size, al); }
+void* operator new[](std::size_t size, std::align_val_t al)   { return AllocateAligned(size, al); }
+
+void operator delete(void* p) noexcept                        { std::free(p); }
+void operator delete[](void* p) noexcept                      { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept           { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept         { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept      { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept    { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept   { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
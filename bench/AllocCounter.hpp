@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// Process-wide count of global operator new calls, so benchmark phases
+// can report how many heap allocations they made.
+namespace AllocCounter {
+
+std::size_t Allocations();
+
+}
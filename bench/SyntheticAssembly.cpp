@@ -0,0 +1,154 @@
+#include "SyntheticAssembly.hpp"
+
+#include <XCAFApp_Application.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <TDataStd_Name.hxx>
+#include <TCollection_ExtendedString.hxx>
+#include <TopLoc_Location.hxx>
+#include <Quantity_Color.hxx>
+#include <STEPCAFControl_Writer.hxx>
+#include <IFSelect_ReturnStatus.hxx>
+
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRepPrimAPI_MakeCylinder.hxx>
+#include <BRepPrimAPI_MakeSphere.hxx>
+#include <BRepPrimAPI_MakeTorus.hxx>
+#include <gp.hxx>
+#include <gp_Ax1.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Vec.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr double kSpacing = 60.0;
+
+TopoDS_Shape MakePrimitive(std::size_t k, bool curved)
+{
+    const double s = 10.0 + static_cast<double>(k % 7) * 2.5;
+    if (!curved) {
+        return BRepPrimAPI_MakeBox(s, s * 0.6, s * 0.3).Shape();
+    }
+    switch (k % 4) {
+        case 0:  return BRepPrimAPI_MakeBox(s, s * 0.6, s * 0.3).Shape();
+        case 1:  return BRepPrimAPI_MakeCylinder(s * 0.4, s).Shape();
+        case 2:  return BRepPrimAPI_MakeSphere(s * 0.5).Shape();
+        default: return BRepPrimAPI_MakeTorus(s * 0.5, s * 0.15).Shape();
+    }
+}
+
+Quantity_Color Palette(std::size_t k)
+{
+    // Evenly spread hues, fixed saturation/value
+    const double h = std::fmod(static_cast<double>(k) * 137.508, 360.0);
+    return Quantity_Color(h, 0.6, 0.9, Quantity_TOC_HLS);
+}
+
+struct Builder {
+    const SyntheticConfig&     cfg;
+    Handle(XCAFDoc_ShapeTool)  shapeTool;
+    Handle(XCAFDoc_ColorTool)  colorTool;
+    std::vector<TDF_Label>     protos;
+    std::size_t                fanout   = 2;
+    std::size_t                nextLeaf = 0;
+    std::size_t                nextAsm  = 0;
+
+    // Leaves sit on a 3D grid in world space, rotated in 90° steps
+    TopLoc_Location LeafLocation(std::size_t idx) const
+    {
+        const std::size_t side = static_cast<std::size_t>(
+            std::ceil(std::cbrt(static_cast<double>(cfg.parts))));
+        const double x = static_cast<double>(idx % side);
+        const double y = static_cast<double>((idx / side) % side);
+        const double z = static_cast<double>(idx / (side * side));
+
+        gp_Trsf rot;
+        rot.SetRotation(gp_Ax1(gp::Origin(), gp::DZ()),
+                        static_cast<double>(idx % 4) * M_PI * 0.5);
+        gp_Trsf move;
+        move.SetTranslation(gp_Vec(x * kSpacing, y * kSpacing, z * kSpacing));
+        return TopLoc_Location(move * rot);
+    }
+
+    void fill(const TDF_Label& parent, int level, std::size_t count)
+    {
+        if (level >= cfg.depth) {
+            for (std::size_t i=0; i<count; ++i) {
+                std::size_t idx = nextLeaf++;
+                shapeTool->AddComponent(parent, protos[idx % protos.size()], LeafLocation(idx));
+            }
+            return;
+        }
+
+        std::size_t chunk = (count + fanout - 1) / fanout;
+        for (std::size_t done = 0; done < count; done += chunk) {
+            std::size_t n = std::min(chunk, count - done);
+            TDF_Label sub = shapeTool->NewShape();
+            std::string name = "Asm_" + std::to_string(level) + "_" + std::to_string(nextAsm++);
+            TDataStd_Name::Set(sub, TCollection_ExtendedString(name.c_str()));
+            fill(sub, level + 1, n);
+            shapeTool->AddComponent(parent, sub, TopLoc_Location());
+        }
+    }
+};
+
+} // namespace
+
+Handle(TDocStd_Document) BuildSyntheticAssembly(const SyntheticConfig& cfgIn)
+{
+    Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
+    Handle(TDocStd_Document) doc;
+    app->NewDocument("MDTV-XCAF", doc);
+
+    SyntheticConfig cfg = cfgIn;
+    cfg.parts       = std::max<std::size_t>(cfg.parts, 1);
+    cfg.uniqueParts = std::clamp<std::size_t>(cfg.uniqueParts, 1, cfg.parts);
+    cfg.depth       = std::max(cfg.depth, 1);
+
+    Builder b{cfg,
+              XCAFDoc_DocumentTool::ShapeTool(doc->Main()),
+              XCAFDoc_DocumentTool::ColorTool(doc->Main())};
+
+    for (std::size_t k=0; k<cfg.uniqueParts; ++k) {
+        TDF_Label lab = b.shapeTool->AddShape(MakePrimitive(k, cfg.curved), Standard_False);
+        std::string name = "Part_" + std::to_string(k);
+        TDataStd_Name::Set(lab, TCollection_ExtendedString(name.c_str()));
+        if (cfg.colors) {
+            b.colorTool->SetColor(lab, Palette(k), XCAFDoc_ColorSurf);
+        }
+        b.protos.push_back(lab);
+    }
+
+    b.fanout = std::max<std::size_t>(2, static_cast<std::size_t>(
+        std::ceil(std::pow(static_cast<double>(cfg.parts), 1.0 / cfg.depth))));
+
+    TDF_Label root = b.shapeTool->NewShape();
+    TDataStd_Name::Set(root, TCollection_ExtendedString("SyntheticAssembly"));
+    b.fill(root, 1, cfg.parts);
+
+    b.shapeTool->UpdateAssemblies();
+    return doc;
+}
+
+bool WriteSyntheticStep(const Handle(TDocStd_Document)& doc, const std::string& stepFile)
+{
+    STEPCAFControl_Writer writer;
+    writer.SetColorMode(Standard_True);
+    writer.SetNameMode(Standard_True);
+
+    if (!writer.Transfer(doc, STEPControl_AsIs)) {
+        std::cerr << "STEPCAF Transfer failed for " << stepFile << "\n";
+        return false;
+    }
+    if (writer.Write(stepFile.c_str()) != IFSelect_RetDone) {
+        std::cerr << "STEPCAF Write failed for " << stepFile << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <TDocStd_Document.hxx>
+
+#include <cstddef>
+#include <string>
+
+// Shape of a generated XCAF assembly.
+struct SyntheticConfig {
+    std::size_t parts       = 1000;  // leaf part instances
+    int         depth       = 3;     // assembly nesting levels above the parts
+    std::size_t uniqueParts = 50;    // part definitions; the rest are reused instances
+    bool        curved      = true;  // cylinders/spheres/tori instead of boxes only
+    bool        colors      = true;  // per-definition surface colors
+};
+
+// Build an in-memory XCAF document from OCCT primitives.
+Handle(TDocStd_Document) BuildSyntheticAssembly(const SyntheticConfig& cfg);
+
+// Write the document with STEPCAFControl_Writer (colors + names).
+bool WriteSyntheticStep(const Handle(TDocStd_Document)& doc, const std::string& stepFile);
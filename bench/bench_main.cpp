@@ -0,0 +1,646 @@
+// Benchmark harness: builds synthetic XCAF assemblies and times each
+// conversion stage. Results are written as JSON so runs from different
+// commits can be compared.
+//
+//   stepguru_bench [--sizes 10,1000,50000] [--out bench.json] [--workdir DIR]
+//                  [--depth N] [--unique N] [--planar] [--no-colors]
+//                  [--repeat N] [--no-full] [--label NAME] [--json-accessors N]
+//                  [--render-parts N]
+//   stepguru_bench --generate out.step [--parts N] [--depth N] [--unique N]
+//                  [--planar] [--no-colors]
+
+#include "SyntheticAssembly.hpp"
+#include "AllocCounter.hpp"
+
+#include "Common.hpp"
+#include "Exporter.hpp"
+#include "GlbBuilder.hpp"
+#include "GltfJsonWriter.hpp"
+#include "JsonExporter.hpp"
+#include "MeshExtractor.hpp"
+#include "MeshSimplifier.hpp"
+#include "PngRenderer.hpp"
+#include "SoftRenderer.hpp"
+#include "XcafTools.hpp"
+#include "SpillStore.hpp"
+#include "MeshArena.hpp"
+#include "LabelResolver.hpp"
+#include "AssemblyIndex.hpp"
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/filewritestream.h>
+
+#include <BRepTools.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rapidjson;
+
+namespace {
+
+struct Options {
+    std::vector<std::size_t> sizes = {10, 1000, 50000};
+    std::string     outFile  = "bench.json";
+    std::string     workDir  = "bench_work";
+    std::string     label;
+    std::string     generate;
+    SyntheticConfig cfg;
+    int             repeat   = 1;
+    bool            full     = true;
+    std::size_t     jsonAccessors = 100000;   // glTF JSON microbenchmark, 0 = off
+    std::size_t     renderParts   = 4;        // thumbnails through both renderers, 0 = off
+};
+
+struct Result {
+    std::size_t parts;
+    std::string phase;
+    double      seconds;
+    std::size_t items;
+    std::size_t allocations;
+    double      score = -1.0;   // phase-specific quality figure, < 0 = none
+};
+
+// Swallows stdout/stderr of the code under test
+class QuietOutput {
+public:
+    QuietOutput()
+        : m_out(std::cout.rdbuf(m_null.rdbuf())),
+          m_err(std::cerr.rdbuf(m_null.rdbuf())) {}
+    ~QuietOutput() {
+        std::cout.rdbuf(m_out);
+        std::cerr.rdbuf(m_err);
+    }
+private:
+    std::ostringstream m_null;
+    std::streambuf*    m_out;
+    std::streambuf*    m_err;
+};
+
+// Heap allocations made by the fastest run of the last BestOf()
+std::size_t g_bestAllocations = 0;
+
+template <typename F>
+double BestOf(int repeat, F&& f)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int r=0; r<std::max(repeat, 1); ++r) {
+        const std::size_t a0 = AllocCounter::Allocations();
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(t1 - t0).count();
+        if (sec < best) {
+            best = sec;
+            g_bestAllocations = AllocCounter::Allocations() - a0;
+        }
+    }
+    return best;
+}
+
+std::vector<std::size_t> ParseSizes(const char* arg)
+{
+    std::vector<std::size_t> out;
+    std::stringstream ss(arg);
+    std::string tok;
+    while (std::getline(ss, tok, ',')) {
+        if (!tok.empty()) out.push_back(std::strtoull(tok.c_str(), nullptr, 10));
+    }
+    return out;
+}
+
+Options ParseArgs(int argc, char* argv[])
+{
+    Options o;
+    for (int i=1; i<argc; ++i) {
+        auto is = [&](const char* flag) { return !std::strcmp(argv[i], flag); };
+        auto hasValue = [&]() { return i+1 < argc; };
+
+        if      (is("--sizes")    && hasValue()) o.sizes   = ParseSizes(argv[++i]);
+        else if (is("--out")      && hasValue()) o.outFile = argv[++i];
+        else if (is("--workdir")  && hasValue()) o.workDir = argv[++i];
+        else if (is("--label")    && hasValue()) o.label   = argv[++i];
+        else if (is("--generate") && hasValue()) o.generate = argv[++i];
+        else if (is("--parts")    && hasValue()) o.cfg.parts = std::strtoull(argv[++i], nullptr, 10);
+        else if (is("--depth")    && hasValue()) o.cfg.depth = std::atoi(argv[++i]);
+        else if (is("--unique")   && hasValue()) o.cfg.uniqueParts = std::strtoull(argv[++i], nullptr, 10);
+        else if (is("--repeat")   && hasValue()) o.repeat  = std::atoi(argv[++i]);
+        else if (is("--json-accessors") && hasValue()) o.jsonAccessors = std::strtoull(argv[++i], nullptr, 10);
+        else if (is("--render-parts") && hasValue()) o.renderParts = std::strtoull(argv[++i], nullptr, 10);
+        else if (is("--planar"))    o.cfg.curved = false;
+        else if (is("--no-colors")) o.cfg.colors = false;
+        else if (is("--no-full"))   o.full = false;
+        else std::cerr << "Ignoring unknown argument: " << argv[i] << "\n";
+    }
+    return o;
+}
+
+// Agreement of a software thumbnail with the OCCT one of the same part:
+// IoU of the silhouettes (non-background pixels) and the mean absolute
+// channel difference over the whole frame, 0..1
+bool CompareThumbnails(const std::string& occtPng, const RgbImage& cpu,
+                       double& iou, double& meanDiff)
+{
+    Image_AlienPixMap pix;
+    if (!pix.Load(TCollection_AsciiString(occtPng.c_str()))) return false;
+    if (static_cast<int>(pix.SizeX()) != cpu.width || static_cast<int>(pix.SizeY()) != cpu.height) {
+        return false;
+    }
+
+    auto isBackground = [](double r, double g, double b) {
+        return r > 0.98 && g > 0.98 && b > 0.98;
+    };
+    std::size_t both = 0, either = 0;
+    double diff = 0.0;
+    for (int y=0; y<cpu.height; ++y) {
+        for (int x=0; x<cpu.width; ++x) {
+            const Quantity_Color c = pix.PixelColor(x, y).GetRGB();
+            const std::uint8_t* p = &cpu.pixels[(static_cast<std::size_t>(y) * cpu.width + x) * 3];
+            const double r = p[0] / 255.0, g = p[1] / 255.0, b = p[2] / 255.0;
+
+            const bool inOcct = !isBackground(c.Red(), c.Green(), c.Blue());
+            const bool inCpu  = !isBackground(r, g, b);
+            both   += inOcct && inCpu;
+            either += inOcct || inCpu;
+            diff   += std::fabs(c.Red() - r) + std::fabs(c.Green() - g) + std::fabs(c.Blue() - b);
+        }
+    }
+    iou      = either ? static_cast<double>(both) / static_cast<double>(either) : 1.0;
+    meanDiff = diff / (3.0 * cpu.width * cpu.height);
+    return true;
+}
+
+void RunSize(const Options& opt, std::size_t parts, std::vector<Result>& results)
+{
+    namespace fs = std::filesystem;
+
+    SyntheticConfig cfg = opt.cfg;
+    cfg.parts = parts;
+    const std::string tag = std::to_string(parts);
+    auto add = [&](const char* phase, double sec, std::size_t items) {
+        results.push_back({parts, phase, sec, items, g_bestAllocations});
+        std::cout << "  " << std::left << std::setw(28) << phase
+                  << std::right << std::fixed << std::setprecision(4)
+                  << sec << " s  (" << items << ", "
+                  << g_bestAllocations << " allocs)\n";
+    };
+
+    std::cout << "\n=== " << parts << " parts ===\n";
+
+    Handle(TDocStd_Document) doc;
+    add("Generate", BestOf(1, [&] { doc = BuildSyntheticAssembly(cfg); }), parts);
+
+    const std::string stepFile = opt.workDir + "/synthetic_" + tag + ".step";
+    add("WriteStep", BestOf(1, [&] { WriteSyntheticStep(doc, stepFile); }), parts);
+
+    Handle(XCAFDoc_ShapeTool) shapeTool = XCAFDoc_DocumentTool::ShapeTool(doc->Main());
+    Handle(XCAFDoc_ColorTool) colorTool = XCAFDoc_DocumentTool::ColorTool(doc->Main());
+
+    TDF_LabelSequence roots;
+    shapeTool->GetFreeShapes(roots);
+    if (roots.IsEmpty()) {
+        std::cerr << "Generated document has no free shapes\n";
+        return;
+    }
+
+    // Cold build: a fresh label cache every repeat
+    AssemblyIndex index;
+    double indexSec = BestOf(opt.repeat, [&] {
+        LabelResolver labels(shapeTool, colorTool);
+        index.build(roots, labels);
+    });
+    add("AssemblyIndex::build", indexSec, index.size());
+
+    add("DumpAssemblyTreeDeep", BestOf(opt.repeat, [&] {
+        QuietOutput quiet;
+        DumpAssemblyTreeDeep(index);
+    }), parts);
+
+    const std::string jsonFile = opt.workDir + "/assembly_" + tag + ".json";
+    add("JsonExporter::Export", BestOf(opt.repeat, [&] {
+        JsonExporter::Export(index, index.roots().front(), jsonFile);
+    }), parts);
+
+    // Unique definitions, as the per-component loop meshes them
+    std::map<std::string, TopoDS_Shape> defs;
+    for (std::uint32_t n : index.leafComponents()) {
+        const std::uint32_t def = index.def(n);
+        defs.emplace(index.path(def), index.shape(def));
+    }
+
+    struct Mesh {
+        std::vector<TriBucket>  tris;
+        std::vector<EdgeBucket> edges;
+        std::vector<RGBA>       mats;
+    };
+    std::vector<Mesh> meshes;
+    const RGBA gray{0.7f, 0.7f, 0.7f, 1.0f};
+
+    add("MeshShape", BestOf(opt.repeat, [&] {
+        meshes.clear();
+        for (const auto& [key, shape] : defs) {
+            BRepTools::Clean(shape);   // force re-triangulation on every repeat
+            MaterialRegistry reg;
+            Mesh m;
+            MeshShape(shape, gray, reg, m.tris, m.edges);
+            m.mats = reg.materials();
+            meshes.push_back(std::move(m));
+        }
+    }), defs.size());
+
+    // Same extraction with growth buffers in a per-part arena; only the
+    // final copy into the kept mesh touches the global heap
+    add("MeshShape(arena)", BestOf(opt.repeat, [&] {
+        meshes.clear();
+        MeshArena arena;
+        for (const auto& [key, shape] : defs) {
+            BRepTools::Clean(shape);
+            MaterialRegistry reg;
+            Mesh m;
+            {
+                std::vector<TriBucket>  tris;
+                std::vector<EdgeBucket> edges;
+                MeshShape(shape, gray, reg, tris, edges, arena.resource());
+                m.tris  = tris;
+                m.edges = edges;
+            }
+            arena.reset();
+            m.mats = reg.materials();
+            meshes.push_back(std::move(m));
+        }
+    }), defs.size());
+
+    // Payload bytes, so both GLB paths report comparable throughput
+    std::size_t binBytes = 0;
+    for (const auto& m : meshes) binBytes += BucketBytes(m.tris) + BucketBytes(m.edges);
+
+    const std::string glbFile = opt.workDir + "/assembly_" + tag + ".glb";
+    add("GlbBuilder::writeGlb", BestOf(opt.repeat, [&] {
+        GlbBuilder builder;
+        for (const auto& m : meshes) builder.addBuckets(m.tris, m.edges, m.mats);
+        ExportStats stats;
+        QuietOutput quiet;
+        builder.writeGlb(glbFile, false, stats);
+    }), binBytes);
+
+    // Same assembly through the out-of-core path: append to spill files,
+    // then stream them into the BIN chunk
+
+    const std::string spillGlb = opt.workDir + "/assembly_spill_" + tag + ".glb";
+    add("GlbBuilder::writeGlb(spill)", BestOf(opt.repeat, [&] {
+        SpillBucketStore store(opt.workDir);
+        MaterialRegistry reg;
+        for (const auto& m : meshes) {
+            // Re-home every part's buckets onto shared materials, as the
+            // assembly path does with one MaterialRegistry
+            std::vector<TriBucket>  tris;
+            std::vector<EdgeBucket> edges;
+            for (const auto& b : m.tris) {
+                if (b.materialIndex < 0) continue;
+                std::size_t idx = static_cast<std::size_t>(reg.getOrCreate(m.mats[b.materialIndex]));
+                if (idx >= tris.size()) tris.resize(idx + 1);
+                tris[idx] = b;
+            }
+            for (const auto& e : m.edges) {
+                if (e.materialIndex < 0) continue;
+                std::size_t idx = static_cast<std::size_t>(reg.getOrCreate(m.mats[e.materialIndex]));
+                if (idx >= edges.size()) edges.resize(idx + 1);
+                edges[idx] = e;
+            }
+            store.append(tris, edges);
+        }
+        GlbBuilder builder;
+        builder.addSpilled(store, reg.materials());
+        ExportStats stats;
+        QuietOutput quiet;
+        builder.writeGlb(spillGlb, false, stats);
+    }), binBytes);
+
+    // Quadric decimation of every part to a quarter of its triangles
+    // (includes copying the buckets, which the decimator edits in place)
+    std::size_t triangles = 0;
+    for (const auto& m : meshes) {
+        for (const auto& b : m.tris) triangles += b.indices.size() / 3;
+    }
+    add("SimplifyBuckets(25%)", BestOf(opt.repeat, [&] {
+        for (const auto& m : meshes) {
+            std::vector<TriBucket> tris = m.tris;
+            std::size_t n = 0;
+            for (const auto& b : tris) n += b.indices.size() / 3;
+            SimplifyBuckets(tris, n / 4);
+        }
+    }), triangles);
+
+    // The same thumbnails through OCCT (BRep, OpenGL) and the software
+    // rasterizer (buckets); the software phase's score is the mean
+    // silhouette IoU against the OCCT images
+    if (opt.renderParts) {
+        const std::size_t n = std::min(opt.renderParts, meshes.size());
+        std::vector<TopoDS_Shape> shapes;
+        for (const auto& [key, shape] : defs) {
+            if (shapes.size() == n) break;
+            shapes.push_back(shape);
+        }
+        auto thumb = [&](const char* kind, std::size_t i) {
+            return opt.workDir + "/thumb_" + kind + "_" + tag + "_" + std::to_string(i) + ".png";
+        };
+
+        add("RenderPNG(occt)", BestOf(1, [&] {
+            QuietOutput quiet;
+            for (std::size_t i=0; i<n; ++i) RenderPNG({shapes[i]}, {gray}, thumb("occt", i));
+        }), n);
+        // Setup is paid once, outside the timed loop
+        RenderSession session;
+        {
+            QuietOutput quiet;
+            session.render({shapes[0]}, {gray}, thumb("occt", 0));
+        }
+        add("RenderSession::render", BestOf(opt.repeat, [&] {
+            QuietOutput quiet;
+            for (std::size_t i=0; i<n; ++i) session.render({shapes[i]}, {gray}, thumb("occt", i));
+        }), n);
+        add("RenderSession::renderBuckets", BestOf(opt.repeat, [&] {
+            QuietOutput quiet;
+            for (std::size_t i=0; i<n; ++i) {
+                session.renderBuckets(meshes[i].tris, meshes[i].edges, meshes[i].mats,
+                                      thumb("occt_mesh", i));
+            }
+        }), n);
+        add("RenderBucketsPNG(cpu)", BestOf(opt.repeat, [&] {
+            QuietOutput quiet;
+            for (std::size_t i=0; i<n; ++i) {
+                RenderBucketsPNG(meshes[i].tris, meshes[i].edges, meshes[i].mats, thumb("cpu", i));
+            }
+        }), n);
+
+        double iouSum = 0.0, diffSum = 0.0;
+        std::size_t compared = 0;
+        std::vector<RgbImage> images;
+        for (std::size_t i=0; i<n; ++i) {
+            double iou = 0.0, diff = 0.0;
+            const RgbImage& cpu = images.emplace_back(RenderBuckets(meshes[i].tris, meshes[i].edges, meshes[i].mats));
+            if (CompareThumbnails(thumb("occt", i), cpu, iou, diff)) {
+                iouSum  += iou;
+                diffSum += diff;
+                ++compared;
+            }
+        }
+        if (compared) {
+            results.back().score = iouSum / compared;
+            std::cout << "  cpu vs occt: silhouette IoU " << iouSum / compared
+                      << ", mean |Δ| " << diffSum / compared
+                      << " over " << compared << " thumbnail(s)\n";
+        }
+
+        // Encoding the same thumbnails in every format; the item count is
+        // the encoded size and the score the compression ratio
+        struct Encoding {
+            const char*        phase;
+            ImageEncodeOptions opt;
+        };
+        const Encoding encodings[] = {
+            {"EncodeImage(png-fast)",    {ImageFormat::Png,  PngEffort::Fast}},
+            {"EncodeImage(png-default)", {ImageFormat::Png,  PngEffort::Default}},
+            {"EncodeImage(png-best)",    {ImageFormat::Png,  PngEffort::Best}},
+            {"EncodeImage(qoi)",         {ImageFormat::Qoi,  PngEffort::Default}},
+            {"EncodeImage(webp)",        {ImageFormat::Webp, PngEffort::Default}},
+        };
+        std::size_t rawBytes = 0;
+        for (const auto& img : images) rawBytes += img.pixels.size();
+        for (const auto& e : encodings) {
+            std::size_t encoded = 0;
+            const double sec = BestOf(opt.repeat, [&] {
+                encoded = 0;
+                for (const auto& img : images) encoded += EncodeImage(img, e.opt).size();
+            });
+            add(e.phase, sec, encoded);
+            if (encoded) results.back().score = static_cast<double>(rawBytes) / encoded;
+        }
+    }
+
+    if (opt.full) {
+        const std::string outDir = opt.workDir + "/full_" + tag;
+        fs::create_directories(outDir);
+        std::vector<std::string> args = {"stepguru", stepFile, "--outdir", outDir};
+        std::vector<char*> argv;
+        for (auto& a : args) argv.push_back(a.data());
+
+        add("FullPipeline", BestOf(1, [&] {
+            QuietOutput quiet;
+            Exporter ex;
+            ex.run(static_cast<int>(argv.size()), argv.data());
+        }), parts);
+    }
+}
+
+// The GLB JSON chunk as GlbBuilder formatted it with iostreams, kept as
+// the baseline for the GltfJsonWriter microbenchmark
+std::string LegacyGltfJson(const std::vector<RGBA>&            materials,
+                           const std::vector<Gltf::Primitive>&  primitives,
+                           std::size_t                          bufferBytes,
+                           const std::vector<Gltf::BufferView>& bufferViews,
+                           const std::vector<Gltf::Accessor>&   accessors)
+{
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"asset\": {\"version\": \"2.0\", \"generator\": \"step2glb\"},\n";
+    json << "  \"scene\": 0,\n";
+    json << "  \"scenes\": [{\"nodes\": [0]}],\n";
+    json << "  \"nodes\": [{\"mesh\": 0}],\n";
+    json << "  \"materials\": [\n";
+    for (std::size_t i=0; i<materials.size(); ++i) {
+        const auto& m = materials[i];
+        json << "    {\"pbrMetallicRoughness\": {"
+             << "\"baseColorFactor\": ["
+             << m.r << "," << m.g << "," << m.b << "," << m.a
+             << "], \"metallicFactor\": 0.0, \"roughnessFactor\": 1.0}, "
+             << "\"doubleSided\": true}";
+        if (i + 1 < materials.size()) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+    json << "  \"meshes\": [\n";
+    json << "    {\"primitives\": [\n";
+    for (std::size_t i=0; i<primitives.size(); ++i) {
+        const auto& p = primitives[i];
+        json << "      {\"attributes\": {\"POSITION\": " << p.posAcc;
+        if (p.nrmAcc >= 0) json << ", \"NORMAL\": " << p.nrmAcc;
+        json << "}, \"indices\": " << p.idxAcc
+             << ", \"material\": " << p.material
+             << ", \"mode\": " << p.mode << "}";
+        if (i + 1 < primitives.size()) json << ",";
+        json << "\n";
+    }
+    json << "    ]}\n";
+    json << "  ],\n";
+    json << "  \"buffers\": [ { \"byteLength\": " << bufferBytes << " } ],\n";
+    json << "  \"bufferViews\": [\n";
+    for (std::size_t i=0; i<bufferViews.size(); ++i) {
+        const auto& bv = bufferViews[i];
+        json << "    {\"buffer\": 0, \"byteOffset\": " << bv.byteOffset
+             << ", \"byteLength\": " << bv.byteLength
+             << ", \"target\": " << bv.target << "}";
+        if (i + 1 < bufferViews.size()) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+    json << "  \"accessors\": [\n";
+    for (std::size_t i=0; i<accessors.size(); ++i) {
+        const auto& a = accessors[i];
+        json << "    {\"bufferView\": " << a.bufferView
+             << ", \"componentType\": " << a.componentType
+             << ", \"count\": " << a.count
+             << ", \"type\": \"" << (a.type == Gltf::AccessorType::Vec3 ? "VEC3" : "SCALAR") << "\"";
+        if (a.hasBounds) {
+            json << ", \"min\": ["
+                 << a.bounds[0] << "," << a.bounds[1] << "," << a.bounds[2] << "]";
+            json << ", \"max\": ["
+                 << a.bounds[3] << "," << a.bounds[4] << "," << a.bounds[5] << "]";
+        }
+        json << "}";
+        if (i + 1 < accessors.size()) json << ",";
+        json << "\n";
+    }
+    json << "  ]\n";
+    json << "}\n";
+    return json.str();
+}
+
+// JSON chunk of a primitive-heavy scene: one triangle primitive (position,
+// normal, index accessors) per three accessors, with fractional bounds
+void RunGltfJsonMicro(const Options& opt, std::vector<Result>& results)
+{
+    const std::size_t nPrims = std::max<std::size_t>(opt.jsonAccessors / 3, 1);
+
+    std::vector<RGBA>             materials;
+    std::vector<Gltf::Primitive>  primitives;
+    std::vector<Gltf::BufferView> views;
+    std::vector<Gltf::Accessor>   accessors;
+    std::uint32_t off = 0;
+    for (std::size_t i=0; i<nPrims; ++i) {
+        const float f = static_cast<float>(i);
+        if (i % 64 == 0) materials.push_back({0.1f * (i % 7), 0.37f, 0.8f, 1.0f});
+        const std::array<float,6> box = {f * 0.173f, -f * 0.021f, 1.0f / (f + 3.0f),
+                                         f * 0.173f + 12.5f, f * 0.019f, 7.3f + f};
+        const int base = static_cast<int>(views.size());
+        for (int k=0; k<3; ++k) {
+            views.push_back({0, off, 4096, k < 2 ? 34962 : 34963});
+            off += 4096;
+        }
+        accessors.push_back({base,     5126, 341, Gltf::AccessorType::Vec3,   box, true});
+        accessors.push_back({base + 1, 5126, 341, Gltf::AccessorType::Vec3,   {-1,-1,-1,1,1,1}, true});
+        accessors.push_back({base + 2, 5125, 1023, Gltf::AccessorType::Scalar, {}, false});
+        primitives.push_back({base, base + 1, base + 2, static_cast<int>(materials.size() - 1), 4});
+    }
+
+    auto add = [&](const char* phase, double sec, std::size_t bytes) {
+        results.push_back({accessors.size(), phase, sec, bytes, g_bestAllocations});
+        std::cout << "  " << std::left << std::setw(28) << phase
+                  << std::right << std::fixed << std::setprecision(4)
+                  << sec << " s  (" << bytes << " bytes, "
+                  << g_bestAllocations << " allocs)\n";
+    };
+
+    std::cout << "\n=== glTF JSON chunk, " << accessors.size() << " accessors ===\n";
+
+    std::size_t bytes = 0;
+    double sec = BestOf(opt.repeat, [&] {
+        bytes = LegacyGltfJson(materials, primitives, off, views, accessors).size();
+    });
+    add("GltfJson(ostringstream)", sec, bytes);
+
+    const std::vector<Gltf::Buffer> buffers = {{off, {}}};
+    sec = BestOf(opt.repeat, [&] {
+        GltfJsonWriter json(GltfJsonWriter::EstimateBytes(materials.size(), primitives.size(),
+                                                          views.size(), accessors.size()));
+        json.writeScene(materials, primitives, buffers, views, accessors);
+        bytes = json.str().size();
+    });
+    add("GltfJsonWriter", sec, bytes);
+}
+
+bool WriteResults(const Options& opt, const std::vector<Result>& results)
+{
+    FILE* f = fopen(opt.outFile.c_str(), "w");
+    if (!f) {
+        std::cerr << "❌ Cannot write " << opt.outFile << "\n";
+        return false;
+    }
+    char buff[65536];
+    FileWriteStream fs(f, buff, sizeof(buff));
+    PrettyWriter<FileWriteStream> w(fs);
+    w.SetIndent(' ', 2);
+
+    w.StartObject();
+    w.Key("label"); w.String(opt.label.c_str());
+    w.Key("config");
+    w.StartObject();
+    w.Key("depth");       w.Int(opt.cfg.depth);
+    w.Key("uniqueParts"); w.Uint64(opt.cfg.uniqueParts);
+    w.Key("curved");      w.Bool(opt.cfg.curved);
+    w.Key("colors");      w.Bool(opt.cfg.colors);
+    w.Key("repeat");      w.Int(opt.repeat);
+    w.EndObject();
+    w.Key("results");
+    w.StartArray();
+    for (const auto& r : results) {
+        w.StartObject();
+        w.Key("parts");   w.Uint64(r.parts);
+        w.Key("phase");   w.String(r.phase.c_str());
+        w.Key("seconds"); w.Double(r.seconds);
+        w.Key("items");   w.Uint64(r.items);
+        w.Key("allocations"); w.Uint64(r.allocations);
+        if (r.score >= 0.0) {
+            w.Key("score"); w.Double(r.score);
+        }
+        w.EndObject();
+    }
+    w.EndArray();
+    w.EndObject();
+    fs.Flush();
+    fclose(f);
+
+    std::cout << "\n📊 Benchmark results written: " << opt.outFile << "\n";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options opt = ParseArgs(argc, argv);
+
+    if (!opt.generate.empty()) {
+        Handle(TDocStd_Document) doc = BuildSyntheticAssembly(opt.cfg);
+        if (!WriteSyntheticStep(doc, opt.generate)) return 1;
+        std::cout << "📄 Synthetic assembly (" << opt.cfg.parts << " parts) saved: "
+                  << opt.generate << "\n";
+        return 0;
+    }
+
+    std::filesystem::create_directories(opt.workDir);
+
+    std::vector<Result> results;
+    for (std::size_t n : opt.sizes) {
+        RunSize(opt, n, results);
+    }
+    if (opt.jsonAccessors) {
+        RunGltfJsonMicro(opt, results);
+    }
+    return WriteResults(opt, results) ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+// assembly.bin — binary twin of assembly.json, laid out to be memory-mapped
+// and queried in place. Self-contained: consumers only need this header.
+//
+// Layout (little-endian, every section 8-byte aligned, offsets from file start):
+//
+//   FileHeader
+//   DefinitionRecord[definitionCount]   unique definitions, JSON order
+//   NodeRecord[nodeCount]               instance tree in pre-order, node 0 = root
+//   double[transformCount][16]          row-major 4×4 local transforms
+//   uint32 [stringCount + 1]            string start offsets into string data
+//   char   [...]                        string data, each string NUL-terminated
+//
+// A node's subtree is the node range [n, subtreeEnd). Children can also be
+// walked with firstChild / nextSibling. Missing references are kNone.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AssemblyBinary {
+
+constexpr char          kMagic[8] = {'S','G','A','S','M','B','I','N'};
+constexpr std::uint32_t kVersion  = 1;
+constexpr std::uint32_t kNone     = 0xFFFFFFFFu;
+
+// DefinitionRecord::flags / NodeRecord::flags bits
+constexpr std::uint32_t kHasColor   = 1;
+constexpr std::uint32_t kIsInstance = 1;
+
+// Same spelling as the JSON "shapeType" field (TopAbs_ShapeEnum order)
+constexpr const char* kShapeTypeNames[] = {
+    "COMPOUND", "COMPSOLID", "SOLID", "SHELL", "FACE", "WIRE", "EDGE", "VERTEX", "SHAPE"
+};
+
+struct FileHeader {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t definitionCount;
+    std::uint32_t nodeCount;
+    std::uint32_t transformCount;
+    std::uint32_t stringCount;
+    std::uint64_t definitionsOffset;
+    std::uint64_t nodesOffset;
+    std::uint64_t transformsOffset;
+    std::uint64_t stringOffsetsOffset;
+    std::uint64_t stringDataOffset;
+    std::uint64_t fileSize;
+};
+static_assert(sizeof(FileHeader) == 80, "FileHeader layout");
+
+struct DefinitionRecord {
+    std::uint32_t id;          // string index, label path "0-1-1-2"
+    std::uint32_t name;        // string index, kNone if unnamed
+    std::uint32_t shapeType;   // index into kShapeTypeNames
+    std::uint32_t flags;       // kHasColor
+    float         rgba[4];     // valid with kHasColor, else the 0.8 gray default
+};
+static_assert(sizeof(DefinitionRecord) == 32, "DefinitionRecord layout");
+
+struct NodeRecord {
+    std::uint32_t id;          // string index, label path of the occurrence
+    std::uint32_t definition;  // DefinitionRecord index
+    std::uint32_t parent;
+    std::uint32_t firstChild;
+    std::uint32_t nextSibling;
+    std::uint32_t subtreeEnd;
+    std::uint32_t transform;   // transform index, kNone for identity
+    std::uint32_t flags;       // kIsInstance
+};
+static_assert(sizeof(NodeRecord) == 32, "NodeRecord layout");
+
+// Zero-copy view over an assembly.bin image. open() checks the header, that
+// every section lies inside the buffer and that every string, definition,
+// node and transform index points into its table (children and siblings
+// after their node, so walks terminate); accessors do not re-check.
+class Reader {
+public:
+    Reader() = default;
+    Reader(const void* data, std::size_t size) { open(data, size); }
+
+    bool open(const void* data, std::size_t size)
+    {
+        m_base = static_cast<const unsigned char*>(data);
+        m_size = size;
+        m_ok   = validate();
+        return m_ok;
+    }
+
+    bool ok() const { return m_ok; }
+    const FileHeader& header() const { return *at<FileHeader>(0); }
+
+    std::uint32_t definitionCount() const { return header().definitionCount; }
+    std::uint32_t nodeCount()       const { return header().nodeCount; }
+    std::uint32_t stringCount()     const { return header().stringCount; }
+
+    const DefinitionRecord& definition(std::uint32_t i) const {
+        return at<DefinitionRecord>(header().definitionsOffset)[i];
+    }
+    const NodeRecord& node(std::uint32_t i) const {
+        return at<NodeRecord>(header().nodesOffset)[i];
+    }
+    // Row-major 4×4; nullptr for kNone (identity)
+    const double* transform(std::uint32_t i) const {
+        return i == kNone ? nullptr : at<double>(header().transformsOffset) + 16 * std::size_t(i);
+    }
+    std::string_view string(std::uint32_t i) const {
+        if (i == kNone) return {};
+        const std::uint32_t* offs = at<std::uint32_t>(header().stringOffsetsOffset);
+        const char* data = reinterpret_cast<const char*>(m_base + header().stringDataOffset);
+        return std::string_view(data + offs[i], offs[i + 1] - offs[i] - 1);
+    }
+    const char* shapeTypeName(const DefinitionRecord& d) const {
+        return d.shapeType < std::size(kShapeTypeNames) ? kShapeTypeNames[d.shapeType] : "UNKNOWN";
+    }
+
+private:
+    template <typename T>
+    const T* at(std::uint64_t offset) const {
+        return reinterpret_cast<const T*>(m_base + offset);
+    }
+
+    bool inside(std::uint64_t offset, std::uint64_t bytes) const {
+        return offset <= m_size && bytes <= m_size - offset && offset % 8 == 0;
+    }
+
+    bool validate() const
+    {
+        if (!m_base || m_size < sizeof(FileHeader)) return false;
+        if (reinterpret_cast<std::uintptr_t>(m_base) % 8 != 0) return false;
+        const FileHeader& h = header();
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return false;
+        if (h.version != kVersion || h.headerSize != sizeof(FileHeader)) return false;
+        if (h.fileSize != m_size) return false;
+
+        if (!inside(h.definitionsOffset,   std::uint64_t(h.definitionCount) * sizeof(DefinitionRecord)) ||
+            !inside(h.nodesOffset,         std::uint64_t(h.nodeCount) * sizeof(NodeRecord)) ||
+            !inside(h.transformsOffset,    std::uint64_t(h.transformCount) * 16 * sizeof(double)) ||
+            !inside(h.stringOffsetsOffset, (std::uint64_t(h.stringCount) + 1) * sizeof(std::uint32_t)) ||
+            h.stringDataOffset > m_size)
+        {
+            return false;
+        }
+
+        // Strings must be ordered, in range and NUL-terminated
+        const std::uint32_t* offs = at<std::uint32_t>(h.stringOffsetsOffset);
+        const std::uint64_t dataBytes = m_size - h.stringDataOffset;
+        for (std::uint32_t i=0; i<h.stringCount; ++i) {
+            if (offs[i] >= offs[i + 1] || offs[i + 1] > dataBytes) return false;
+            if (m_base[h.stringDataOffset + offs[i + 1] - 1] != '\0') return false;
+        }
+
+        auto string = [&](std::uint32_t s) { return s < h.stringCount; };
+        auto nodeOrNone = [&](std::uint32_t n) { return n == kNone || n < h.nodeCount; };
+
+        const DefinitionRecord* defs = at<DefinitionRecord>(h.definitionsOffset);
+        for (std::uint32_t i=0; i<h.definitionCount; ++i) {
+            if (!string(defs[i].id) || (defs[i].name != kNone && !string(defs[i].name))) return false;
+        }
+
+        const NodeRecord* nodes = at<NodeRecord>(h.nodesOffset);
+        for (std::uint32_t n=0; n<h.nodeCount; ++n) {
+            const NodeRecord& r = nodes[n];
+            if (!string(r.id) || r.definition >= h.definitionCount) return false;
+            if (!nodeOrNone(r.parent) || !nodeOrNone(r.firstChild) || !nodeOrNone(r.nextSibling)) return false;
+            if ((r.firstChild != kNone && r.firstChild <= n) ||
+                (r.nextSibling != kNone && r.nextSibling <= n)) return false;
+            if (r.subtreeEnd <= n || r.subtreeEnd > h.nodeCount) return false;
+            if (r.transform != kNone && r.transform >= h.transformCount) return false;
+        }
+        return true;
+    }
+
+    const unsigned char* m_base = nullptr;
+    std::size_t          m_size = 0;
+    bool                 m_ok   = false;
+};
+
+// Read-only mapping of a file, for use with Reader.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                m_data = p;
+                m_size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile() { if (m_data) munmap(m_data, m_size); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const void* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    void*       m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+} // namespace AssemblyBinary
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class AssemblyIndex;
+
+// Write the subtree of `rootNode` as assembly.bin (see AssemblyBinary.hpp).
+// Same content and ordering as JsonExporter::Export for that root.
+bool WriteAssemblyBinary(const AssemblyIndex& index,
+                         std::uint32_t        rootNode,
+                         const std::string&   binFile);
+
+// Round-trip check: map `binFile` and compare every definition and
+// instance with the JSON export. Prints the first mismatch.
+bool CompareAssemblyBinaryWithJson(const std::string& binFile,
+                                   const std::string& jsonFile);
+
+// Write assembly.bvh (see AssemblyBvh.hpp): a BVH over the world bounding
+// boxes of the leaf occurrences under `rootNode`, items numbered like the
+// assembly.bin nodes.
+bool WriteAssemblyBvh(const AssemblyIndex& index,
+                      std::uint32_t        rootNode,
+                      const std::string&   bvhFile);
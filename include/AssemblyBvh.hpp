@@ -0,0 +1,224 @@
+#pragma once
+
+// assembly.bvh — bounding volume hierarchy over the world-space boxes of
+// the leaf occurrences in assembly.bin, memory-mapped by `stepguru query`.
+// Self-contained apart from the file mapping shared with AssemblyBinary.hpp.
+//
+// Layout (little-endian, every section 8-byte aligned, offsets from file start):
+//
+//   FileHeader
+//   Node[nodeCount]   depth-first; an inner node (count == 0) has its left
+//                     child right after it and its right child at `first`;
+//                     a leaf owns items [first, first + count)
+//   Item[itemCount]   one per leaf occurrence, grouped by BVH leaf
+//
+// Item::node is a NodeRecord index in the assembly.bin written alongside.
+
+#include "AssemblyBinary.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace AssemblyBvh {
+
+constexpr char          kMagic[8] = {'S','G','A','S','M','B','V','H'};
+constexpr std::uint32_t kVersion  = 1;
+
+struct Box {
+    double min[3];
+    double max[3];
+};
+
+struct FileHeader {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t nodeCount;
+    std::uint32_t itemCount;
+    std::uint64_t nodesOffset;
+    std::uint64_t itemsOffset;
+    std::uint64_t fileSize;
+};
+static_assert(sizeof(FileHeader) == 48, "FileHeader layout");
+
+struct Node {
+    Box           box;
+    std::uint32_t first;       // right child (inner) or first item (leaf)
+    std::uint32_t count;       // 0 for inner nodes
+};
+static_assert(sizeof(Node) == 56, "Node layout");
+
+struct Item {
+    Box           box;
+    std::uint32_t node;        // assembly.bin NodeRecord index
+    std::uint32_t reserved;
+};
+static_assert(sizeof(Item) == 56, "Item layout");
+
+inline bool Overlaps(const Box& a, const Box& b)
+{
+    for (int k=0; k<3; ++k) {
+        if (a.min[k] > b.max[k] || b.min[k] > a.max[k]) return false;
+    }
+    return true;
+}
+
+// Gap between two boxes, 0 when they touch or overlap
+inline double Distance(const Box& a, const Box& b)
+{
+    double d2 = 0.0;
+    for (int k=0; k<3; ++k) {
+        const double gap = std::max({0.0, a.min[k] - b.max[k], b.min[k] - a.max[k]});
+        d2 += gap * gap;
+    }
+    return std::sqrt(d2);
+}
+
+// Slab test; t is the entry distance (0 when the origin is inside)
+inline bool RayHit(const Box& b, const double origin[3], const double invDir[3], double& t)
+{
+    double t0 = 0.0, t1 = std::numeric_limits<double>::infinity();
+    for (int k=0; k<3; ++k) {
+        double tn = (b.min[k] - origin[k]) * invDir[k];
+        double tf = (b.max[k] - origin[k]) * invDir[k];
+        if (tn > tf) std::swap(tn, tf);
+        // NaN from 0 * inf (origin on a slab plane, ray parallel) keeps t0/t1
+        if (tn > t0) t0 = tn;
+        if (tf < t1) t1 = tf;
+        if (t0 > t1) return false;
+    }
+    t = t0;
+    return true;
+}
+
+// Zero-copy view over an assembly.bvh image. open() checks the header and
+// the tree links; queries return item indices.
+class Reader {
+public:
+    Reader() = default;
+    Reader(const void* data, std::size_t size) { open(data, size); }
+
+    bool open(const void* data, std::size_t size)
+    {
+        m_base = static_cast<const unsigned char*>(data);
+        m_size = size;
+        m_ok   = validate();
+        return m_ok;
+    }
+
+    bool ok() const { return m_ok; }
+    const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(m_base); }
+
+    std::uint32_t nodeCount() const { return header().nodeCount; }
+    std::uint32_t itemCount() const { return header().itemCount; }
+
+    const Node& node(std::uint32_t i) const {
+        return reinterpret_cast<const Node*>(m_base + header().nodesOffset)[i];
+    }
+    const Item& item(std::uint32_t i) const {
+        return reinterpret_cast<const Item*>(m_base + header().itemsOffset)[i];
+    }
+
+    // Depth-first walk: descends into nodes whose box passes `test` and
+    // calls `visit(itemIndex)` for items that pass it too
+    template <typename Test, typename Visit>
+    void traverse(Test&& test, Visit&& visit) const
+    {
+        if (nodeCount() == 0) return;
+        std::vector<std::uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const std::uint32_t n = stack.back();
+            stack.pop_back();
+
+            const Node& nd = node(n);
+            if (!test(nd.box)) continue;
+            if (nd.count > 0) {
+                for (std::uint32_t i=nd.first; i<nd.first + nd.count; ++i) {
+                    if (test(item(i).box)) visit(i);
+                }
+            } else {
+                stack.push_back(nd.first);
+                stack.push_back(n + 1);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> overlapping(const Box& q) const
+    {
+        std::vector<std::uint32_t> out;
+        traverse([&](const Box& b) { return Overlaps(b, q); },
+                 [&](std::uint32_t i) { out.push_back(i); });
+        return out;
+    }
+
+    std::vector<std::uint32_t> within(const Box& q, double dist) const
+    {
+        std::vector<std::uint32_t> out;
+        traverse([&](const Box& b) { return Distance(b, q) <= dist; },
+                 [&](std::uint32_t i) { out.push_back(i); });
+        return out;
+    }
+
+    // Items whose box the ray enters, nearest first
+    std::vector<std::pair<std::uint32_t, double>> ray(const double origin[3], const double dir[3]) const
+    {
+        double inv[3];
+        for (int k=0; k<3; ++k) inv[k] = 1.0 / dir[k];
+
+        std::vector<std::pair<std::uint32_t, double>> out;
+        double t = 0.0;
+        traverse([&](const Box& b) { return RayHit(b, origin, inv, t); },
+                 [&](std::uint32_t i) { out.push_back({i, t}); });
+        std::sort(out.begin(), out.end(),
+                  [](const auto& a, const auto& b) { return a.second < b.second; });
+        return out;
+    }
+
+private:
+    bool inside(std::uint64_t offset, std::uint64_t bytes) const {
+        return offset <= m_size && bytes <= m_size - offset && offset % 8 == 0;
+    }
+
+    bool validate() const
+    {
+        if (!m_base || m_size < sizeof(FileHeader)) return false;
+        if (reinterpret_cast<std::uintptr_t>(m_base) % 8 != 0) return false;
+        const FileHeader& h = header();
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return false;
+        if (h.version != kVersion || h.headerSize != sizeof(FileHeader)) return false;
+        if (h.fileSize != m_size) return false;
+        if (!inside(h.nodesOffset, std::uint64_t(h.nodeCount) * sizeof(Node)) ||
+            !inside(h.itemsOffset, std::uint64_t(h.itemCount) * sizeof(Item)))
+        {
+            return false;
+        }
+
+        // Children point forward (so traversal terminates), leaves stay
+        // inside the item array
+        for (std::uint32_t n=0; n<h.nodeCount; ++n) {
+            const Node& nd = node(n);
+            if (nd.count > 0) {
+                if (nd.first > h.itemCount || nd.count > h.itemCount - nd.first) return false;
+            } else if (n + 1 >= h.nodeCount || nd.first <= n + 1 || nd.first >= h.nodeCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const unsigned char* m_base = nullptr;
+    std::size_t          m_size = 0;
+    bool                 m_ok   = false;
+};
+
+using AssemblyBinary::MappedFile;
+
+} // namespace AssemblyBvh
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <TDF_Label.hxx>
+#include <TDF_LabelSequence.hxx>
+#include <TopoDS_Shape.hxx>
+#include <Quantity_Color.hxx>
+#include <gp_Trsf.hxx>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class LabelResolver;
+
+// Flattened XCAF assembly, built in one pass over OCAF and queried by every
+// later stage instead of walking the document again.
+//
+// Nodes are occurrences in pre-order (a node's subtree is the index range
+// [n, subtreeEnd(n))), stored as parallel arrays. Each node points at a
+// label slot: one row per distinct TDF_Label holding what the exporters
+// look up (entry, name, effective color, shape), so repeated occurrences of
+// a sub-assembly share their data. def(n) is the slot of the definition
+// (the referred prototype of an instance, or the label itself).
+class AssemblyIndex {
+public:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+    // Free shapes in `roots`, expanded through every component
+    void build(const TDF_LabelSequence& roots, LabelResolver& labels);
+    void clear();
+
+    // ── Nodes ──────────────────────────────────────────────────────────
+    std::uint32_t size() const { return static_cast<std::uint32_t>(m_slot.size()); }
+    const std::vector<std::uint32_t>& roots() const { return m_roots; }
+
+    std::uint32_t slot(std::uint32_t n)        const { return m_slot[n]; }
+    std::uint32_t def(std::uint32_t n)         const { return m_def[n]; }
+    std::uint32_t parent(std::uint32_t n)      const { return m_parent[n]; }
+    std::uint32_t firstChild(std::uint32_t n)  const { return m_firstChild[n]; }
+    std::uint32_t nextSibling(std::uint32_t n) const { return m_nextSibling[n]; }
+    std::uint32_t subtreeEnd(std::uint32_t n)  const { return m_subtreeEnd[n]; }
+    std::uint32_t depth(std::uint32_t n)       const { return m_depth[n]; }
+
+    bool isInstance(std::uint32_t n)        const { return m_flags[n] & kInstance; }
+    bool hasIdentityLocal(std::uint32_t n)  const { return m_flags[n] & kIdentity; }
+    // First node (in pre-order) that refers to this node's label
+    bool isFirstOccurrence(std::uint32_t n) const { return m_flags[n] & kFirst; }
+
+    const gp_Trsf& local(std::uint32_t n) const { return m_local[n]; }   // instance placement
+    const gp_Trsf& world(std::uint32_t n) const { return m_world[n]; }   // accumulated from the root
+
+    // ── Label slots ────────────────────────────────────────────────────
+    std::uint32_t slotCount() const { return static_cast<std::uint32_t>(m_labels.size()); }
+
+    const TDF_Label&    label(std::uint32_t s) const { return m_labels[s]; }
+    const std::string&  entry(std::uint32_t s) const { return m_entries[s]; }   // "0:1:1:2"
+    const std::string&  path(std::uint32_t s)  const { return m_paths[s]; }     // "0-1-1-2"
+    bool                hasName(std::uint32_t s) const { return m_hasName[s]; }
+    const std::string&  name(std::uint32_t s)  const { return m_names[s]; }
+    bool                hasColor(std::uint32_t s) const { return m_hasColor[s]; }
+    const Quantity_Color& color(std::uint32_t s) const { return m_colors[s]; }
+    const TopoDS_Shape& shape(std::uint32_t s) const { return m_shapes[s]; }
+
+    const std::string& nameOr(std::uint32_t s, const std::string& fallback) const {
+        return m_hasName[s] ? m_names[s] : fallback;
+    }
+    RGBA colorRGBA(std::uint32_t s, const RGBA& defaultCol) const;
+
+    // ── Component selections used by the exporter ─────────────────────
+    // Direct components of each root, or the root itself if it has none
+    std::vector<std::uint32_t> shallowComponents() const;
+
+    // Every distinct component label below the roots, in the order of
+    // XCAFDoc_ShapeTool::GetComponents(deep): sub-components before the
+    // component that holds them. Falls back to the roots.
+    std::vector<std::uint32_t> leafComponents() const;
+
+private:
+    enum : std::uint8_t { kInstance = 1, kIdentity = 2, kFirst = 4 };
+
+    std::uint32_t internLabel(const TDF_Label& lab, LabelResolver& labels);
+
+    // Nodes
+    std::vector<std::uint32_t> m_slot, m_def, m_parent, m_firstChild,
+                               m_nextSibling, m_subtreeEnd, m_depth;
+    std::vector<std::uint8_t>  m_flags;
+    std::vector<gp_Trsf>       m_local, m_world;
+    std::vector<std::uint32_t> m_roots;
+
+    // Label slots
+    std::vector<TDF_Label>      m_labels;
+    std::vector<std::string>    m_entries, m_paths, m_names;
+    std::vector<std::uint8_t>   m_hasName, m_hasColor;
+    std::vector<Quantity_Color> m_colors;
+    std::vector<TopoDS_Shape>   m_shapes;
+    std::vector<std::uint32_t>  m_firstNode;
+    std::unordered_map<TDF_Label, std::uint32_t> m_slotOf;
+};
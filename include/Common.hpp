@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory_resource>
 #include <array>
 #include <cstdint>
 #include <cmath>
@@ -23,28 +24,83 @@ struct RGBA {
 };
 
 // Triangle bucket (per material)
+//
+// Arrays are std::pmr vectors so a bucket can be built in a MeshArena and
+// dropped in bulk. Copies always land on the default resource, which is
+// how arena-built buckets are promoted into long-lived caches.
 struct TriBucket {
-    std::vector<Vertex>   vertices;
-    std::vector<Normal>   normals;
-    std::vector<uint32_t> indices;
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    std::pmr::vector<Vertex>   vertices;
+    std::pmr::vector<Normal>   normals;
+    std::pmr::vector<uint32_t> indices;
     int materialIndex = -1;
+
+    TriBucket() = default;
+    explicit TriBucket(const allocator_type& a)
+        : vertices(a), normals(a), indices(a) {}
+    TriBucket(const TriBucket& o, const allocator_type& a)
+        : vertices(o.vertices, a), normals(o.normals, a), indices(o.indices, a),
+          materialIndex(o.materialIndex) {}
+    TriBucket(TriBucket&& o, const allocator_type& a)
+        : vertices(std::move(o.vertices), a), normals(std::move(o.normals), a),
+          indices(std::move(o.indices), a), materialIndex(o.materialIndex) {}
+    TriBucket(const TriBucket&) = default;
+    TriBucket(TriBucket&&) = default;
+    TriBucket& operator=(const TriBucket&) = default;
+    TriBucket& operator=(TriBucket&&) = default;
 };
 
 // Edge bucket (per material)
 struct EdgeBucket {
-    std::vector<Vertex>   vertices;
-    std::vector<uint32_t> indices;
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    std::pmr::vector<Vertex>   vertices;
+    std::pmr::vector<uint32_t> indices;
     int materialIndex = -1;
+
+    EdgeBucket() = default;
+    explicit EdgeBucket(const allocator_type& a)
+        : vertices(a), indices(a) {}
+    EdgeBucket(const EdgeBucket& o, const allocator_type& a)
+        : vertices(o.vertices, a), indices(o.indices, a),
+          materialIndex(o.materialIndex) {}
+    EdgeBucket(EdgeBucket&& o, const allocator_type& a)
+        : vertices(std::move(o.vertices), a), indices(std::move(o.indices), a),
+          materialIndex(o.materialIndex) {}
+    EdgeBucket(const EdgeBucket&) = default;
+    EdgeBucket(EdgeBucket&&) = default;
+    EdgeBucket& operator=(const EdgeBucket&) = default;
+    EdgeBucket& operator=(EdgeBucket&&) = default;
 };
 
+// Payload bytes held by a bucket (size, not capacity)
+inline std::size_t BucketBytes(const TriBucket& b) {
+    return b.vertices.size() * sizeof(Vertex)
+         + b.normals.size()  * sizeof(Normal)
+         + b.indices.size()  * sizeof(std::uint32_t);
+}
+
+inline std::size_t BucketBytes(const EdgeBucket& b) {
+    return b.vertices.size() * sizeof(Vertex)
+         + b.indices.size()  * sizeof(std::uint32_t);
+}
+
+template <typename Bucket>
+std::size_t BucketBytes(const std::vector<Bucket>& buckets) {
+    std::size_t n = 0;
+    for (const auto& b : buckets) n += BucketBytes(b);
+    return n;
+}
+
 // 4-byte padding helper
 inline std::size_t pad4(std::size_t n) {
     return (n + 3) & ~std::size_t(3);
 }
 
 // Min/max for glTF accessors (POSITION, NORMAL)
-template <typename Vec3>
-std::array<float, 6> calcMinMax(const std::vector<Vec3>& v, bool isNormal = false) {
+template <typename Vec3Array>
+std::array<float, 6> calcMinMax(const Vec3Array& v, bool isNormal = false) {
     if (v.empty()) {
         return {0,0,0,0,0,0};
     }
@@ -99,6 +155,19 @@ struct ExportStats {
     }
 };
 
+// How GlbBuilder lays out the binary payload
+enum class BufferLayout {
+    Single,   // one .glb, payload in its BIN chunk (4 GB cap)
+    Split,    // .glb holding only JSON, payload in external .bin files
+    Gltf      // .gltf text file, payload in external .bin files
+};
+
+// Who draws the PNG thumbnails
+enum class RenderBackend {
+    Occt,     // AIS/V3d over OpenGL (needs a display, Xvfb on Linux)
+    Cpu       // SoftRenderer over the extracted buckets
+};
+
 // Simple material registry: RGBA → index
 struct MaterialRegistry {
     std::map<std::uint32_t, int> lut;
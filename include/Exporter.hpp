@@ -1,5 +1,10 @@
 #pragma once
 
+#include "Common.hpp"
+#include "Thumbnail.hpp"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class Exporter {
@@ -12,6 +17,29 @@ private:
         std::string outDir;
         bool printStats = false;
         bool validate   = false;
+        std::string traceFile;
+        std::string reportFile;
+        std::size_t reportTop = 20;
+        std::size_t maxMemoryBytes = 0;   // 0 = unlimited
+        std::size_t cacheBytes     = 0;   // mesh cache budget, 0 = unbounded
+        std::string spillDir;             // out-of-core assembly buckets
+        bool lowMemory = false;
+        bool prettyJson = false;          // indented assembly.json
+        bool bvh = false;                 // assembly.bvh for `stepguru query`
+        BufferLayout  bufferLayout   = BufferLayout::Single;
+        std::uint64_t maxBufferBytes = 1ull << 30;   // per external .bin
+        std::size_t maxPartTriangles     = 0;   // per-component GLBs, 0 = full detail
+        std::size_t maxAssemblyTriangles = 0;   // assembly GLB, 0 = full detail
+        bool tiles = false;               // octree of GLB tiles + tileset.json
+        std::size_t tileMaxTriangles = 200000;
+        bool subassemblies = false;       // a GLB per intermediate assembly, from leaf meshes
+        bool sharedBin = false;           // one geometry.bin per job, outputs as .gltf referencing it
+        RenderBackend renderer = RenderBackend::Occt;
+        ThumbnailSpec thumbnails;         // views, sprite sheet, quality tier, size, format
+        bool asyncImages = true;          // encode/write thumbnails on a background thread
+        bool images = true;               // false: no thumbnails, render plugin never loaded
+        bool dedupGeometry = false;       // share outputs of identical, differently placed parts
+        double renderBudgetSec = 0.0;     // per view; slower images lower the tier, 0 = off
     };
 
     Options parseArgs(int argc, char* argv[]);
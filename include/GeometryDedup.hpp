@@ -0,0 +1,60 @@
+#pragma once
+
+#include <gp_Trsf.hxx>
+#include <TopoDS_Shape.hxx>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One definition whose geometry repeats an earlier one
+struct GeometryDuplicate {
+    std::string id;        // this definition (label path)
+    std::string sameAs;    // first definition with that geometry
+    gp_Trsf     motion;    // rigid motion taking sameAs onto id
+};
+
+// Finds definitions with identical geometry at different positions: the
+// copy-pasted bodies STEP files carry as separate definitions instead of
+// instances of one.
+//
+// Each shape gets a pose-invariant fingerprint (topology counts, faces per
+// surface type, intrinsic surface parameters such as radii and cone
+// angles, area, volume and principal moments of inertia). Shapes whose
+// fingerprints agree are aligned through their centroid and principal
+// axes (plus reference vertices where moments coincide, as for turned
+// parts), and the match is only confirmed when every vertex and face
+// sample of one lands on the other. Mirrored copies never confirm.
+class GeometryDedup {
+public:
+    GeometryDedup();
+    ~GeometryDedup();
+
+    GeometryDedup(const GeometryDedup&) = delete;
+    GeometryDedup& operator=(const GeometryDedup&) = delete;
+
+    // Register definition `id`. True when an earlier one of the same
+    // `group` (e.g. a color key) has the same geometry: `sameAs` names it
+    // and `motion` takes its shape onto `shape`.
+    bool add(const std::string& id, const TopoDS_Shape& shape, std::uint64_t group,
+             std::string& sameAs, gp_Trsf& motion);
+
+    std::size_t definitions() const { return m_definitions; }
+    std::size_t duplicates()  const { return m_duplicates; }
+    // Fingerprint matches that no rigid motion confirmed
+    std::size_t rejected()    const { return m_rejected; }
+
+private:
+    struct Entry;
+
+    std::vector<Entry>                                       m_entries;   // distinct geometries
+    std::unordered_map<std::uint64_t, std::vector<std::size_t>> m_buckets;  // group + topology hash → entries
+    std::size_t m_definitions = 0;
+    std::size_t m_duplicates  = 0;
+    std::size_t m_rejected    = 0;
+};
+
+// duplicates.json: for every duplicate, the definition whose outputs it
+// shares and the column-major 4x4 matrix that places those outputs
+bool WriteGeometryDuplicates(const std::string& file, const std::vector<GeometryDuplicate>& dups);
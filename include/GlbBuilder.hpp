@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Common.hpp"
+#include "SpillStore.hpp"
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -8,18 +11,56 @@ class GlbBuilder {
 public:
     GlbBuilder() = default;
 
-    // Append buckets + materials (can be called multiple times)
+    // Append buckets + materials (can be called multiple times).
+    // The buckets are referenced, not copied: they must outlive writeGlb().
     void addBuckets(const std::vector<TriBucket>& tris,
                     const std::vector<EdgeBucket>& edges,
                     const std::vector<RGBA>& materials);
 
+    // Same, but takes ownership of the bucket data
+    void addBuckets(std::vector<TriBucket>&&  tris,
+                    std::vector<EdgeBucket>&& edges,
+                    const std::vector<RGBA>&  materials);
+
+    // Out-of-core buckets; the store must outlive writeGlb(). Their arrays
+    // are streamed from the spill files into the BIN chunk.
+    void addSpilled(const SpillBucketStore& store,
+                    const std::vector<RGBA>& materials);
+
+    // Payload layout. Split and Gltf cap each external .bin at maxBufferBytes
+    // (a bucket larger than that still gets a buffer of its own).
+    void setBufferLayout(BufferLayout layout,
+                         std::uint64_t maxBufferBytes = kDefaultMaxBufferBytes);
+
     // Build and write GLB. Fills outStats and prints stats if requested.
+    // Split writes <stem>_N.bin next to filename; Gltf writes <stem>.gltf
+    // instead of filename, plus the same .bin files. Single falls back to
+    // Split when the GLB would exceed the 4 GB container limit.
     bool writeGlb(const std::string& filename,
                   bool printStats,
                   ExportStats& outStats);
 
+    static constexpr std::uint64_t kDefaultMaxBufferBytes = 1ull << 30;
+
 private:
-    std::vector<TriBucket> m_triBuckets;
-    std::vector<EdgeBucket> m_edgeBuckets;
+    template <typename Bucket>
+    struct BucketRef {
+        const Bucket* bucket;
+        int           materialIndex;   // already offset into m_materials
+    };
+
+    std::vector<BucketRef<TriBucket>>  m_triBuckets;
+    std::vector<BucketRef<EdgeBucket>> m_edgeBuckets;
+    std::deque<TriBucket>  m_ownedTris;    // storage for moved-in buckets
+    std::deque<EdgeBucket> m_ownedEdges;
     std::vector<RGBA>      m_materials;
+
+    struct SpillRef {
+        const SpillBucketStore* store;
+        int                     matBase;
+    };
+    std::vector<SpillRef>  m_spilled;
+
+    BufferLayout  m_layout         = BufferLayout::Single;
+    std::uint64_t m_maxBufferBytes = kDefaultMaxBufferBytes;
 };
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// glTF elements referenced from the GLB JSON chunk
+namespace Gltf {
+
+enum class AccessorType : std::uint8_t { Scalar, Vec3 };
+
+// uri empty for the GLB-stored BIN chunk
+struct Buffer {
+    std::uint64_t byteLength;
+    std::string   uri;
+};
+
+struct BufferView {
+    std::uint32_t buffer;
+    std::uint64_t byteOffset;
+    std::uint64_t byteLength;
+    int           target;
+};
+
+struct Accessor {
+    int                 bufferView;
+    int                 componentType;
+    std::uint32_t       count;
+    AccessorType        type;
+    std::array<float,6> bounds;   // min xyz, max xyz
+    bool                hasBounds;
+};
+
+struct Primitive {
+    int posAcc;
+    int nrmAcc;     // -1 for none
+    int idxAcc;
+    int material;
+    int mode;       // 4 = TRIANGLES, 1 = LINES
+};
+
+// Placed mesh; matrix is column-major and only written when hasMatrix
+struct Node {
+    int                   mesh;
+    std::array<double,16> matrix;
+    bool                  hasMatrix;
+};
+
+} // namespace Gltf
+
+// Appends the GLB JSON chunk to one preallocated string. Numbers go through
+// std::to_chars (locale-independent, floats in shortest round-trip form),
+// so nothing is formatted through iostreams.
+class GltfJsonWriter {
+public:
+    explicit GltfJsonWriter(std::size_t reserveBytes = 0) { m_out.reserve(reserveBytes); }
+
+    // Upper-bound-ish chunk size for the given element counts
+    static std::size_t EstimateBytes(std::size_t materials, std::size_t primitives,
+                                     std::size_t bufferViews, std::size_t accessors);
+
+    // Single-mesh scene: asset, scene, node, materials, mesh, buffers,
+    // bufferViews and accessors, in that order
+    void writeScene(const std::vector<RGBA>&            materials,
+                    const std::vector<Gltf::Primitive>&  primitives,
+                    const std::vector<Gltf::Buffer>&     buffers,
+                    const std::vector<Gltf::BufferView>& bufferViews,
+                    const std::vector<Gltf::Accessor>&   accessors);
+
+    // Several meshes, each placed by one or more nodes that the scene
+    // lists flat; same element order as writeScene
+    void writeInstancedScene(const std::vector<RGBA>&                          materials,
+                             const std::vector<std::vector<Gltf::Primitive>>&  meshes,
+                             const std::vector<Gltf::Node>&                    nodes,
+                             const std::vector<Gltf::Buffer>&                  buffers,
+                             const std::vector<Gltf::BufferView>&              bufferViews,
+                             const std::vector<Gltf::Accessor>&                accessors);
+
+    // One array element each, without separator or newline
+    void material(const RGBA& m);
+    void primitive(const Gltf::Primitive& p);
+    void buffer(const Gltf::Buffer& b);
+    void bufferView(const Gltf::BufferView& bv);
+    void accessor(const Gltf::Accessor& a);
+    void node(const Gltf::Node& n);
+
+    GltfJsonWriter& operator<<(std::string_view s) { m_out.append(s); return *this; }
+    GltfJsonWriter& operator<<(const char* s)      { m_out.append(s); return *this; }
+    GltfJsonWriter& operator<<(char c)             { m_out.push_back(c); return *this; }
+    GltfJsonWriter& operator<<(float v)            { return number(v); }
+    GltfJsonWriter& operator<<(double v)           { return number(v); }
+
+    template <std::integral T>
+        requires (!std::same_as<T, char> && !std::same_as<T, bool>)
+    GltfJsonWriter& operator<<(T v) { return number(v); }
+
+    // Quoted, JSON-escaped
+    GltfJsonWriter& quoted(std::string_view s);
+
+    std::string&       str()       { return m_out; }
+    const std::string& str() const { return m_out; }
+
+private:
+    // Pieces shared by writeScene and writeInstancedScene
+    void head(std::size_t nodeCount);
+    void materialList(const std::vector<RGBA>& materials);
+    void mesh(const std::vector<Gltf::Primitive>& primitives, bool last);
+    void tail(const std::vector<Gltf::Buffer>&     buffers,
+              const std::vector<Gltf::BufferView>& bufferViews,
+              const std::vector<Gltf::Accessor>&   accessors);
+
+    // Comma-separated, one element per line
+    template <typename T, typename F>
+    void list(const std::vector<T>& items, F&& writeItem)
+    {
+        for (std::size_t i=0; i<items.size(); ++i) {
+            writeItem(items[i]);
+            if (i + 1 < items.size()) *this << ',';
+            *this << '\n';
+        }
+    }
+
+    template <typename T>
+    GltfJsonWriter& number(T v)
+    {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        m_out.append(buf, res.ptr);
+        return *this;
+    }
+
+    std::string m_out;
+};
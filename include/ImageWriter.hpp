@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 8-bit RGB raster, rows top to bottom
+struct RgbImage {
+    int width  = 0;
+    int height = 0;
+    std::vector<std::uint8_t> pixels;   // width * height * 3
+
+    RgbImage() = default;
+    RgbImage(int w, int h, std::uint8_t fill = 255)
+        : width(w), height(h),
+          pixels(static_cast<std::size_t>(w) * static_cast<std::size_t>(h) * 3, fill) {}
+};
+
+enum class ImageFormat {
+    Png,
+    Qoi,      // https://qoiformat.org — very fast, ~PNG size on flat images
+    Webp      // lossless (VP8L)
+};
+
+// Deflate effort of the PNG encoder
+enum class PngEffort {
+    Fast,     // "up" filter, one match probe per position (fpng-style)
+    Default,  // per-row filter choice, 32 probes
+    Best      // per-row filter choice, 256 probes, lazy matching
+};
+
+struct ImageEncodeOptions {
+    ImageFormat format = ImageFormat::Png;
+    PngEffort   effort = PngEffort::Default;
+};
+
+// ".png", ".qoi" or ".webp"
+const char* ImageExtension(ImageFormat format);
+
+// Self-contained encoders (no zlib, libpng or libwebp): PNG with adaptive
+// row filters and dynamic-Huffman deflate, QOI, and lossless WebP whose
+// matcher only looks at the previous pixel and the pixel above — which is
+// where the long runs of a rendered thumbnail are.
+std::vector<std::uint8_t> EncodeImage(const RgbImage& image, const ImageEncodeOptions& opt);
+
+bool WriteImage(const RgbImage& image, const std::string& file, const ImageEncodeOptions& opt);
+
+// PNG at default effort
+std::vector<std::uint8_t> EncodePNG(const RgbImage& image);
+bool WritePNG(const RgbImage& image, const std::string& pngFile);
+
+// Encodes and writes images on one background thread, so the caller can
+// render the next one meanwhile. At most `maxPending` images wait in the
+// queue; submit() blocks beyond that, which bounds the memory held.
+class AsyncImageWriter {
+public:
+    explicit AsyncImageWriter(std::size_t maxPending = 4);
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    void submit(RgbImage image, std::string file, const ImageEncodeOptions& opt);
+
+    // Wait until everything submitted so far is on disk; false if any
+    // write failed since the previous flush()
+    bool flush();
+
+    std::uint64_t bytesWritten() const;
+
+private:
+    struct Job {
+        RgbImage           image;
+        std::string        file;
+        ImageEncodeOptions opt;
+    };
+
+    void run();
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_wake;     // worker: job queued or stopping
+    std::condition_variable m_done;     // producers: room in the queue / idle
+    std::deque<Job>         m_queue;
+    std::size_t             m_maxPending;
+    bool                    m_busy     = false;
+    bool                    m_stop     = false;
+    std::size_t             m_failures = 0;
+    std::uint64_t           m_bytes    = 0;
+    std::thread             m_thread;
+};
+
+// Write `image` now, or hand it to `async` when one is given
+bool StoreImage(RgbImage&& image, const std::string& file,
+                const ImageEncodeOptions& opt, AsyncImageWriter* async);
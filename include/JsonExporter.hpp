@@ -1,17 +1,30 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <TDF_Label.hxx>
 #include <XCAFDoc_ShapeTool.hxx>
 #include <XCAFDoc_ColorTool.hxx>
 
+class AssemblyIndex;
+
 /// High-level JSON exporter: produces a full assembly definition+instance JSON.
+/// The file is streamed (definitions first, then the instance tree), compact
+/// unless `pretty` is set.
 namespace JsonExporter {
 
     bool Export(
         const TDF_Label& rootLabel,
         const Handle(XCAFDoc_ShapeTool)& shapeTool,
         const Handle(XCAFDoc_ColorTool)& colorTool,
-        const std::string& outputJson);
+        const std::string& outputJson,
+        bool pretty = false);
+
+    // Same, from a prebuilt index; rootNode is one of index.roots()
+    bool Export(
+        const AssemblyIndex& index,
+        std::uint32_t rootNode,
+        const std::string& outputJson,
+        bool pretty = false);
 
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <TDF_Label.hxx>
+#include <Quantity_Color.hxx>
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Everything the exporters look up per label, resolved once.
+struct LabelInfo {
+    bool           hasColor = false;
+    Quantity_Color color;           // effective XDE color (see GetEffectiveColor)
+    bool           hasName  = false;
+    std::string    name;            // TDataStd_Name as ASCII
+    TDF_Label      referred;        // prototype of an instance, null otherwise
+};
+
+// Per-document memo of effective color, name and referred label, keyed by
+// TDF_Label (std::hash<TDF_Label> needs OCCT 7.8+). Lookups may run from
+// several threads: hits take a shared lock, misses resolve outside the lock
+// and the first insert wins. Entries are never erased, so returned
+// references stay valid for the resolver's lifetime.
+class LabelResolver {
+public:
+    LabelResolver(const Handle(XCAFDoc_ShapeTool)& shapeTool,
+                  const Handle(XCAFDoc_ColorTool)& colorTool)
+        : m_shapeTool(shapeTool), m_colorTool(colorTool) {}
+
+    LabelResolver(const LabelResolver&) = delete;
+    LabelResolver& operator=(const LabelResolver&) = delete;
+
+    const LabelInfo& info(const TDF_Label& label);
+
+    bool color(const TDF_Label& label, Quantity_Color& out);
+    RGBA colorRGBA(const TDF_Label& label, const RGBA& defaultCol);
+    std::string name(const TDF_Label& label, const std::string& fallback = "Unnamed");
+
+    // Same contract as XCAFDoc_ShapeTool::GetReferredShape
+    bool referred(const TDF_Label& label, TDF_Label& out);
+
+    const Handle(XCAFDoc_ShapeTool)& shapeTool() const { return m_shapeTool; }
+    const Handle(XCAFDoc_ColorTool)& colorTool() const { return m_colorTool; }
+
+    std::size_t size() const;
+    std::size_t hits()   const { return m_hits.load(std::memory_order_relaxed); }
+    std::size_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    Handle(XCAFDoc_ShapeTool) m_shapeTool;
+    Handle(XCAFDoc_ColorTool) m_colorTool;
+
+    mutable std::shared_mutex                 m_mutex;
+    std::unordered_map<TDF_Label, LabelInfo>  m_cache;
+    std::atomic<std::size_t>                  m_hits{0};
+    std::atomic<std::size_t>                  m_misses{0};
+};
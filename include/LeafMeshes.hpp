@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MeshArena.hpp"
+#include "MeshCache.hpp"
+
+#include <gp_Trsf.hxx>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AssemblyIndex;
+
+// Leaf occurrence resolved to the cached mesh that draws it
+struct LeafRef {
+    std::string   key;      // cache key: definition path + packed color
+    std::uint32_t def;      // slot of the definition whose shape is meshed
+    RGBA          color;
+    gp_Trsf       motion;   // places that mesh in the occurrence's definition frame
+};
+
+// Definition-space meshes of the leaf occurrences, one per definition and
+// effective color, shared by the passes that place leaves. A definition is
+// meshed the first time any pass draws it and reused by the others; only
+// an eviction under a --cache-mb budget makes it mesh again. Definitions
+// registered as duplicates are drawn from the mesh of the one they repeat.
+class LeafMeshes {
+public:
+    LeafMeshes(const AssemblyIndex& index, std::size_t cacheBytes);
+
+    // Occurrences drawn from a mesh: no components, non-null definition shape
+    bool isLeaf(std::uint32_t n) const;
+
+    LeafRef ref(std::uint32_t n) const;
+
+    // Draw definition `dup` from the mesh of `sameAs`, moved by `motion`
+    // (which takes the sameAs shape onto the dup shape)
+    void setDuplicate(std::uint32_t dup, std::uint32_t sameAs, const gp_Trsf& motion);
+
+    // Cached mesh for `ref`, extracted on a miss. Valid until the next call.
+    const CachedMesh& mesh(const LeafRef& ref);
+    const CachedMesh& mesh(std::uint32_t n) { return mesh(ref(n)); }
+
+    // Append every leaf occurrence m of n's subtree (n itself if it is a
+    // leaf), moved by fromWorld * world(m) * motion. Returns the placements
+    // added.
+    std::size_t compose(std::uint32_t            n,
+                        const gp_Trsf&           fromWorld,
+                        MaterialRegistry&        reg,
+                        std::vector<TriBucket>&  tris,
+                        std::vector<EdgeBucket>& edges);
+
+    void clear() { m_cache.clear(); }
+
+    std::size_t extracted() const { return m_extracted; }
+    const MeshCache& cache() const { return m_cache; }
+
+private:
+    const AssemblyIndex& m_index;
+    MeshCache            m_cache;
+    MeshArena            m_arena;
+    std::size_t          m_extracted = 0;
+
+    std::unordered_map<std::uint32_t, std::pair<std::uint32_t, gp_Trsf>> m_sameAs;   // dup def → (def, motion)
+};
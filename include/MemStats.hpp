@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Resident set size of this process (bytes), 0 if unavailable.
+std::size_t CurrentRSS();
+std::size_t PeakRSS();
+
+// Give freed heap pages back to the OS where the allocator supports it.
+void ReleaseFreeHeap();
+
+// RSS snapshot at a phase boundary, plus bytes we account for ourselves
+// (mesh buckets, caches, GLB buffers).
+struct MemSample {
+    std::string phase;
+    std::size_t rssBytes     = 0;
+    std::size_t peakRssBytes = 0;
+    std::size_t trackedBytes = 0;
+};
+
+class MemoryTracker {
+public:
+    // Record current/peak RSS for `phase` (also emitted as trace counters).
+    void sample(const std::string& phase, std::size_t trackedBytes = 0);
+
+    // Soft limit in bytes (0 = none); see overLimit().
+    void        setLimit(std::size_t bytes) { m_limit = bytes; }
+    std::size_t limit() const { return m_limit; }
+    bool        overLimit() const { return m_limit != 0 && CurrentRSS() > m_limit; }
+
+    const std::vector<MemSample>& samples() const { return m_samples; }
+    void print() const;
+
+private:
+    std::vector<MemSample> m_samples;
+    std::size_t            m_limit = 0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Per-job bump allocator for mesh extraction buffers.
+//
+// Nothing is freed individually: reset() drops every allocation at once
+// and hands the blocks back to a per-thread pool, so the next job on the
+// same thread reuses them without touching the global heap. Anything that
+// must outlive the job is copied out first (bucket copies go to the
+// default resource, see TriBucket).
+class MeshArena {
+public:
+    explicit MeshArena(std::size_t initialBytes = std::size_t(1) << 20)
+        : m_arena(initialBytes, ThreadPool()) {}
+
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &m_arena; }
+
+    void reset() { m_arena.release(); }
+
+    // Unsynchronized pool owned by the calling thread
+    static std::pmr::memory_resource* ThreadPool();
+
+private:
+    std::pmr::monotonic_buffer_resource m_arena;
+};
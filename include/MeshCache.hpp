@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Extracted mesh of one definition, reused by every instance of it.
+struct CachedMesh {
+    std::vector<TriBucket>  triBuckets;
+    std::vector<EdgeBucket> edgeBuckets;
+    std::vector<RGBA>       materials;
+
+    std::size_t bytes() const {
+        return BucketBytes(triBuckets) + BucketBytes(edgeBuckets)
+             + materials.size() * sizeof(RGBA);
+    }
+};
+
+// Mesh cache keyed by label path, optionally bounded by payload bytes with
+// least-recently-used eviction. maxBytes == 0 means unbounded.
+class MeshCache {
+public:
+    explicit MeshCache(std::size_t maxBytes = 0) : m_maxBytes(maxBytes) {}
+
+    // nullptr on miss; a hit becomes most recently used
+    const CachedMesh* find(const std::string& key);
+
+    // Store (or replace) `mesh`, evicting older entries to fit the budget.
+    // The newest entry is always kept, even if it alone exceeds the budget.
+    const CachedMesh& insert(const std::string& key, CachedMesh mesh);
+
+    void clear();
+
+    std::size_t size()      const { return m_index.size(); }
+    std::size_t bytes()     const { return m_bytes; }
+    std::size_t maxBytes()  const { return m_maxBytes; }
+    std::size_t evictions() const { return m_evictions; }
+
+private:
+    using Entry = std::pair<std::string, CachedMesh>;
+
+    std::list<Entry>                                          m_lru;   // front = newest
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    std::size_t m_maxBytes  = 0;
+    std::size_t m_bytes     = 0;
+    std::size_t m_evictions = 0;
+};
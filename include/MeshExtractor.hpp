@@ -3,11 +3,26 @@
 #include "Common.hpp"
 
 #include <TopoDS_Shape.hxx>
+#include <gp_Trsf.hxx>
 
 // Triangulate a shape + extract edges, accumulating into
 // triBuckets / edgeBuckets using MaterialRegistry for colors.
+// New buckets and per-face scratch are allocated from `mem` (e.g. a
+// MeshArena); existing buckets keep their own allocator.
 void MeshShape(const TopoDS_Shape& root,
                const RGBA&          shapeColor,
                MaterialRegistry&    matReg,
                std::vector<TriBucket>& triBuckets,
-               std::vector<EdgeBucket>& edgeBuckets);
+               std::vector<EdgeBucket>& edgeBuckets,
+               std::pmr::memory_resource* mem = std::pmr::get_default_resource());
+
+// Append already extracted buckets, moved by `trsf` (positions and normals;
+// mirroring transforms also flip the triangle winding). Source materials
+// are re-registered in matReg, so meshes with different palettes merge.
+void AppendTransformed(const std::vector<TriBucket>&  srcTris,
+                       const std::vector<EdgeBucket>& srcEdges,
+                       const std::vector<RGBA>&       srcMaterials,
+                       const gp_Trsf&                 trsf,
+                       MaterialRegistry&              matReg,
+                       std::vector<TriBucket>&        triBuckets,
+                       std::vector<EdgeBucket>&       edgeBuckets);
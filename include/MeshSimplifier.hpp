@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <vector>
+
+struct SimplifyStats {
+    std::size_t trianglesIn  = 0;
+    std::size_t trianglesOut = 0;
+    double      maxError     = 0.0;   // worst collapse, RMS distance to the merged planes
+
+    void add(const SimplifyStats& o) {
+        trianglesIn  += o.trianglesIn;
+        trianglesOut += o.trianglesOut;
+        if (o.maxError > maxError) maxError = o.maxError;
+    }
+};
+
+// Quadric error edge-collapse decimation (Garland-Heckbert) of one bucket.
+//
+// Faces are extracted with their own vertices, so the bucket is first
+// welded by position. Collapses move a vertex onto a neighbour (no new
+// positions), never move boundary or non-manifold vertices - which keeps
+// the outline against other materials and open edges intact - and are
+// rejected if they would flip or sharply tilt a triangle. A collapse must
+// also pass the link condition (the two ends share no neighbour besides
+// the apexes of their common faces), so a closed mesh stays closed and
+// 2-manifold; vertices that still end up on an open edge are locked from
+// then on. Normals are
+// rebuilt from the remaining faces, split at creases sharper than 45°.
+// The bucket keeps its allocator and material.
+SimplifyStats SimplifyBucket(TriBucket& bucket, std::size_t targetTriangles);
+
+// Budget for a whole set (one part or one assembly): every bucket keeps
+// the same share of its triangles.
+SimplifyStats SimplifyBuckets(std::vector<TriBucket>& buckets, std::size_t targetTriangles);
@@ -1,12 +1,68 @@
 #pragma once
 
 #include "Common.hpp"
+#include "Thumbnail.hpp"
 
 #include <TopoDS_Shape.hxx>
+#include <memory>
 #include <string>
 #include <vector>
 
-// Render shapes + per-shape RGBA colors to a PNG file using OCCT AIS/V3d.
+class RenderPluginSession;
+
+// OCCT offscreen renderer that keeps its display connection, graphic
+// driver, viewer, context, virtual window, view and framebuffer alive
+// between images. The first render() loads the render plugin and sets
+// everything up; later calls only swap the displayed shapes, re-fit the
+// camera and read back. A failed render drops the state so the next
+// call starts clean. Without the plugin every render fails.
+class RenderSession {
+public:
+    RenderSession();
+    ~RenderSession();
+
+    RenderSession(const RenderSession&) = delete;
+    RenderSession& operator=(const RenderSession&) = delete;
+
+    // Render shapes + per-shape RGBA colors to an image file (spec.encode).
+    // OCCT builds its own presentation mesh and boundary lines for every
+    // shape.
+    bool render(const std::vector<TopoDS_Shape>& shapes,
+                const std::vector<RGBA>&         colors,
+                const std::string&               pngFile,
+                const ThumbnailSpec&             spec = {});
+
+    // Render buckets MeshShape already produced, submitted as triangle and
+    // segment primitive arrays: nothing is tessellated a second time
+    bool renderBuckets(const std::vector<TriBucket>&  tris,
+                       const std::vector<EdgeBucket>& edges,
+                       const std::vector<RGBA>&       materials,
+                       const std::string&             pngFile,
+                       const ThumbnailSpec&           spec = {});
+
+    // Views of one spec share the displayed scene: each extra view (or
+    // sprite sheet cell) costs one camera move and one draw
+    std::size_t imagesRendered() const;
+
+    // Encode and write images on `writer`'s thread instead of the render
+    // thread (nullptr: write before returning). The writer must outlive
+    // the renders that use it.
+    void setImageWriter(AsyncImageWriter* writer);
+
+    // Whether libstepguru_render can be loaded: $STEPGURU_RENDER_PLUGIN,
+    // then next to the executable, then the loader's search path. The
+    // first call loads it; the library stays loaded for the process.
+    static bool available();
+
+private:
+    // Session in the plugin, created by the first render
+    bool load();
+
+    std::unique_ptr<RenderPluginSession> m_impl;
+    AsyncImageWriter*                    m_writer = nullptr;
+};
+
+// One-off image through a temporary session (pays the full setup)
 bool RenderPNG(const std::vector<TopoDS_Shape>& shapes,
                const std::vector<RGBA>&         colors,
                const std::string&               pngFile);
@@ -0,0 +1,6 @@
+#pragma once
+
+// `stepguru query DIR ...`: box, ray and proximity queries against the
+// assembly.bvh / assembly.bin pair written by an earlier export, without
+// touching the STEP file. argv[0] is "query".
+int RunQuery(int argc, char* argv[]);
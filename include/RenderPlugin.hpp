@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ImageWriter.hpp"
+#include "Thumbnail.hpp"
+
+#include <TopoDS_Shape.hxx>
+#include <string>
+#include <vector>
+
+// Boundary between the converter and the OCCT/OpenGL thumbnail renderer.
+// The renderer is built as its own shared object (libstepguru_render) and
+// loaded with dlopen by the first RenderSession that draws, so runs that
+// write no OCCT thumbnail never map TKOpenGl, GLU or libGL. The plugin
+// resolves Trace and the image writer from the executable, and both
+// sides come from this header and the same Makefile; the ABI number
+// catches a stale plugin next to a newer binary.
+constexpr int kRenderPluginAbi = 1;
+
+// Factory the plugin exports with C linkage
+constexpr const char* kRenderPluginEntry = "stepguru_create_render_session";
+
+// See RenderSession for the meaning of every call
+class RenderPluginSession {
+public:
+    virtual ~RenderPluginSession() = default;
+
+    virtual bool render(const std::vector<TopoDS_Shape>& shapes,
+                        const std::vector<RGBA>&         colors,
+                        const std::string&               pngFile,
+                        const ThumbnailSpec&             spec) = 0;
+
+    virtual bool renderBuckets(const std::vector<TriBucket>&  tris,
+                               const std::vector<EdgeBucket>& edges,
+                               const std::vector<RGBA>&       materials,
+                               const std::string&             pngFile,
+                               const ThumbnailSpec&           spec) = 0;
+
+    virtual std::size_t imagesRendered() const = 0;
+    virtual void setImageWriter(AsyncImageWriter* writer) = 0;
+};
+
+using CreateRenderSessionFn = RenderPluginSession* (*)(int abi);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemStats.hpp"
+
+#include <TopoDS_Shape.hxx>
+
+// Per-definition cost record for the machine-readable run report.
+struct ComponentCost {
+    std::string id;          // label path ("0-1-1-2")
+    std::string name;
+    std::string kind = "part";
+    std::size_t instances = 0;
+    std::string sameAs;      // geometry duplicate of this definition (outputs shared)
+
+    // Meshing
+    double      meshSec      = 0.0;
+    std::size_t triangles    = 0;
+    std::size_t vertices     = 0;
+    std::size_t edgeSegments = 0;
+    std::size_t sourceTriangles = 0;   // before simplification, 0 if not simplified
+    double      simplifyError   = 0.0; // worst collapse error, model units
+
+    // Outputs. Seconds add up over every instance that writes them; bytes
+    // are the size of the one file all instances write (the last write wins)
+    double         glbSec  = 0.0;
+    double         pngSec  = 0.0;
+    double         stepSec = 0.0;
+    std::uintmax_t glbBytes  = 0;
+    std::uintmax_t pngBytes  = 0;
+    std::uintmax_t stepBytes = 0;
+
+    // BRep
+    std::size_t faces = 0;
+    std::map<std::string, std::size_t> surfaceTypes;
+
+    double totalSec() const { return meshSec + glbSec + pngSec + stepSec; }
+};
+
+// Collects ComponentCost entries (in first-seen order) and writes them
+// as JSON, followed by aggregates and the top-N most expensive parts.
+class CostReport {
+public:
+    ComponentCost& entry(const std::string& id);
+    bool has(const std::string& id) const { return m_lookup.count(id) != 0; }
+
+    void setMemory(const std::vector<MemSample>& samples) { m_memory = samples; }
+
+    bool writeJson(const std::string& filename, std::size_t topN) const;
+
+private:
+    std::vector<ComponentCost>              m_entries;
+    std::unordered_map<std::string, size_t> m_lookup;
+    std::vector<MemSample>                  m_memory;
+};
+
+// Count faces and their surface types (PLANE, CYLINDER, BSPLINE, ...).
+void CollectFaceStats(const TopoDS_Shape& shape, ComponentCost& out);
+
+// Size of a written file, 0 if missing.
+std::uintmax_t FileSizeOrZero(const std::string& filename);
+
+// Adds the scope's elapsed wall time (seconds) to `target`.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double& target)
+        : m_target(target), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        m_target += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    double& m_target;
+    std::chrono::steady_clock::time_point m_start;
+};
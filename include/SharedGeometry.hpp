@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LeafMeshes.hpp"
+#include "MeshCache.hpp"
+
+#include <gp_Trsf.hxx>
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Byte range of one array in the shared buffer
+struct SharedArray {
+    std::uint64_t offset = 0;
+    std::uint64_t bytes  = 0;
+};
+
+struct SharedPrimitive {
+    SharedArray         positions, normals, indices;   // normals empty for lines
+    std::uint32_t       vertexCount = 0;
+    std::uint32_t       indexCount  = 0;
+    std::array<float,6> bounds{};
+    std::array<float,6> normalBounds{};                 // exact, for the NORMAL accessor
+    RGBA                color{};
+    int                 mode = 4;                       // 4 = TRIANGLES, 1 = LINES
+};
+
+// A mesh placed in a document; trsf moves it from definition space
+struct SharedPlacement {
+    std::uint32_t mesh;
+    gp_Trsf       trsf;
+};
+
+// One .bin per job holding every definition's mesh once, and the .gltf
+// documents (assembly, parts, sub-assemblies) that place those meshes by
+// reference instead of embedding their own copies. Meshes are appended as
+// they are extracted; documents are only written by finish(), once the
+// buffer length every document declares is final. All arrays are 4-byte
+// types, so every range stays 4-byte aligned without padding.
+class SharedGeometryBuffer {
+public:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+    explicit SharedGeometryBuffer(std::string binFile);
+
+    SharedGeometryBuffer(const SharedGeometryBuffer&) = delete;
+    SharedGeometryBuffer& operator=(const SharedGeometryBuffer&) = delete;
+
+    bool ok() const { return m_ok; }
+
+    // Mesh id stored under `key`, or kNone
+    std::uint32_t find(const std::string& key) const;
+
+    // Append `mesh` under `key` (an existing key returns its id unchanged)
+    std::uint32_t add(const std::string& key, const CachedMesh& mesh);
+
+    // Id of the leaf mesh `ref`, taken from `meshes` and appended the
+    // first time it is asked for
+    std::uint32_t store(LeafMeshes& meshes, const LeafRef& ref);
+
+    // Read a stored mesh back into buckets (for thumbnails)
+    bool load(std::uint32_t mesh, CachedMesh& out);
+
+    // Queue a .gltf placing stored meshes; written by finish()
+    void addDocument(const std::string& gltfFile, std::vector<SharedPlacement> placements);
+
+    // Close the buffer and write every queued document. False if the
+    // buffer or any document could not be written.
+    bool finish();
+
+    const std::string& binFile() const { return m_binFile; }
+    std::uint64_t bytes()     const { return m_bytes; }
+    std::size_t   meshes()    const { return m_meshes.size(); }
+    std::size_t   documents() const { return m_documents.size(); }
+
+private:
+    struct Document {
+        std::string                  file;
+        std::vector<SharedPlacement> placements;
+    };
+
+    bool writeDocument(const Document& doc) const;
+
+    std::string   m_binFile;
+    std::ofstream m_out;
+    std::uint64_t m_bytes = 0;
+    bool          m_ok    = true;
+
+    std::vector<std::vector<SharedPrimitive>>      m_meshes;
+    std::unordered_map<std::string, std::uint32_t> m_ids;
+    std::vector<Document>                          m_documents;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ImageWriter.hpp"
+#include "Thumbnail.hpp"
+
+#include <string>
+#include <vector>
+
+enum class SoftShading {
+    Flat,      // one Lambert term per triangle, from its face normal
+    Lambert    // Lambert at the extracted vertex normals, interpolated
+};
+
+struct SoftRenderOptions {
+    int         width       = 512;
+    int         height      = 512;
+    int         supersample = 3;      // SSAA factor per axis, box-filtered down
+    SoftShading shading     = SoftShading::Lambert;
+    RenderView  view        = RenderView::Iso;
+    bool        edges       = true;   // draw the edge buckets over the faces
+    unsigned    threads     = 0;      // 0 = hardware concurrency
+};
+
+// Supersampling factor of a quality tier
+int SupersampleFor(RenderQuality quality);
+
+// Multithreaded software rasterizer for the buckets MeshShape produced:
+// same cameras (orthographic, RenderView directions, fit to the bounds), white
+// background, gray for uncolored parts and contrasting edge colors as
+// RenderPNG, but no OpenGL context and no X server. The supersampled
+// frame is split into horizontal bands that threads rasterize
+// independently after one binning pass.
+RgbImage RenderBuckets(const std::vector<TriBucket>&  tris,
+                       const std::vector<EdgeBucket>& edges,
+                       const std::vector<RGBA>&       materials,
+                       const SoftRenderOptions&       opt = {});
+
+// Every view of `spec`, written to ThumbnailFiles(pngFile, spec) in
+// spec.encode's format; handed to `async` instead when one is given
+bool RenderBucketsPNG(const std::vector<TriBucket>&  tris,
+                      const std::vector<EdgeBucket>& edges,
+                      const std::vector<RGBA>&       materials,
+                      const std::string&             pngFile,
+                      const ThumbnailSpec&           spec  = {},
+                      AsyncImageWriter*              async = nullptr);
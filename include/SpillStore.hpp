@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Append-only byte stream backed by an unlinked temporary file. Writes go
+// through a memory-mapped window that advances in fixed-size chunks, so
+// resident memory stays at about one chunk regardless of the stream size.
+class SpillFile {
+public:
+    explicit SpillFile(const std::string& dir,
+                       std::size_t chunkBytes = std::size_t(64) << 20);
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    // Returns the offset the data was written at
+    std::size_t append(const void* data, std::size_t bytes);
+    std::size_t size() const { return m_size; }
+
+    // Stream bytes [offset, offset + bytes) to `out`, one mapped chunk at a time
+    bool copyTo(std::ostream& out, std::size_t offset, std::size_t bytes) const;
+    bool copyTo(std::ostream& out) const { return copyTo(out, 0, m_size); }
+
+private:
+    void mapWindow(std::size_t offset);
+    void unmapWindow();
+
+    int         m_fd        = -1;
+    std::size_t m_page      = 0;
+    std::size_t m_chunk     = 0;
+    std::size_t m_size      = 0;
+    std::size_t m_fileSize  = 0;
+    char*       m_window    = nullptr;
+    std::size_t m_windowOff = 0;
+};
+
+// One bucket array in the store's spill file: the byte ranges appended to
+// it part by part, in order. Parts interleave in the file, so an array is
+// usually several ranges.
+struct SpillArray {
+    struct Range {
+        std::size_t offset;
+        std::size_t bytes;
+    };
+    std::vector<Range> ranges;
+    std::size_t        bytes = 0;
+
+    std::size_t size() const { return bytes; }
+};
+
+// Per-material bucket whose arrays live on disk instead of RAM.
+struct SpilledTriBucket {
+    int materialIndex = -1;
+    SpillArray vertices, normals, indices;
+    std::size_t vertexCount = 0;
+    std::size_t indexCount  = 0;
+    std::array<float,6> bounds       = {0,0,0,0,0,0};
+    std::array<float,6> normalBounds = {0,0,0,0,0,0};   // exact, for the NORMAL accessor
+};
+
+struct SpilledEdgeBucket {
+    int materialIndex = -1;
+    SpillArray vertices, indices;
+    std::size_t vertexCount = 0;
+    std::size_t indexCount  = 0;
+    std::array<float,6> bounds = {0,0,0,0,0,0};
+};
+
+// Out-of-core replacement for the assembly's triBuckets/edgeBuckets vectors.
+// Buckets are appended part by part (indices re-based per material, as
+// MeshShape does in memory) and are streamed into the GLB BIN chunk later.
+// Every array of every material goes to one spill file, so the store holds
+// one descriptor and one mapped window however many colors there are.
+class SpillBucketStore {
+public:
+    explicit SpillBucketStore(std::string dir) : m_dir(std::move(dir)) {}
+
+    // Append one part's buckets; bucket i belongs to material i
+    void append(const std::vector<TriBucket>& tris,
+                const std::vector<EdgeBucket>& edges);
+
+    const std::vector<SpilledTriBucket>&  tris()  const { return m_tris; }
+    const std::vector<SpilledEdgeBucket>& edges() const { return m_edges; }
+
+    // Stream one array's ranges to `out`
+    bool copyTo(std::ostream& out, const SpillArray& array) const;
+
+    std::size_t diskBytes() const { return m_file ? m_file->size() : 0; }
+
+private:
+    void put(SpillArray& array, const void* data, std::size_t bytes);
+
+    std::string                    m_dir;
+    std::unique_ptr<SpillFile>     m_file;
+    std::vector<SpilledTriBucket>  m_tris;
+    std::vector<SpilledEdgeBucket> m_edges;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AssemblyIndex;
+class LeafMeshes;
+class SharedGeometryBuffer;
+
+struct SubassemblyOptions {
+    BufferLayout  bufferLayout   = BufferLayout::Single;
+    std::uint64_t maxBufferBytes = 1ull << 30;
+    SharedGeometryBuffer* shared = nullptr;   // set: queue .gltf documents instead
+};
+
+// One GLB per intermediate assembly below the rootNodes (every definition
+// with components, once however often it is placed; the roots themselves
+// are covered by the assembly GLB). Leaves come from the run's shared leaf
+// meshes and are composed into every assembly that holds them, moved by
+// their placement relative to that assembly, so the GLB is in the
+// assembly's own frame. Files are dir/out_<path>_1.glb, or
+// dir/out_<path>_1.gltf placing the meshes of a shared geometry buffer
+// (written when that is finished).
+bool ExportSubassemblies(const AssemblyIndex&              index,
+                         LeafMeshes&                       meshes,
+                         const std::vector<std::uint32_t>& rootNodes,
+                         const std::string&                dir,
+                         const SubassemblyOptions&         opt);
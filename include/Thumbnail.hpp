@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ImageWriter.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Camera directions for thumbnails, Z up (OCCT names in brackets)
+enum class RenderView {
+    Iso,      // from +X -Y +Z       [V3d_XposYnegZpos]
+    Front,    // from -Y             [V3d_Yneg]
+    Top,      // from +Z, Y up       [V3d_Zpos]
+    Side      // from +X             [V3d_Xpos]
+};
+
+// Anti-aliasing and shadow presets. OCCT: MSAA samples / resolution scale /
+// shadows; software renderer: supersampling factor.
+enum class RenderQuality {
+    Draft,      // no MSAA, 1x,  no shadows  | SSAA 1
+    Standard,   // 4x MSAA, 2x,  no shadows  | SSAA 2
+    High        // 16x MSAA, 4x, shadows     | SSAA 3
+};
+
+// Images rendered for one part from one scene setup
+struct ThumbnailSpec {
+    std::vector<RenderView> views = {RenderView::Iso};
+    bool          spriteSheet = false;   // all views side by side in one image
+    RenderQuality quality     = RenderQuality::High;
+    int           size        = 512;     // per view, square
+    ImageEncodeOptions encode;           // file format and PNG effort
+};
+
+inline const char* ViewName(RenderView v)
+{
+    switch (v) {
+        case RenderView::Iso:   return "iso";
+        case RenderView::Front: return "front";
+        case RenderView::Top:   return "top";
+        case RenderView::Side:  return "side";
+    }
+    return "iso";
+}
+
+inline bool ParseView(const char* s, RenderView& v)
+{
+    for (RenderView c : {RenderView::Iso, RenderView::Front, RenderView::Top, RenderView::Side}) {
+        if (!std::strcmp(s, ViewName(c))) { v = c; return true; }
+    }
+    return false;
+}
+
+inline const char* QualityName(RenderQuality q)
+{
+    switch (q) {
+        case RenderQuality::Draft:    return "draft";
+        case RenderQuality::Standard: return "standard";
+        case RenderQuality::High:     return "high";
+    }
+    return "high";
+}
+
+// Output files for `pngFile`: the sprite sheet, or the first view under
+// the given name and every further view as <stem>_<view><ext>
+inline std::vector<std::string> ThumbnailFiles(const std::string& pngFile, const ThumbnailSpec& spec)
+{
+    if (spec.spriteSheet || spec.views.size() <= 1) return {pngFile};
+
+    const std::size_t dot = pngFile.rfind('.');
+    const std::string stem = (dot == std::string::npos) ? pngFile : pngFile.substr(0, dot);
+    const std::string ext  = (dot == std::string::npos) ? std::string() : pngFile.substr(dot);
+
+    std::vector<std::string> out = {pngFile};
+    for (std::size_t i=1; i<spec.views.size(); ++i) {
+        out.push_back(stem + "_" + ViewName(spec.views[i]) + ext);
+    }
+    return out;
+}
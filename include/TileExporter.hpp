@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AssemblyIndex;
+class LeafMeshes;
+
+struct TileOptions {
+    std::size_t   maxTrianglesPerTile = 200000;   // octree nodes above this split
+    std::uint32_t maxDepth            = 8;
+};
+
+// Spatially tiled export for progressive viewing. Every leaf occurrence
+// below the rootNodes is drawn from its definition's mesh in `meshes`
+// (shared with the other passes), placed with its world transform and
+// sorted into a loose octree: an occurrence sits in the deepest node whose
+// cell can hold it, so large parts land in the coarse tiles a viewer
+// fetches first. Each non-empty node becomes one GLB, and dir/tileset.json
+// (3D Tiles 1.1, additive refinement) indexes them with bounding boxes and
+// geometric errors. Tiles whose GLB cannot be written are left out of the
+// tileset and make the export fail.
+bool ExportTileset(const AssemblyIndex&              index,
+                   LeafMeshes&                       meshes,
+                   const std::vector<std::uint32_t>& rootNodes,
+                   const std::string&                dir,
+                   const TileOptions&                opt);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Lightweight scoped tracing, written as Chrome trace JSON
+// (open with chrome://tracing or https://ui.perfetto.dev).
+//
+// When tracing is disabled a Span costs one relaxed atomic load.
+// When enabled, events are appended to a per-thread buffer (no locking
+// on the hot path) and only serialized by Flush() at the end of the run.
+namespace Trace {
+
+    namespace detail {
+        extern std::atomic<bool> g_enabled;
+    }
+
+    inline bool Enabled() {
+        return detail::g_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Start recording; events are written to `file` by Flush().
+    void Enable(const std::string& file);
+
+    // Write all recorded events. Call once, after worker threads are done.
+    bool Flush();
+
+    // Counter track sample (e.g. RSS), shown as a graph in the viewer.
+    void Counter(const char* name, double value);
+
+    // RAII span: records [construction, destruction) as a complete event.
+    // `name` and `cat` must be string literals (stored by pointer).
+    class Span {
+    public:
+        explicit Span(const char* name, const char* cat = "phase");
+        Span(const char* name, const char* cat, const std::string& detail);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        void setBytes(std::uint64_t bytes) { m_bytes = static_cast<std::int64_t>(bytes); }
+        void setDetail(const std::string& detail) { if (m_active) m_detail = detail; }
+
+    private:
+        const char*   m_name;
+        const char*   m_cat;
+        std::string   m_detail;
+        std::uint64_t m_startUs = 0;
+        std::int64_t  m_bytes   = -1;
+        bool          m_active  = false;
+    };
+
+}
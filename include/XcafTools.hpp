@@ -10,12 +10,16 @@
 #include <TDF_Label.hxx>
 #include <TDF_LabelSequence.hxx>
 #include <Quantity_Color.hxx>
-#include <set>
 #include <string>
 
+class AssemblyIndex;
+
 // Label path → safe filename ("0:1:1:2" → "0-1-1-2")
 std::string LabelPathForFilename(const TDF_Label& lab);
 
+// TDataStd_Name of a label as ASCII, or `fallback` if it has none
+std::string LabelName(const TDF_Label& lab, const std::string& fallback = "Unnamed");
+
 // Effective XDE color resolution
 bool GetEffectiveColor(const TDF_Label&              label,
                        const Handle(XCAFDoc_ShapeTool)& shapeTool,
@@ -34,24 +38,6 @@ bool ExportShapeToSTEP(const TDF_Label&                    compLabel,
                        const Handle(XCAFDoc_ColorTool)&    colorTool,
                        const std::string&                  stepFile);
 
-// Collect components for assembly export (1 level below roots)
-void CollectAssemblyComponentsShallow(
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const TDF_LabelSequence&         roots,
-    TDF_LabelSequence&               out);
-
-// Collect leaf components (deep)
-void CollectLeafComponentsDeep(
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const TDF_LabelSequence&         roots,
-    TDF_LabelSequence&               out);
-
-// Pretty tree dump (full depth, instance + prototype)
-void DumpAssemblyTreeDeep(
-    const TDF_Label&                label,
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const Handle(XCAFDoc_ColorTool)& colorTool,
-    std::set<std::string>&          visited,
-    int                              depth   = 0,
-    bool                             isLast  = true,
-    const std::string&               prefix  = "");
+// Pretty tree dump (full depth, instance + prototype); every label is
+// printed once, at its first occurrence
+void DumpAssemblyTreeDeep(const AssemblyIndex& index);
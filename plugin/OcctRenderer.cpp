@@ -0,0 +1,504 @@
+#include "RenderPlugin.hpp"
+#include "Trace.hpp"
+
+#include <Quantity_Color.hxx>
+#include <Standard_Failure.hxx>
+#include <Xw_Window.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <Aspect_DisplayConnection.hxx>
+#include <V3d_Viewer.hxx>
+#include <V3d_View.hxx>
+#include <AIS_InteractiveContext.hxx>
+#include <AIS_Shape.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <Graphic3d_CView.hxx>
+#include <Graphic3d_Vec2.hxx>
+#include <Graphic3d_RenderingParams.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <Prs3d_ShadingAspect.hxx>
+#include <Prs3d_LineAspect.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <Aspect_TypeOfLine.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+/*
+    Note that in Linux this will need to install:
+
+    $ sudo apt-get install xvfb
+
+    And then run the server:
+
+    $ Xvfb :99 -screen 0 1024x768x24 &
+    $ export DISPLAY=:99
+
+*/
+
+// The OpenGL side of RenderSession, built into libstepguru_render and
+// created through the factory at the end of this file. It keeps its
+// display connection, graphic driver, viewer, context, virtual window,
+// view and framebuffer alive between images; a failed render drops the
+// state so the next call starts clean.
+class OcctRenderSession : public RenderPluginSession {
+public:
+    OcctRenderSession() = default;
+    ~OcctRenderSession() override;
+
+    bool render(const std::vector<TopoDS_Shape>& shapes,
+                const std::vector<RGBA>&         colors,
+                const std::string&               pngFile,
+                const ThumbnailSpec&             spec) override;
+
+    bool renderBuckets(const std::vector<TriBucket>&  tris,
+                       const std::vector<EdgeBucket>& edges,
+                       const std::vector<RGBA>&       materials,
+                       const std::string&             pngFile,
+                       const ThumbnailSpec&           spec) override;
+
+    std::size_t imagesRendered() const override { return m_images; }
+    void setImageWriter(AsyncImageWriter* writer) override { m_writer = writer; }
+
+private:
+    struct State;
+
+    bool init();
+
+    // Quality tier and output size; only touched when they change
+    void configure(const ThumbnailSpec& spec);
+
+    // Replace the displayed objects (display() returns false when there is
+    // nothing to show), then fit, draw and write every view of `spec`
+    bool draw(const std::string&           pngFile,
+              const ThumbnailSpec&         spec,
+              const std::function<bool()>& display);
+
+    std::unique_ptr<State> m_state;
+    std::size_t            m_images = 0;
+    AsyncImageWriter*      m_writer = nullptr;
+};
+
+struct OcctRenderSession::State {
+    Handle(Aspect_DisplayConnection) display;
+    Handle(OpenGl_GraphicDriver)     driver;
+    Handle(V3d_Viewer)               viewer;
+    Handle(AIS_InteractiveContext)   ctx;
+    Handle(Xw_Window)                window;
+    Handle(V3d_View)                 view;
+    Handle(Standard_Transient)       fbo;      // offscreen target ToPixMap reuses
+    Graphic3d_Vec2i                  winSize{512, 512};
+    Image_AlienPixMap                pixmap;
+    RenderQuality                    quality = RenderQuality::High;
+};
+
+OcctRenderSession::~OcctRenderSession()
+{
+    if (m_state && !m_state->fbo.IsNull()) {
+        try {
+            m_state->view->View()->SetFBO(Handle(Standard_Transient)());
+            m_state->view->View()->FBORelease(m_state->fbo);
+        } catch (...) {
+        }
+    }
+}
+
+bool OcctRenderSession::init()
+{
+    Trace::Span span("RenderSessionInit", "render");
+
+    auto st = std::make_unique<State>();
+    st->display = new Aspect_DisplayConnection();
+    st->driver  = new OpenGl_GraphicDriver(st->display, Standard_True);
+
+    st->driver->ChangeOptions().buffersNoSwap = Standard_True;
+    st->driver->ChangeOptions().swapInterval  = 0;
+
+    st->viewer = new V3d_Viewer(st->driver);
+    st->viewer->SetDefaultViewProj(V3d_XposYnegZpos);
+    st->viewer->SetDefaultShadingModel(Graphic3d_TypeOfShadingModel_Pbr);
+    st->viewer->SetDefaultVisualization(V3d_ZBUFFER);
+
+    st->ctx = new AIS_InteractiveContext(st->viewer);
+
+    st->window = new Xw_Window(st->display, "Offscreen", 0, 0,
+                               st->winSize.x(), st->winSize.y());
+    st->window->SetVirtual(true);
+
+    st->view = new V3d_View(st->viewer);
+    st->view->SetWindow(st->window);
+
+    Graphic3d_RenderingParams& params = st->view->ChangeRenderingParams();
+    params.IsAntialiasingEnabled  = Standard_True;
+    params.NbMsaaSamples          = 16;
+    params.RenderResolutionScale  = 4.0f;
+    params.IsShadowEnabled        = Standard_True;
+
+    st->viewer->SetDefaultLights();
+    st->viewer->SetLightOn();
+    st->view->SetBackgroundColor(Quantity_NOC_WHITE);
+    st->view->SetProj(V3d_XposYnegZpos);
+
+    // A framebuffer of the output size installed on the view: ToPixMap
+    // renders into it instead of creating and releasing one per image
+    st->fbo = st->view->View()->FBOCreate(st->winSize.x(), st->winSize.y());
+    if (!st->fbo.IsNull()) {
+        st->view->View()->SetFBO(st->fbo);
+    }
+
+    st->pixmap.InitZero(Image_Format_RGB, st->winSize.x(), st->winSize.y());
+
+    m_state = std::move(st);
+    return true;
+}
+
+namespace {
+
+Quantity_Color EdgeColorFor(const RGBA& col)
+{
+    float brightnessPNG =
+        0.299f*col.r + 0.587f*col.g + 0.114f*col.b;
+    return (brightnessPNG > 0.5f)
+        ? Quantity_Color(0.1, 0.1, 0.1, Quantity_TOC_RGB)
+        : Quantity_Color(0.9, 0.9, 0.9, Quantity_TOC_RGB);
+}
+
+V3d_TypeOfOrientation Orientation(RenderView v)
+{
+    switch (v) {
+        case RenderView::Iso:   return V3d_XposYnegZpos;
+        case RenderView::Front: return V3d_Yneg;
+        case RenderView::Top:   return V3d_Zpos;
+        case RenderView::Side:  return V3d_Xpos;
+    }
+    return V3d_XposYnegZpos;
+}
+
+// Readback as RgbImage; Row() hides the pixmap's row order and padding
+RgbImage ToRgbImage(const Image_PixMap& pixmap)
+{
+    RgbImage image(static_cast<int>(pixmap.SizeX()), static_cast<int>(pixmap.SizeY()));
+    const bool bgr = pixmap.Format() == Image_Format_BGR;
+    const std::size_t rowBytes = pixmap.SizeX() * 3;
+    for (Standard_Size y=0; y<pixmap.SizeY(); ++y) {
+        std::uint8_t* dst = &image.pixels[y * rowBytes];
+        std::memcpy(dst, pixmap.Row(y), rowBytes);
+        if (bgr) {
+            for (std::size_t x=0; x<rowBytes; x+=3) std::swap(dst[x], dst[x + 2]);
+        }
+    }
+    return image;
+}
+
+RGBA ShadedColor(const RGBA& col)
+{
+    RGBA defaultGray{0.7f,0.7f,0.7f,1.0f};
+    if (col.r == 0.0f && col.g == 0.0f && col.b == 0.0f) return defaultGray;
+    return col;
+}
+
+// Pre-tessellated buckets as one presentable object: a group per bucket
+// holding a triangle (or segment) primitive array with the same shading
+// and line aspects RenderSession gives an AIS_Shape
+class BucketObject : public AIS_InteractiveObject {
+    DEFINE_STANDARD_RTTI_INLINE(BucketObject, AIS_InteractiveObject)
+public:
+    BucketObject(const std::vector<TriBucket>&  tris,
+                 const std::vector<EdgeBucket>& edges,
+                 const std::vector<RGBA>&       materials)
+        : m_tris(tris), m_edges(edges), m_materials(materials) {}
+
+    Standard_Boolean AcceptDisplayMode(const Standard_Integer mode) const override
+    {
+        return mode == 0;
+    }
+
+protected:
+    void Compute(const Handle(PrsMgr_PresentationManager)&,
+                 const Handle(Prs3d_Presentation)& prs,
+                 const Standard_Integer            mode) override
+    {
+        if (mode != 0) return;
+
+        for (const auto& b : m_tris) {
+            if (b.indices.empty()) continue;
+            const bool normals = b.normals.size() == b.vertices.size();
+            const RGBA col = ShadedColor(color(b.materialIndex));
+
+            Handle(Graphic3d_ArrayOfTriangles) arr = new Graphic3d_ArrayOfTriangles(
+                static_cast<Standard_Integer>(b.vertices.size()),
+                static_cast<Standard_Integer>(b.indices.size()),
+                normals ? Graphic3d_ArrayFlags_VertexNormal : Graphic3d_ArrayFlags_None);
+            for (std::size_t i=0; i<b.vertices.size(); ++i) {
+                const Vertex& v = b.vertices[i];
+                if (normals) {
+                    const Normal& n = b.normals[i];
+                    arr->AddVertex(v.x, v.y, v.z, n.x, n.y, n.z);
+                } else {
+                    arr->AddVertex(v.x, v.y, v.z);
+                }
+            }
+            // Primitive arrays index from 1
+            for (std::size_t i=0; i+2<b.indices.size(); i+=3) {
+                arr->AddEdges(static_cast<Standard_Integer>(b.indices[i])   + 1,
+                              static_cast<Standard_Integer>(b.indices[i+1]) + 1,
+                              static_cast<Standard_Integer>(b.indices[i+2]) + 1);
+            }
+
+            Handle(Prs3d_ShadingAspect) shading = new Prs3d_ShadingAspect();
+            shading->SetColor(Quantity_Color(col.r, col.g, col.b, Quantity_TOC_RGB));
+
+            Handle(Graphic3d_Group) group = prs->NewGroup();
+            group->SetGroupPrimitivesAspect(shading->Aspect());
+            group->AddPrimitiveArray(arr);
+        }
+
+        for (const auto& e : m_edges) {
+            if (e.indices.empty()) continue;
+            const Quantity_Color edgeColor = EdgeColorFor(ShadedColor(color(e.materialIndex)));
+
+            Handle(Graphic3d_ArrayOfSegments) arr = new Graphic3d_ArrayOfSegments(
+                static_cast<Standard_Integer>(e.vertices.size()),
+                static_cast<Standard_Integer>(e.indices.size()));
+            for (const auto& v : e.vertices) arr->AddVertex(v.x, v.y, v.z);
+            for (std::size_t i=0; i+1<e.indices.size(); i+=2) {
+                arr->AddEdges(static_cast<Standard_Integer>(e.indices[i])   + 1,
+                              static_cast<Standard_Integer>(e.indices[i+1]) + 1);
+            }
+
+            Handle(Prs3d_LineAspect) line = new Prs3d_LineAspect(edgeColor, Aspect_TOL_SOLID, 1.0);
+
+            Handle(Graphic3d_Group) group = prs->NewGroup();
+            group->SetGroupPrimitivesAspect(line->Aspect());
+            group->AddPrimitiveArray(arr);
+        }
+    }
+
+    void ComputeSelection(const Handle(SelectMgr_Selection)&, const Standard_Integer) override {}
+
+private:
+    RGBA color(int index) const
+    {
+        if (index < 0 || static_cast<std::size_t>(index) >= m_materials.size()) return {0, 0, 0, 1};
+        return m_materials[static_cast<std::size_t>(index)];
+    }
+
+    // Only read during Display(), while the caller's buckets are alive
+    const std::vector<TriBucket>&  m_tris;
+    const std::vector<EdgeBucket>& m_edges;
+    const std::vector<RGBA>&       m_materials;
+};
+
+} // namespace
+
+void OcctRenderSession::configure(const ThumbnailSpec& spec)
+{
+    State& st = *m_state;
+
+    if (st.quality != spec.quality) {
+        Graphic3d_RenderingParams& params = st.view->ChangeRenderingParams();
+        switch (spec.quality) {
+            case RenderQuality::Draft:
+                params.IsAntialiasingEnabled = Standard_False;
+                params.NbMsaaSamples         = 0;
+                params.RenderResolutionScale = 1.0f;
+                params.IsShadowEnabled       = Standard_False;
+                break;
+            case RenderQuality::Standard:
+                params.IsAntialiasingEnabled = Standard_True;
+                params.NbMsaaSamples         = 4;
+                params.RenderResolutionScale = 2.0f;
+                params.IsShadowEnabled       = Standard_False;
+                break;
+            case RenderQuality::High:
+                params.IsAntialiasingEnabled = Standard_True;
+                params.NbMsaaSamples         = 16;
+                params.RenderResolutionScale = 4.0f;
+                params.IsShadowEnabled       = Standard_True;
+                break;
+        }
+        st.quality = spec.quality;
+    }
+
+    const int size = std::max(16, spec.size);
+    if (st.winSize.x() != size || st.winSize.y() != size) {
+        if (!st.fbo.IsNull()) {
+            st.view->View()->SetFBO(Handle(Standard_Transient)());
+            st.view->View()->FBORelease(st.fbo);
+        }
+        st.winSize = Graphic3d_Vec2i(size, size);
+        st.fbo = st.view->View()->FBOCreate(size, size);
+        if (!st.fbo.IsNull()) {
+            st.view->View()->SetFBO(st.fbo);
+        }
+        st.pixmap.InitZero(Image_Format_RGB, size, size);
+    }
+}
+
+bool OcctRenderSession::draw(const std::string&          pngFile,
+                         const ThumbnailSpec&        spec,
+                         const std::function<bool()>& display)
+{
+    Trace::Span span("RenderPNG", "render", pngFile);
+
+    try {
+        if (!m_state && !init()) return false;
+        State& st = *m_state;
+        configure(spec);
+
+        // Only the presentations change between images
+        st.ctx->RemoveAll(Standard_False);
+        if (!display()) {
+            std::cerr << "❌ No shape available for rendering.\n";
+            return false;
+        }
+        st.ctx->UpdateCurrentViewer();
+
+        const std::vector<RenderView> views =
+            spec.views.empty() ? std::vector<RenderView>{RenderView::Iso} : spec.views;
+        const std::vector<std::string> files = ThumbnailFiles(pngFile, spec);
+        const bool sheet = spec.spriteSheet && views.size() > 1;
+
+        // Synchronous writes are counted here; queued ones by the writer
+        std::uint64_t bytes = 0;
+        auto store = [&](RgbImage&& image, const std::string& file) {
+            if (!StoreImage(std::move(image), file, spec.encode, m_writer)) {
+                std::cerr << "❌ Failed to save image file.\n";
+                return false;
+            }
+            if (!m_writer) {
+                std::error_code ec;
+                bytes += std::filesystem::file_size(file, ec);
+            }
+            std::cout << "🖼️  Anti-aliased image " << (m_writer ? "queued for " : "saved as ") << file << std::endl;
+            return true;
+        };
+
+        RgbImage sheetImage;
+        if (sheet) sheetImage = RgbImage(st.winSize.x() * static_cast<int>(views.size()), st.winSize.y());
+
+        // The scene is displayed once; every view only moves the camera and
+        // draws again (ToPixMap redraws into the session FBO)
+        for (std::size_t v=0; v<views.size(); ++v) {
+            st.view->SetProj(Orientation(views[v]));
+            st.view->FitAll();
+            st.view->ZFitAll();
+
+            bool drawn = false;
+            {
+                Trace::Span drawSpan("Redraw", "render", ViewName(views[v]));
+                drawn = st.view->ToPixMap(st.pixmap, st.winSize.x(), st.winSize.y(),
+                                          Graphic3d_BT_RGB, Standard_False);
+            }
+            if (!drawn) {
+                std::cerr << "❌ Failed to render scene to pixmap.\n";
+                return false;
+            }
+
+            RgbImage image = ToRgbImage(st.pixmap);
+            if (sheet) {
+                const std::size_t rowBytes = static_cast<std::size_t>(image.width) * 3;
+                for (int y=0; y<image.height; ++y) {
+                    std::memcpy(&sheetImage.pixels[(static_cast<std::size_t>(y) * sheetImage.width + v * image.width) * 3],
+                                &image.pixels[static_cast<std::size_t>(y) * rowBytes], rowBytes);
+                }
+                continue;
+            }
+            if (!store(std::move(image), files[v])) return false;
+        }
+        if (sheet && !store(std::move(sheetImage), pngFile)) return false;
+
+        m_images += views.size();
+        span.setBytes(bytes);
+        return true;
+    } catch (const Standard_Failure& e) {
+        std::cerr << "Rendering error: " << e.GetMessageString() << std::endl;
+    } catch (...) {
+        std::cerr << "Rendering error: unknown exception\n";
+    }
+
+    // Unknown GL/context state after an exception: rebuild next time
+    m_state.reset();
+    return false;
+}
+
+bool OcctRenderSession::render(const std::vector<TopoDS_Shape>& shapes,
+                           const std::vector<RGBA>&         colors,
+                           const std::string&               pngFile,
+                           const ThumbnailSpec&             spec)
+{
+    std::cout << "Rendering PNG with OpenCascade for " << pngFile << " ...\n";
+
+    return draw(pngFile, spec, [&]() {
+        AIS_InteractiveContext& ctx = *m_state->ctx;
+        RGBA defaultGray{0.7f,0.7f,0.7f,1.0f};
+        bool any = false;
+
+        for (std::size_t i=0; i<shapes.size(); ++i) {
+            const TopoDS_Shape& s = shapes[i];
+            if (s.IsNull()) continue;
+
+            RGBA col = ShadedColor((i < colors.size()) ? colors[i] : defaultGray);
+
+            Quantity_Color qc(col.r, col.g, col.b, Quantity_TOC_RGB);
+            Quantity_Color edgeColor = EdgeColorFor(col);
+
+            Handle(AIS_Shape) aisShape = new AIS_Shape(s);
+            aisShape->SetColor(qc);
+            aisShape->Attributes()->SetShadingAspect(new Prs3d_ShadingAspect());
+            aisShape->Attributes()->ShadingAspect()->SetColor(qc);
+
+            Handle(Prs3d_Drawer) drawer = aisShape->Attributes();
+            drawer->SetFaceBoundaryDraw(Standard_True);
+            drawer->SetWireAspect(new Prs3d_LineAspect(edgeColor, Aspect_TOL_SOLID, 1.0));
+            drawer->SetFaceBoundaryAspect(new Prs3d_LineAspect(edgeColor, Aspect_TOL_SOLID, 1.0));
+            drawer->SetLineAspect(new Prs3d_LineAspect(edgeColor, Aspect_TOL_SOLID, 1.0));
+
+            ctx.Display(aisShape, Standard_False);
+            ctx.SetDisplayMode(aisShape, AIS_Shaded, Standard_False);
+            ctx.IsoOnTriangulation(Standard_True, aisShape);
+            any = true;
+        }
+        return any;
+    });
+}
+
+bool OcctRenderSession::renderBuckets(const std::vector<TriBucket>&  tris,
+                                  const std::vector<EdgeBucket>& edges,
+                                  const std::vector<RGBA>&       materials,
+                                  const std::string&             pngFile,
+                                  const ThumbnailSpec&           spec)
+{
+    std::cout << "Rendering PNG with OpenCascade (extracted mesh) for " << pngFile << " ...\n";
+
+    return draw(pngFile, spec, [&]() {
+        bool any = false;
+        for (const auto& b : tris)  any = any || !b.indices.empty();
+        for (const auto& e : edges) any = any || !e.indices.empty();
+        if (!any) return false;
+
+        // The presentation is computed inside Display(); the object keeps
+        // no copy of the buckets
+        Handle(BucketObject) obj = new BucketObject(tris, edges, materials);
+        m_state->ctx->Display(obj, 0, -1, Standard_False);
+        return true;
+    });
+}
+
+extern "C" RenderPluginSession* stepguru_create_render_session(int abi)
+{
+    if (abi != kRenderPluginAbi) {
+        std::cerr << "❌ Render plugin ABI " << kRenderPluginAbi
+                  << " does not match the converter's (" << abi << ")\n";
+        return nullptr;
+    }
+    return new OcctRenderSession();
+}
@@ -0,0 +1,390 @@
+#include "AssemblyBinaryWriter.hpp"
+#include "AssemblyBinary.hpp"
+#include "AssemblyBvh.hpp"
+#include "AssemblyIndex.hpp"
+#include "Trace.hpp"
+
+#include <rapidjson/document.h>
+#include <rapidjson/filereadstream.h>
+
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
+#include <gp_Trsf.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace AssemblyBinary;
+
+static_assert(std::endian::native == std::endian::little,
+              "assembly.bin is written as a raw little-endian image");
+
+namespace {
+
+class StringTable {
+public:
+    std::uint32_t intern(std::string_view s)
+    {
+        auto [it, inserted] = m_index.try_emplace(s, static_cast<std::uint32_t>(m_offsets.size()));
+        if (inserted) {
+            m_offsets.push_back(static_cast<std::uint32_t>(m_data.size()));
+            m_data.insert(m_data.end(), s.begin(), s.end());
+            m_data.push_back('\0');
+        }
+        return it->second;
+    }
+
+    std::uint32_t size() const { return static_cast<std::uint32_t>(m_offsets.size()); }
+
+    // Start offsets plus the closing end offset
+    std::vector<std::uint32_t> offsets() const
+    {
+        std::vector<std::uint32_t> out = m_offsets;
+        out.push_back(static_cast<std::uint32_t>(m_data.size()));
+        return out;
+    }
+    const std::vector<char>& data() const { return m_data; }
+
+private:
+    // Views point into the AssemblyIndex strings, which outlive the table
+    std::unordered_map<std::string_view, std::uint32_t> m_index;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<char>          m_data;
+};
+
+std::uint64_t Align8(std::uint64_t v) { return (v + 7) & ~std::uint64_t(7); }
+
+void WritePadded(std::ofstream& out, const void* data, std::uint64_t bytes)
+{
+    static const char zeros[8] = {};
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    out.write(zeros, static_cast<std::streamsize>(Align8(bytes) - bytes));
+}
+
+void RowMajor(const gp_Trsf& T, double m[16])
+{
+    const gp_Mat R = T.VectorialPart();
+    const gp_XYZ t = T.TranslationPart();
+    const double rows[16] = {
+        R(1,1), R(1,2), R(1,3), t.X(),
+        R(2,1), R(2,2), R(2,3), t.Y(),
+        R(3,1), R(3,2), R(3,3), t.Z(),
+        0.0,    0.0,    0.0,    1.0
+    };
+    std::copy(rows, rows + 16, m);
+}
+
+} // namespace
+
+bool WriteAssemblyBinary(const AssemblyIndex& index,
+                         std::uint32_t        rootNode,
+                         const std::string&   binFile)
+{
+    Trace::Span span("WriteAssemblyBinary", "io", binFile);
+
+    const std::uint32_t end = index.subtreeEnd(rootNode);
+    auto rebase = [&](std::uint32_t n) {
+        return (n == AssemblyIndex::kNone || n < rootNode || n >= end) ? kNone : n - rootNode;
+    };
+
+    StringTable strings;
+    std::vector<DefinitionRecord> defs;
+    std::vector<NodeRecord>       nodes;
+    std::vector<double>           transforms;
+    std::vector<std::uint32_t>    defOfSlot(index.slotCount(), kNone);
+
+    nodes.reserve(end - rootNode);
+    for (std::uint32_t n=rootNode; n<end; ++n) {
+        // Definitions in the order the JSON definitions pass emits them
+        const std::uint32_t defSlot = index.def(n);
+        if (defOfSlot[defSlot] == kNone) {
+            defOfSlot[defSlot] = static_cast<std::uint32_t>(defs.size());
+
+            DefinitionRecord d{};
+            d.id        = strings.intern(index.path(defSlot));
+            d.name      = index.hasName(defSlot) ? strings.intern(index.name(defSlot)) : kNone;
+            d.shapeType = static_cast<std::uint32_t>(index.shape(defSlot).ShapeType());
+            RGBA c = index.colorRGBA(defSlot, RGBA{0.8f, 0.8f, 0.8f, 1.0f});
+            d.flags     = index.hasColor(defSlot) ? kHasColor : 0;
+            d.rgba[0] = c.r; d.rgba[1] = c.g; d.rgba[2] = c.b; d.rgba[3] = c.a;
+            defs.push_back(d);
+        }
+
+        NodeRecord r{};
+        r.id          = strings.intern(index.path(index.slot(n)));
+        r.definition  = defOfSlot[defSlot];
+        r.parent      = n == rootNode ? kNone : rebase(index.parent(n));
+        r.firstChild  = rebase(index.firstChild(n));
+        r.nextSibling = n == rootNode ? kNone : rebase(index.nextSibling(n));
+        r.subtreeEnd  = index.subtreeEnd(n) - rootNode;
+        r.flags       = index.isInstance(n) ? kIsInstance : 0;
+        r.transform   = kNone;
+        if (!index.hasIdentityLocal(n)) {
+            r.transform = static_cast<std::uint32_t>(transforms.size() / 16);
+            transforms.resize(transforms.size() + 16);
+            RowMajor(index.local(n), transforms.data() + transforms.size() - 16);
+        }
+        nodes.push_back(r);
+    }
+
+    const std::vector<std::uint32_t> stringOffsets = strings.offsets();
+
+    FileHeader h{};
+    std::copy(kMagic, kMagic + sizeof(kMagic), h.magic);
+    h.version             = kVersion;
+    h.headerSize          = sizeof(FileHeader);
+    h.definitionCount     = static_cast<std::uint32_t>(defs.size());
+    h.nodeCount           = static_cast<std::uint32_t>(nodes.size());
+    h.transformCount      = static_cast<std::uint32_t>(transforms.size() / 16);
+    h.stringCount         = strings.size();
+    h.definitionsOffset   = Align8(sizeof(FileHeader));
+    h.nodesOffset         = h.definitionsOffset + Align8(defs.size() * sizeof(DefinitionRecord));
+    h.transformsOffset    = h.nodesOffset + Align8(nodes.size() * sizeof(NodeRecord));
+    h.stringOffsetsOffset = h.transformsOffset + Align8(transforms.size() * sizeof(double));
+    h.stringDataOffset    = h.stringOffsetsOffset + Align8(stringOffsets.size() * sizeof(std::uint32_t));
+    h.fileSize            = h.stringDataOffset + Align8(strings.data().size());
+
+    std::ofstream out(binFile, std::ios::binary);
+    if (!out) {
+        std::cerr << "❌ Cannot write " << binFile << "\n";
+        return false;
+    }
+    WritePadded(out, &h, sizeof(h));
+    WritePadded(out, defs.data(),          defs.size() * sizeof(DefinitionRecord));
+    WritePadded(out, nodes.data(),         nodes.size() * sizeof(NodeRecord));
+    WritePadded(out, transforms.data(),    transforms.size() * sizeof(double));
+    WritePadded(out, stringOffsets.data(), stringOffsets.size() * sizeof(std::uint32_t));
+    WritePadded(out, strings.data().data(), strings.data().size());
+
+    span.setBytes(h.fileSize);
+    return static_cast<bool>(out);
+}
+
+//------------------------------------------------------------
+// assembly.bvh
+//------------------------------------------------------------
+namespace {
+
+constexpr std::uint32_t kBvhLeafSize = 4;
+
+// Median split on the longest centroid axis; nodes come out depth-first
+// with the left child directly after its parent
+std::uint32_t BuildBvh(std::vector<AssemblyBvh::Item>& items,
+                       std::vector<AssemblyBvh::Node>& nodes,
+                       std::uint32_t begin, std::uint32_t end)
+{
+    const std::uint32_t id = static_cast<std::uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    AssemblyBvh::Box box     = items[begin].box;
+    double           cmin[3] = {}, cmax[3] = {};
+    for (std::uint32_t i=begin; i<end; ++i) {
+        const AssemblyBvh::Box& b = items[i].box;
+        for (int k=0; k<3; ++k) {
+            box.min[k] = std::min(box.min[k], b.min[k]);
+            box.max[k] = std::max(box.max[k], b.max[k]);
+            const double c = 0.5 * (b.min[k] + b.max[k]);
+            cmin[k] = (i == begin) ? c : std::min(cmin[k], c);
+            cmax[k] = (i == begin) ? c : std::max(cmax[k], c);
+        }
+    }
+    nodes[id].box = box;
+
+    if (end - begin <= kBvhLeafSize) {
+        nodes[id].first = begin;
+        nodes[id].count = end - begin;
+        return id;
+    }
+
+    int axis = 0;
+    for (int k=1; k<3; ++k) {
+        if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+    }
+    const std::uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                     [axis](const AssemblyBvh::Item& a, const AssemblyBvh::Item& b) {
+                         return a.box.min[axis] + a.box.max[axis] < b.box.min[axis] + b.box.max[axis];
+                     });
+
+    BuildBvh(items, nodes, begin, mid);
+    const std::uint32_t right = BuildBvh(items, nodes, mid, end);
+    nodes[id].first = right;
+    nodes[id].count = 0;
+    return id;
+}
+
+} // namespace
+
+bool WriteAssemblyBvh(const AssemblyIndex& index,
+                      std::uint32_t        rootNode,
+                      const std::string&   bvhFile)
+{
+    Trace::Span span("WriteAssemblyBvh", "io", bvhFile);
+
+    // Definition boxes are computed once and moved to each occurrence
+    std::vector<Bnd_Box> defBox(index.slotCount());
+    std::vector<char>    defDone(index.slotCount(), 0);
+
+    std::vector<AssemblyBvh::Item> items;
+    const std::uint32_t end = index.subtreeEnd(rootNode);
+    for (std::uint32_t n=rootNode; n<end; ++n) {
+        if (index.firstChild(n) != AssemblyIndex::kNone) continue;
+        const std::uint32_t def = index.def(n);
+        if (index.shape(def).IsNull()) continue;
+
+        if (!defDone[def]) {
+            defDone[def] = 1;
+            BRepBndLib::AddOptimal(index.shape(def), defBox[def], Standard_True, Standard_False);
+        }
+        if (defBox[def].IsVoid()) continue;
+
+        const Bnd_Box world = defBox[def].Transformed(index.world(n));
+        AssemblyBvh::Item it{};
+        world.Get(it.box.min[0], it.box.min[1], it.box.min[2],
+                  it.box.max[0], it.box.max[1], it.box.max[2]);
+        it.node = n - rootNode;
+        items.push_back(it);
+    }
+
+    std::vector<AssemblyBvh::Node> nodes;
+    if (!items.empty()) {
+        nodes.reserve(items.size());
+        BuildBvh(items, nodes, 0, static_cast<std::uint32_t>(items.size()));
+    }
+
+    AssemblyBvh::FileHeader h{};
+    std::copy(AssemblyBvh::kMagic, AssemblyBvh::kMagic + sizeof(AssemblyBvh::kMagic), h.magic);
+    h.version     = AssemblyBvh::kVersion;
+    h.headerSize  = sizeof(AssemblyBvh::FileHeader);
+    h.nodeCount   = static_cast<std::uint32_t>(nodes.size());
+    h.itemCount   = static_cast<std::uint32_t>(items.size());
+    h.nodesOffset = Align8(sizeof(AssemblyBvh::FileHeader));
+    h.itemsOffset = h.nodesOffset + Align8(nodes.size() * sizeof(AssemblyBvh::Node));
+    h.fileSize    = h.itemsOffset + Align8(items.size() * sizeof(AssemblyBvh::Item));
+
+    std::ofstream out(bvhFile, std::ios::binary);
+    if (!out) {
+        std::cerr << "❌ Cannot write " << bvhFile << "\n";
+        return false;
+    }
+    WritePadded(out, &h, sizeof(h));
+    WritePadded(out, nodes.data(), nodes.size() * sizeof(AssemblyBvh::Node));
+    WritePadded(out, items.data(), items.size() * sizeof(AssemblyBvh::Item));
+
+    span.setBytes(h.fileSize);
+    return static_cast<bool>(out);
+}
+
+//------------------------------------------------------------
+// Round-trip check against assembly.json
+//------------------------------------------------------------
+namespace {
+
+bool Mismatch(const std::string& what)
+{
+    std::cerr << "❌ assembly.bin differs from assembly.json: " << what << "\n";
+    return false;
+}
+
+bool SameString(const rapidjson::Value& v, std::string_view s)
+{
+    return v.IsString() && std::string_view(v.GetString(), v.GetStringLength()) == s;
+}
+
+bool CompareNode(const Reader& bin, std::uint32_t n, const rapidjson::Value& j, std::uint32_t& next)
+{
+    const NodeRecord& r = bin.node(n);
+    const std::string id(bin.string(r.id));
+    next = n + 1;
+
+    if (!j.IsObject() || !j.HasMember("id") || !SameString(j["id"], id))
+        return Mismatch("node " + std::to_string(n) + " id " + id);
+    if (!j.HasMember("definitionId") || !SameString(j["definitionId"], bin.string(bin.definition(r.definition).id)))
+        return Mismatch("definitionId of " + id);
+    if (!j.HasMember("isInstance") || !j["isInstance"].IsBool() ||
+        j["isInstance"].GetBool() != ((r.flags & kIsInstance) != 0))
+        return Mismatch("isInstance of " + id);
+
+    const double* m = bin.transform(r.transform);
+    if (j.HasMember("transform") != (m != nullptr))
+        return Mismatch("transform presence of " + id);
+    if (m) {
+        const rapidjson::Value& t = j["transform"];
+        if (!t.IsArray() || t.Size() != 16) return Mismatch("transform size of " + id);
+        for (rapidjson::SizeType k=0; k<16; ++k) {
+            if (!t[k].IsNumber() || t[k].GetDouble() != m[k]) return Mismatch("transform of " + id);
+        }
+    }
+
+    if (!j.HasMember("children") || !j["children"].IsArray()) return Mismatch("children of " + id);
+    const rapidjson::Value& children = j["children"];
+    rapidjson::SizeType k = 0;
+    for (std::uint32_t c = r.firstChild; c != kNone; c = bin.node(c).nextSibling, ++k) {
+        if (k >= children.Size()) return Mismatch("extra children under " + id);
+        if (c != next) return Mismatch("children of " + id + " are not in pre-order");
+        if (!CompareNode(bin, c, children[k], next)) return false;
+    }
+    if (k != children.Size()) return Mismatch("missing children under " + id);
+    if (next != r.subtreeEnd) return Mismatch("subtreeEnd of " + id);
+    return true;
+}
+
+} // namespace
+
+bool CompareAssemblyBinaryWithJson(const std::string& binFile,
+                                   const std::string& jsonFile)
+{
+    Trace::Span span("ValidateAssemblyBinary", "io", binFile);
+
+    MappedFile map(binFile);
+    Reader bin(map.data(), map.size());
+    if (!bin.ok()) return Mismatch("cannot open or invalid header");
+
+    FILE* f = fopen(jsonFile.c_str(), "rb");
+    if (!f) return Mismatch("cannot open " + jsonFile);
+    char buff[65536];
+    rapidjson::FileReadStream is(f, buff, sizeof(buff));
+    rapidjson::Document doc;
+    doc.ParseStream(is);
+    fclose(f);
+    if (doc.HasParseError() || !doc.IsObject()) return Mismatch("cannot parse " + jsonFile);
+
+    if (!doc.HasMember("definitions") || !doc["definitions"].IsArray()) return Mismatch("definitions");
+    const rapidjson::Value& defs = doc["definitions"];
+    if (defs.Size() != bin.definitionCount()) return Mismatch("definition count");
+    for (rapidjson::SizeType i=0; i<defs.Size(); ++i) {
+        const DefinitionRecord& d = bin.definition(i);
+        const rapidjson::Value& j = defs[i];
+        const std::string id(bin.string(d.id));
+        if (!j.IsObject() || !j.HasMember("id") || !SameString(j["id"], id))
+            return Mismatch("definition " + std::to_string(i) + " id");
+        std::string_view name = d.name == kNone ? std::string_view("Unnamed") : bin.string(d.name);
+        if (!j.HasMember("name") || !SameString(j["name"], name)) return Mismatch("name of definition " + id);
+        if (!j.HasMember("shapeType") || !SameString(j["shapeType"], bin.shapeTypeName(d)))
+            return Mismatch("shapeType of " + id);
+        if (!j.HasMember("color") || !j["color"].IsArray() || j["color"].Size() < 3)
+            return Mismatch("color of " + id);
+        const rapidjson::Value& c = j["color"];
+        for (rapidjson::SizeType k=0; k<3; ++k) {
+            if (!c[k].IsNumber() || std::fabs(c[k].GetDouble() - d.rgba[k]) > 1e-6) return Mismatch("color of " + id);
+        }
+    }
+
+    if (!doc.HasMember("root")) return Mismatch("no root");
+    std::uint32_t next = 0;
+    if (bin.nodeCount() == 0 || !CompareNode(bin, 0, doc["root"], next)) {
+        return bin.nodeCount() == 0 ? Mismatch("no nodes") : false;
+    }
+    if (next != bin.nodeCount()) return Mismatch("node count");
+
+    std::cout << "✅ assembly.bin matches assembly.json ("
+              << bin.nodeCount() << " nodes, " << bin.definitionCount() << " definitions)\n";
+    return true;
+}
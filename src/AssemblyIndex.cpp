@@ -0,0 +1,173 @@
+#include "AssemblyIndex.hpp"
+#include "LabelResolver.hpp"
+#include "XcafTools.hpp"
+
+#include <TDF_Tool.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <TopLoc_Location.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+
+#include <algorithm>
+
+void AssemblyIndex::clear()
+{
+    *this = AssemblyIndex();
+}
+
+std::uint32_t AssemblyIndex::internLabel(const TDF_Label& lab, LabelResolver& labels)
+{
+    auto [it, inserted] = m_slotOf.try_emplace(lab, slotCount());
+    if (!inserted) return it->second;
+
+    TCollection_AsciiString entry;
+    TDF_Tool::Entry(lab, entry);
+
+    const LabelInfo& li = labels.info(lab);
+    m_labels.push_back(lab);
+    m_entries.emplace_back(entry.ToCString());
+    m_paths.push_back(LabelPathForFilename(lab));
+    m_hasName.push_back(li.hasName);
+    m_names.push_back(li.name);
+    m_hasColor.push_back(li.hasColor);
+    m_colors.push_back(li.color);
+    m_shapes.push_back(labels.shapeTool()->GetShape(lab));
+    m_firstNode.push_back(kNone);
+    return it->second;
+}
+
+void AssemblyIndex::build(const TDF_LabelSequence& roots, LabelResolver& labels)
+{
+    clear();
+    const Handle(XCAFDoc_ShapeTool)& shapeTool = labels.shapeTool();
+
+    // Explicit DFS stack; children are pushed in reverse so they pop in
+    // document order and nodes come out in pre-order
+    struct Pending {
+        TDF_Label     label;
+        std::uint32_t parent;
+    };
+    std::vector<Pending>       stack;
+    std::vector<std::uint32_t> lastChild;
+    std::uint32_t              lastRoot = kNone;
+    TDF_LabelSequence          comps;
+
+    for (Standard_Integer r=roots.Length(); r>=1; --r) {
+        stack.push_back({roots.Value(r), kNone});
+    }
+
+    while (!stack.empty()) {
+        const Pending cur = stack.back();
+        stack.pop_back();
+
+        const std::uint32_t n    = size();
+        const std::uint32_t slot = internLabel(cur.label, labels);
+
+        TDF_Label ref;
+        const bool isInst = labels.referred(cur.label, ref);
+        const std::uint32_t def = isInst ? internLabel(ref, labels) : slot;
+
+        const TopLoc_Location loc = XCAFDoc_ShapeTool::GetLocation(cur.label);
+
+        std::uint8_t flags = 0;
+        if (isInst)             flags |= kInstance;
+        if (loc.IsIdentity())   flags |= kIdentity;
+        if (m_firstNode[slot] == kNone) {
+            m_firstNode[slot] = n;
+            flags |= kFirst;
+        }
+
+        m_slot.push_back(slot);
+        m_def.push_back(def);
+        m_parent.push_back(cur.parent);
+        m_firstChild.push_back(kNone);
+        m_nextSibling.push_back(kNone);
+        m_subtreeEnd.push_back(n + 1);
+        m_flags.push_back(flags);
+        m_local.push_back(loc.Transformation());
+        lastChild.push_back(kNone);
+
+        std::uint32_t& prev = (cur.parent == kNone) ? lastRoot : lastChild[cur.parent];
+        if (prev != kNone) {
+            m_nextSibling[prev] = n;
+        } else if (cur.parent != kNone) {
+            m_firstChild[cur.parent] = n;
+        }
+        prev = n;
+
+        if (cur.parent == kNone) {
+            m_roots.push_back(n);
+            m_depth.push_back(0);
+            m_world.push_back(m_local[n]);
+        } else {
+            m_depth.push_back(m_depth[cur.parent] + 1);
+            m_world.push_back(m_world[cur.parent].Multiplied(m_local[n]));
+        }
+
+        // Components live under the definition; instance labels have none
+        comps.Clear();
+        shapeTool->GetComponents(isInst ? ref : cur.label, comps, Standard_False);
+        for (Standard_Integer i=comps.Length(); i>=1; --i) {
+            stack.push_back({comps.Value(i), n});
+        }
+    }
+
+    // Children follow their parent in pre-order, so one backward pass
+    // closes every subtree range
+    for (std::uint32_t n=size(); n-- > 0; ) {
+        const std::uint32_t p = m_parent[n];
+        if (p != kNone) m_subtreeEnd[p] = std::max(m_subtreeEnd[p], m_subtreeEnd[n]);
+    }
+}
+
+RGBA AssemblyIndex::colorRGBA(std::uint32_t s, const RGBA& defaultCol) const
+{
+    if (!m_hasColor[s]) return defaultCol;
+    const Quantity_Color& c = m_colors[s];
+    return RGBA{(float)c.Red(), (float)c.Green(), (float)c.Blue(), 1.0f};
+}
+
+std::vector<std::uint32_t> AssemblyIndex::shallowComponents() const
+{
+    std::vector<std::uint32_t> out;
+    for (std::uint32_t r : m_roots) {
+        if (m_firstChild[r] == kNone) {
+            out.push_back(r);
+            continue;
+        }
+        for (std::uint32_t c = m_firstChild[r]; c != kNone; c = m_nextSibling[c]) {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+std::vector<std::uint32_t> AssemblyIndex::leafComponents() const
+{
+    std::vector<std::uint32_t> out;
+    std::vector<std::uint8_t>  seen(slotCount(), 0);
+    std::vector<std::uint32_t> open;
+
+    // Post-order over the pre-order arrays: a node is emitted once the
+    // scan leaves its subtree. Roots themselves are not components.
+    auto emit = [&](std::uint32_t n) {
+        if (m_parent[n] == kNone || seen[m_slot[n]]) return;
+        seen[m_slot[n]] = 1;
+        out.push_back(n);
+    };
+    for (std::uint32_t n=0; n<size(); ++n) {
+        while (!open.empty() && n >= m_subtreeEnd[open.back()]) {
+            emit(open.back());
+            open.pop_back();
+        }
+        open.push_back(n);
+    }
+    while (!open.empty()) {
+        emit(open.back());
+        open.pop_back();
+    }
+
+    if (out.empty()) {
+        out = m_roots;
+    }
+    return out;
+}
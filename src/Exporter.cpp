@@ -5,27 +5,107 @@
 #include "MeshExtractor.hpp"
 #include "GlbBuilder.hpp"
 #include "PngRenderer.hpp"
+#include "SoftRenderer.hpp"
 #include "JsonExporter.hpp"
-
+#include "Trace.hpp"
+#include "Report.hpp"
+#include "MemStats.hpp"
+#include "MeshCache.hpp"
+#include "SpillStore.hpp"
+#include "LeafMeshes.hpp"
+#include "LabelResolver.hpp"
+#include "AssemblyIndex.hpp"
+#include "AssemblyBinaryWriter.hpp"
+#include "TileExporter.hpp"
+#include "SubassemblyExporter.hpp"
+#include "MeshSimplifier.hpp"
+#include "GeometryDedup.hpp"
+#include "SharedGeometry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <filesystem>
-#include <unordered_map>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
 #include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
 
 #include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools.hxx>
 #include <STEPCAFControl_Reader.hxx>
 
-struct CachedMesh {
-    std::vector<TriBucket> triBuckets;
-    std::vector<EdgeBucket> edgeBuckets;
-    std::vector<RGBA>       materials;
-};
+static void AccumulateMeshCounts(const std::vector<TriBucket>&  tris,
+                                 const std::vector<EdgeBucket>& edges,
+                                 ComponentCost&                 out)
+{
+    for (const auto& b : tris) {
+        out.vertices  += b.vertices.size();
+        out.triangles += b.indices.size() / 3;
+    }
+    for (const auto& e : edges) {
+        out.edgeSegments += e.indices.size() / 2;
+    }
+}
+
+// All files one thumbnail spec wrote for `pngFile`
+static std::uint64_t ThumbnailBytes(const std::string& pngFile, const ThumbnailSpec& spec)
+{
+    std::uint64_t n = 0;
+    for (const auto& f : ThumbnailFiles(pngFile, spec)) n += FileSizeOrZero(f);
+    return n;
+}
+
+// Decimate to `budget` triangles (0 = keep everything) and record the
+// reduction and its error bound
+static void SimplifyToBudget(std::vector<TriBucket>& tris,
+                             std::size_t             budget,
+                             const std::string&      what,
+                             ComponentCost&          out)
+{
+    if (budget == 0) return;
+    const SimplifyStats st = SimplifyBuckets(tris, budget);
+    if (st.trianglesOut == st.trianglesIn) return;
+
+    out.sourceTriangles += st.trianglesIn;
+    out.simplifyError    = std::max(out.simplifyError, st.maxError);
+    std::cout << "📊 Simplified " << what << ": " << st.trianglesIn << " → "
+              << st.trianglesOut << " triangles, max error " << st.maxError << "\n";
+}
+
+// Whole decimal number: no sign, no trailing characters, no overflow
+static bool ParseUnsigned(const char* v, std::uint64_t& out)
+{
+    if (!std::isdigit(static_cast<unsigned char>(*v))) return false;
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtoull(v, &end, 10);
+    return errno == 0 && *end == '\0';
+}
 
 int Exporter::run(int argc, char* argv[])
 {
     if (argc < 2) {
-        std::cerr << "Usage: step2glb input.step [--outdir DIR] [--stats] [--validate]\n";
+        std::cerr << "Usage: stepguru input.step [--outdir DIR] [--stats] [--validate] [--trace FILE.json]\n"
+                     "       [--report FILE.json] [--report-top N]\n"
+                     "       [--max-memory MB] [--low-memory] [--cache-mb MB]\n"
+                     "       [--spill-dir DIR] [--pretty-json]\n"
+                     "       [--buffer-layout single|split|gltf] [--max-buffer-mb MB]\n"
+                     "       [--tiles] [--tile-max-tris N] [--subassembly-glbs] [--shared-bin]\n"
+                     "       [--max-part-tris N] [--max-asm-tris N]\n"
+                     "       [--renderer occt|cpu] [--views iso,front,top,side] [--sprite-sheet]\n"
+                     "       [--render-quality draft|standard|high] [--render-size PX]\n"
+                     "       [--render-budget-ms MS] [--image-format png|qoi|webp]\n"
+                     "       [--png-effort fast|default|best] [--sync-images] [--no-images]\n"
+                     "       [--dedup-geometry] [--bvh]\n"
+                     "       stepguru query DIR box|ray|near ...\n";
         return 1;
     }
 
@@ -45,7 +125,18 @@ int Exporter::run(int argc, char* argv[])
         return 1;
     }
 
-    return exportAssemblyAndComponents(opt) ? 0 : 1;
+    if (!opt.traceFile.empty()) {
+        Trace::Enable(opt.traceFile);
+    }
+
+    bool ok = false;
+    try {
+        ok = exportAssemblyAndComponents(opt);
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Export failed: " << e.what() << "\n";
+    }
+    Trace::Flush();
+    return ok ? 0 : 1;
 }
 
 Exporter::Options Exporter::parseArgs(int argc, char* argv[])
@@ -72,6 +163,99 @@ Exporter::Options Exporter::parseArgs(int argc, char* argv[])
                 o.outDir.push_back('/');
             }
             ++i;
+        } else if (!std::strcmp(argv[i], "--trace") && i+1<argc) {
+            o.traceFile = argv[++i];
+        } else if (!std::strcmp(argv[i], "--report") && i+1<argc) {
+            o.reportFile = argv[++i];
+        } else if (!std::strcmp(argv[i], "--report-top") && i+1<argc) {
+            o.reportTop = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--max-memory") && i+1<argc) {
+            o.maxMemoryBytes = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10))
+                             * 1024 * 1024;
+        } else if (!std::strcmp(argv[i], "--low-memory")) {
+            o.lowMemory = true;
+        } else if (!std::strcmp(argv[i], "--pretty-json")) {
+            o.prettyJson = true;
+        } else if (!std::strcmp(argv[i], "--buffer-layout") && i+1<argc) {
+            const char* v = argv[++i];
+            if      (!std::strcmp(v, "single")) o.bufferLayout = BufferLayout::Single;
+            else if (!std::strcmp(v, "split"))  o.bufferLayout = BufferLayout::Split;
+            else if (!std::strcmp(v, "gltf"))   o.bufferLayout = BufferLayout::Gltf;
+            else std::cerr << "⚠️ Unknown buffer layout '" << v << "', using single\n";
+        } else if (!std::strcmp(argv[i], "--max-buffer-mb") && i+1<argc) {
+            // 0 or a typo would split the BIN at every bucket
+            const char* v = argv[++i];
+            std::uint64_t mb = 0;
+            if (ParseUnsigned(v, mb) && mb > 0 && mb <= (UINT64_MAX >> 20)) {
+                o.maxBufferBytes = mb * 1024 * 1024;
+            } else {
+                std::cerr << "⚠️ Invalid --max-buffer-mb '" << v << "', using "
+                          << (o.maxBufferBytes >> 20) << "\n";
+            }
+        } else if (!std::strcmp(argv[i], "--max-part-tris") && i+1<argc) {
+            o.maxPartTriangles = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--max-asm-tris") && i+1<argc) {
+            o.maxAssemblyTriangles = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--renderer") && i+1<argc) {
+            const char* v = argv[++i];
+            if      (!std::strcmp(v, "occt")) o.renderer = RenderBackend::Occt;
+            else if (!std::strcmp(v, "cpu"))  o.renderer = RenderBackend::Cpu;
+            else std::cerr << "⚠️ Unknown renderer '" << v << "', using occt\n";
+        } else if (!std::strcmp(argv[i], "--views") && i+1<argc) {
+            std::vector<RenderView> views;
+            std::stringstream ss(argv[++i]);
+            std::string tok;
+            while (std::getline(ss, tok, ',')) {
+                RenderView v;
+                if (ParseView(tok.c_str(), v)) views.push_back(v);
+                else std::cerr << "⚠️ Unknown view '" << tok << "', skipped\n";
+            }
+            if (!views.empty()) o.thumbnails.views = views;
+        } else if (!std::strcmp(argv[i], "--sprite-sheet")) {
+            o.thumbnails.spriteSheet = true;
+        } else if (!std::strcmp(argv[i], "--render-quality") && i+1<argc) {
+            const char* v = argv[++i];
+            if      (!std::strcmp(v, "draft"))    o.thumbnails.quality = RenderQuality::Draft;
+            else if (!std::strcmp(v, "standard")) o.thumbnails.quality = RenderQuality::Standard;
+            else if (!std::strcmp(v, "high"))     o.thumbnails.quality = RenderQuality::High;
+            else std::cerr << "⚠️ Unknown render quality '" << v << "', using high\n";
+        } else if (!std::strcmp(argv[i], "--render-size") && i+1<argc) {
+            o.thumbnails.size = std::max(16, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--render-budget-ms") && i+1<argc) {
+            o.renderBudgetSec = std::strtod(argv[++i], nullptr) / 1000.0;
+        } else if (!std::strcmp(argv[i], "--image-format") && i+1<argc) {
+            const char* v = argv[++i];
+            if      (!std::strcmp(v, "png"))  o.thumbnails.encode.format = ImageFormat::Png;
+            else if (!std::strcmp(v, "qoi"))  o.thumbnails.encode.format = ImageFormat::Qoi;
+            else if (!std::strcmp(v, "webp")) o.thumbnails.encode.format = ImageFormat::Webp;
+            else std::cerr << "⚠️ Unknown image format '" << v << "', using png\n";
+        } else if (!std::strcmp(argv[i], "--png-effort") && i+1<argc) {
+            const char* v = argv[++i];
+            if      (!std::strcmp(v, "fast"))    o.thumbnails.encode.effort = PngEffort::Fast;
+            else if (!std::strcmp(v, "default")) o.thumbnails.encode.effort = PngEffort::Default;
+            else if (!std::strcmp(v, "best"))    o.thumbnails.encode.effort = PngEffort::Best;
+            else std::cerr << "⚠️ Unknown PNG effort '" << v << "', using default\n";
+        } else if (!std::strcmp(argv[i], "--sync-images")) {
+            o.asyncImages = false;
+        } else if (!std::strcmp(argv[i], "--no-images")) {
+            o.images = false;
+        } else if (!std::strcmp(argv[i], "--bvh")) {
+            o.bvh = true;
+        } else if (!std::strcmp(argv[i], "--dedup-geometry")) {
+            o.dedupGeometry = true;
+        } else if (!std::strcmp(argv[i], "--shared-bin")) {
+            o.sharedBin = true;
+        } else if (!std::strcmp(argv[i], "--subassembly-glbs")) {
+            o.subassemblies = true;
+        } else if (!std::strcmp(argv[i], "--tiles")) {
+            o.tiles = true;
+        } else if (!std::strcmp(argv[i], "--tile-max-tris") && i+1<argc) {
+            o.tileMaxTriangles = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--spill-dir") && i+1<argc) {
+            o.spillDir = argv[++i];
+        } else if (!std::strcmp(argv[i], "--cache-mb") && i+1<argc) {
+            o.cacheBytes = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10))
+                         * 1024 * 1024;
         }
     }
     return o;
@@ -83,13 +267,36 @@ bool Exporter::exportAssemblyAndComponents(const Options& opt)
     Handle(TDocStd_Document) doc;
     app->NewDocument("MDTV-XCAF", doc);
 
-    STEPCAFControl_Reader reader;
-    if (reader.ReadFile(opt.input.c_str()) != IFSelect_RetDone) {
-        std::cerr << "❌ Cannot read STEP file: " << opt.input << "\n";
-        return false;
+    Trace::Span runSpan("Run", "phase", opt.input);
+
+    MemoryTracker mem;
+    mem.setLimit(opt.maxMemoryBytes);
+
+    // The reader owns the parsed STEP model; scope it so that model is
+    // released as soon as the XCAF document has been populated.
+    {
+        STEPCAFControl_Reader reader;
+        {
+            Trace::Span span("ReadFile", "io", opt.input);
+            std::error_code ec;
+            auto inBytes = std::filesystem::file_size(opt.input, ec);
+            if (!ec) span.setBytes(inBytes);
+            if (reader.ReadFile(opt.input.c_str()) != IFSelect_RetDone) {
+                std::cerr << "❌ Cannot read STEP file: " << opt.input << "\n";
+                return false;
+            }
+        }
+        mem.sample("ReadFile");
+        reader.SetColorMode(true);
+        {
+            Trace::Span span("Transfer");
+            reader.Transfer(doc);
+        }
     }
-    reader.SetColorMode(true);
-    reader.Transfer(doc);
+    if (opt.lowMemory) {
+        ReleaseFreeHeap();
+    }
+    mem.sample("Transfer");
 
     Handle(XCAFDoc_ShapeTool) shapeTool =
         XCAFDoc_DocumentTool::ShapeTool(doc->Main());
@@ -103,58 +310,88 @@ bool Exporter::exportAssemblyAndComponents(const Options& opt)
         return false;
     }
 
+    // Colors, names and referred labels are resolved once per label and
+    // shared by the tree dump, JSON export and both GLB passes
+    LabelResolver labels(shapeTool, colorTool);
+
+    // One OCAF walk; the dump, JSON and component selection below all
+    // read the flattened tree
+    AssemblyIndex index;
+    {
+        Trace::Span span("BuildAssemblyIndex");
+        index.build(roots, labels);
+    }
+    if (opt.printStats) {
+        std::cout << "Assembly index: " << index.size() << " node(s), "
+                  << index.slotCount() << " distinct label(s)\n";
+    }
+
     // Tree dump
     std::cout << "\n================ ASSEMBLY TREE DUMP ================\n";
     {
-        std::set<std::string> visitedDump;
-        for (Standard_Integer r=1; r<=roots.Length(); ++r) {
-            bool isLastRoot = (r == roots.Length());
-            DumpAssemblyTreeDeep(roots.Value(r), shapeTool, colorTool,
-                                 visitedDump, 0, isLastRoot, "");
-        }
+        Trace::Span span("DumpAssemblyTreeDeep");
+        DumpAssemblyTreeDeep(index);
     }
     std::cout << "====================================================\n\n";
+    mem.sample("TreeDump");
 
 
     //----------------- Json Tree dump -----------------------------
     std::cout << "\n JSON → Export\n";
     {
-        TDF_LabelSequence roots;
-        shapeTool->GetFreeShapes(roots);
-
-        if (roots.Length() == 0) {
-            std::cerr << "ERROR: No free shapes in STEP document.\n";
+        std::string jsonOut = opt.outDir  + "assembly.json";
+        std::cout << "\n File: " << jsonOut << std::endl;
+        Trace::Span span("JsonExport", "io", jsonOut);
+        bool jsonOk = JsonExporter::Export(index, index.roots().front(), jsonOut, opt.prettyJson);
+        if (!jsonOk) {
+            std::cerr << "ERROR: Failed to write JSON assembly file\n";
         } else {
-            TDF_Label root = roots.First();
-            std::string jsonOut = opt.outDir  + "assembly.json";
-            std::cout << "\n File: " << jsonOut << std::endl;
-            if (!JsonExporter::Export(root, shapeTool, colorTool, jsonOut)) {
-                std::cerr << "ERROR: Failed to write JSON assembly file\n";
+            std::error_code ec;
+            auto jsonBytes = std::filesystem::file_size(jsonOut, ec);
+            if (!ec) span.setBytes(jsonBytes);
+        }
+
+        // Same structure as a memory-mappable binary (AssemblyBinary.hpp)
+        std::string binOut = opt.outDir + "assembly.bin";
+        std::cout << " File: " << binOut << std::endl;
+        if (!WriteAssemblyBinary(index, index.roots().front(), binOut)) {
+            std::cerr << "ERROR: Failed to write binary assembly file\n";
+        } else if (opt.validate && jsonOk) {
+            CompareAssemblyBinaryWithJson(binOut, jsonOut);
+        }
+
+        // Spatial index over the same nodes, for `stepguru query`. Exact
+        // BRep bounds of every definition are an extra pass, so only on request.
+        if (opt.bvh) {
+            std::string bvhOut = opt.outDir + "assembly.bvh";
+            std::cout << " File: " << bvhOut << std::endl;
+            if (!WriteAssemblyBvh(index, index.roots().front(), bvhOut)) {
+                std::cerr << "ERROR: Failed to write assembly spatial index\n";
             }
         }
     }
 
+    mem.sample("JsonExport");
     //-----------------------------------------------------------
 
 
     // Assembly components (shallow)
-    TDF_LabelSequence assemblyComps;
-    CollectAssemblyComponentsShallow(shapeTool, roots, assemblyComps);
+    const std::vector<std::uint32_t> assemblyComps = index.shallowComponents();
 
     std::vector<TopoDS_Shape> assemblyShapes;
     std::vector<RGBA>         assemblyColors;
-    assemblyShapes.reserve(assemblyComps.Length());
-    assemblyColors.reserve(assemblyComps.Length());
+    assemblyShapes.reserve(assemblyComps.size());
+    assemblyColors.reserve(assemblyComps.size());
 
     RGBA defaultGray{0.7f,0.7f,0.7f,1.0f};
 
-    for (Standard_Integer i=1; i<=assemblyComps.Length(); ++i) {
-        const TDF_Label lab = assemblyComps.Value(i);
-        TopoDS_Shape s = shapeTool->GetShape(lab);
+    for (std::uint32_t n : assemblyComps) {
+        const std::uint32_t slot = index.slot(n);
+        const TopoDS_Shape& s = index.shape(slot);
         if (s.IsNull()) continue;
 
         assemblyShapes.push_back(s);
-        assemblyColors.push_back(ResolveColorRGBA(lab, shapeTool, colorTool, defaultGray));
+        assemblyColors.push_back(index.colorRGBA(slot, defaultGray));
     }
 
     if (assemblyShapes.empty()) {
@@ -166,108 +403,534 @@ bool Exporter::exportAssemblyAndComponents(const Options& opt)
               << " top-level component(s).\n";
 
     // Leaf components (deep)
-    TDF_LabelSequence leafComps;
-    CollectLeafComponentsDeep(shapeTool, roots, leafComps);
-    if (leafComps.Length() == 0) {
+    const std::vector<std::uint32_t> leafComps = index.leafComponents();
+    if (leafComps.empty()) {
         std::cerr << "❌ No leaf components found.\n";
         return false;
     }
-    std::cout << "Found " << leafComps.Length()
+    std::cout << "Found " << leafComps.size()
               << " leaf component instance(s) for per-part export.\n";
 
-    std::string rootPath = LabelPathForFilename(roots.Value(1));
+    const std::uint32_t rootSlot = index.slot(index.roots().front());
+    std::string rootPath = index.path(rootSlot);
+
+    const bool wantReport = !opt.reportFile.empty();
+    CostReport report;
+
+    // Thumbnails are encoded and written on one background thread while
+    // the next part meshes and renders. Their sizes are only known once
+    // the writer is flushed, so the report is filled in at the end.
+    std::unique_ptr<AsyncImageWriter> imageWriter;
+    if (opt.images && opt.asyncImages) imageWriter = std::make_unique<AsyncImageWriter>();
+    std::vector<std::pair<std::string, std::string>> thumbnailFiles;   // report id, file
+    const std::string imageExt = ImageExtension(opt.thumbnails.encode.format);
+
+    // The OCCT backend lives in the render plugin, which is only loaded
+    // here, when thumbnails are wanted from it. Without the plugin the
+    // software rasterizer draws them.
+    RenderBackend renderer = opt.renderer;
+    if (opt.images && renderer == RenderBackend::Occt && !RenderSession::available()) {
+        std::cout << "⚠️  Thumbnails fall back to --renderer cpu\n";
+        renderer = RenderBackend::Cpu;
+    }
+
+    // One OCCT viewer for every thumbnail of the run, set up on first use
+    // (never, with --renderer cpu or --no-images)
+    RenderSession renderSession;
+    renderSession.setImageWriter(imageWriter.get());
+
+    // With a time budget, a thumbnail slower than the budget per view
+    // drops the tier for the ones that follow. The first OCCT image also
+    // pays the session setup and is not judged.
+    ThumbnailSpec thumbSpec = opt.thumbnails;
+    auto throttle = [&](std::chrono::steady_clock::time_point t0, bool warm) {
+        if (opt.renderBudgetSec <= 0.0 || !warm || thumbSpec.quality == RenderQuality::Draft) return;
+        const double perView = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count()
+                             / static_cast<double>(std::max<std::size_t>(thumbSpec.views.size(), 1));
+        if (perView <= opt.renderBudgetSec) return;
+        thumbSpec.quality = (thumbSpec.quality == RenderQuality::High) ? RenderQuality::Standard
+                                                                       : RenderQuality::Draft;
+        std::cout << "⚠️  Thumbnail took " << perView * 1000.0 << " ms per view (budget "
+                  << opt.renderBudgetSec * 1000.0 << " ms), quality lowered to "
+                  << QualityName(thumbSpec.quality) << "\n";
+    };
+
+    // Thumbnails are drawn from the buckets already extracted for the GLB,
+    // so no backend tessellates the BRep again
+    auto renderBuckets = [&](const std::vector<TriBucket>&  tris,
+                             const std::vector<EdgeBucket>& edges,
+                             const std::vector<RGBA>&       materials,
+                             const std::string&             pngFile) {
+        const bool warm = renderer == RenderBackend::Cpu || renderSession.imagesRendered() > 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        const bool ok = (renderer == RenderBackend::Cpu)
+            ? RenderBucketsPNG(tris, edges, materials, pngFile, thumbSpec, imageWriter.get())
+            : renderSession.renderBuckets(tris, edges, materials, pngFile, thumbSpec);
+        throttle(t0, warm);
+        return ok;
+    };
+
+    // Definition-space leaf meshes, shared by the tileset, the assembly and
+    // sub-assembly GLBs, the per-part outputs and geometry.bin. Low-memory
+    // mode bounds the cache by default; --cache-mb overrides.
+    std::size_t cacheBudget = opt.cacheBytes;
+    if (cacheBudget == 0 && opt.lowMemory) {
+        cacheBudget = std::size_t(256) * 1024 * 1024;
+    }
+    LeafMeshes leaves(index, cacheBudget);
+
+    // ──────────────────────────────── Geometry dedup ─────────────────────────────────────
+    // Copy-pasted bodies: a definition whose geometry and color repeat an
+    // earlier one's, up to a rigid motion, is drawn from that one's leaf
+    // mesh by every pass below and shares its per-part files. Shapes are
+    // compared in their definition frames; duplicates.json gives the
+    // matrix between the located component frames the per-part files use.
+    std::unordered_map<std::string, GeometryDuplicate> duplicateOf;
+    if (opt.dedupGeometry) {
+        Trace::Span span("GeometryDedup");
+        GeometryDedup dedup;
+        std::vector<GeometryDuplicate> dups;
+        std::unordered_map<std::string, std::uint32_t> firstNode;   // definition path → component
+        for (std::uint32_t node : leafComps) {
+            const std::uint32_t def = index.def(node);
+            const TopoDS_Shape& s = index.shape(def);
+            const std::string& p = index.path(def);
+            if (s.IsNull() || !firstNode.try_emplace(p, node).second) continue;
+
+            // Same effective color the leaf mesh is drawn with
+            const RGBA col = leaves.ref(node).color;
+            std::uint64_t colorKey = 0;
+            for (float c : {col.r, col.g, col.b, col.a}) {
+                colorKey = (colorKey << 16) | static_cast<std::uint64_t>(std::lround(c * 65535.0f));
+            }
+
+            GeometryDuplicate dup;
+            dup.id = p;
+            if (dedup.add(p, s, colorKey, dup.sameAs, dup.motion)) {
+                const std::uint32_t first = firstNode.at(dup.sameAs);
+                leaves.setDuplicate(def, index.def(first), dup.motion);
+                dup.motion = index.local(node).Multiplied(dup.motion)
+                                              .Multiplied(index.local(first).Inverted());
+                duplicateOf.emplace(p, dup);
+                dups.push_back(dup);
+            }
+        }
+        std::cout << "Geometry dedup: " << dedup.duplicates() << " of " << dedup.definitions()
+                  << " definition(s) repeat another";
+        if (dedup.rejected()) std::cout << " (" << dedup.rejected() << " near miss(es) rejected)";
+        std::cout << "\n";
+        if (!WriteGeometryDuplicates(opt.outDir + "duplicates.json", dups)) {
+            std::cerr << "ERROR: Failed to write duplicates.json\n";
+        }
+        mem.sample("GeometryDedup");
+    }
+
+    // Shared-bin packaging: every leaf definition is stored once, in its own
+    // frame, into geometry.bin (keyed by definition and effective color, as
+    // for the leaf meshes), and each output becomes a .gltf placing those
+    // meshes. The documents are written at the end, once the buffer is.
+    std::unique_ptr<SharedGeometryBuffer> shared;
+    std::vector<std::pair<std::string, std::string>> sharedFiles;   // report id, .gltf
+    if (opt.sharedBin) {
+        shared = std::make_unique<SharedGeometryBuffer>(opt.outDir + "geometry.bin");
+        if (opt.maxPartTriangles || opt.maxAssemblyTriangles || !opt.spillDir.empty()) {
+            std::cout << "⚠️  --max-part-tris, --max-asm-tris and --spill-dir do not apply to --shared-bin\n";
+        }
+    }
+
+    // Every leaf occurrence below n, placed in the frame fromWorld maps
+    // world coordinates into
+    auto sharedPlacements = [&](std::uint32_t n, const gp_Trsf& fromWorld) {
+        std::vector<SharedPlacement> placements;
+        for (std::uint32_t m=n; m<index.subtreeEnd(n); ++m) {
+            if (!leaves.isLeaf(m)) continue;
+            const LeafRef ref = leaves.ref(m);
+            placements.push_back({shared->store(leaves, ref),
+                                  fromWorld.Multiplied(index.world(m)).Multiplied(ref.motion)});
+        }
+        return placements;
+    };
+
+    // Thumbnail buckets of a shared document, read back from geometry.bin
+    auto sharedBuckets = [&](const std::vector<SharedPlacement>& placements,
+                             MaterialRegistry&                   reg,
+                             std::vector<TriBucket>&             tris,
+                             std::vector<EdgeBucket>&            edges) {
+        std::unordered_map<std::uint32_t, CachedMesh> loaded;
+        for (const SharedPlacement& pl : placements) {
+            auto [it, inserted] = loaded.try_emplace(pl.mesh);
+            if (inserted && !shared->load(pl.mesh, it->second)) continue;
+            AppendTransformed(it->second.triBuckets, it->second.edgeBuckets, it->second.materials,
+                              pl.trsf, reg, tris, edges);
+        }
+    };
 
     // ───────────────────────────────── Assembly GLB + PNG ────────────────────────────────
-    {
+    if (shared) {
+        // Placed leaf meshes in world coordinates, like the assembly GLB
+        Trace::Span span("AssemblyOutputs", "phase", rootPath);
+        ComponentCost& cost = report.entry(rootPath);
+        cost.kind      = "assembly";
+        cost.name      = index.nameOr(rootSlot, "Unnamed");
+        cost.instances = 1;
+
+        std::vector<SharedPlacement> placements;
+        {
+            ScopedTimer t(cost.meshSec);
+            for (std::uint32_t r : index.roots()) {
+                std::vector<SharedPlacement> rootPlacements = sharedPlacements(r, gp_Trsf());
+                placements.insert(placements.end(), rootPlacements.begin(), rootPlacements.end());
+            }
+        }
+        if (wantReport) {
+            for (const auto& s : assemblyShapes) CollectFaceStats(s, cost);
+        }
+
+        const std::string pngName = opt.outDir + "image_" + rootPath + "_1" + imageExt;
+        if (opt.images) {
+            MaterialRegistry reg;
+            std::vector<TriBucket>  tris;
+            std::vector<EdgeBucket> edges;
+            sharedBuckets(placements, reg, tris, edges);
+            AccumulateMeshCounts(tris, edges, cost);
+            ScopedTimer t(cost.pngSec);
+            renderBuckets(tris, edges, reg.materials(), pngName);
+            thumbnailFiles.push_back({rootPath, pngName});
+        }
+
+        const std::string gltfName = opt.outDir + "out_" + rootPath + "_1.gltf";
+        shared->addDocument(gltfName, std::move(placements));
+        sharedFiles.push_back({rootPath, gltfName});
+
+        if (assemblyShapes.size() == 1) {
+            std::string stepName = opt.outDir + "out_" + rootPath + "_1.step";
+            { ScopedTimer t(cost.stepSec); ExportShapeToSTEP(roots.Value(1), shapeTool, colorTool, stepName); }
+            cost.stepBytes = FileSizeOrZero(stepName);
+        }
+        mem.sample("AssemblyOutputs");
+    } else {
+        Trace::Span span("AssemblyOutputs", "phase", rootPath);
         MaterialRegistry matRegAssembly;
         std::vector<TriBucket>  triBucketsAsm;
         std::vector<EdgeBucket> edgeBucketsAsm;
 
+        ComponentCost& cost = report.entry(rootPath);
+        cost.kind      = "assembly";
+        cost.name      = index.nameOr(rootSlot, "Unnamed");
+        cost.instances = 1;
+
+        // Out-of-core: each component's buckets go to spill files as soon
+        // as they are composed, so RAM holds one component at a time
+        std::unique_ptr<SpillBucketStore> spill;
+        if (!opt.spillDir.empty()) {
+            spill = std::make_unique<SpillBucketStore>(opt.spillDir);
+        }
+
+        // Each component is composed from the shared leaf meshes in the
+        // frame of its located shape (world, for top-level components).
         // IMPORTANT: use shared MaterialRegistry so each part keeps its color
-        for (std::size_t i=0; i<assemblyShapes.size(); ++i) {
-            MeshShape(assemblyShapes[i], assemblyColors[i],
-                      matRegAssembly, triBucketsAsm, edgeBucketsAsm);
+        {
+            ScopedTimer t(cost.meshSec);
+            for (std::uint32_t c : assemblyComps) {
+                if (index.shape(index.slot(c)).IsNull()) continue;
+                leaves.compose(c, index.local(c).Multiplied(index.world(c).Inverted()),
+                               matRegAssembly, triBucketsAsm, edgeBucketsAsm);
+                if (spill) {
+                    AccumulateMeshCounts(triBucketsAsm, edgeBucketsAsm, cost);
+                    spill->append(triBucketsAsm, edgeBucketsAsm);
+                    triBucketsAsm.clear();
+                    edgeBucketsAsm.clear();
+                }
+            }
+        }
+        if (spill) {
+            std::cout << "Assembly buckets spilled to disk: "
+                      << spill->diskBytes() / (1024*1024) << " MB\n";
+            if (opt.maxAssemblyTriangles) {
+                std::cout << "⚠️  --max-asm-tris is not applied to spilled assembly buckets\n";
+            }
+        } else {
+            {
+                ScopedTimer t(cost.meshSec);
+                SimplifyToBudget(triBucketsAsm, opt.maxAssemblyTriangles, "assembly", cost);
+            }
+            AccumulateMeshCounts(triBucketsAsm, edgeBucketsAsm, cost);
+        }
+        mem.sample("AssemblyMesh", BucketBytes(triBucketsAsm) + BucketBytes(edgeBucketsAsm));
+        if (wantReport) {
+            for (const auto& s : assemblyShapes) CollectFaceStats(s, cost);
         }
 
+        // The thumbnail is drawn before the builder takes the buckets over.
+        // Spilled buckets are not in memory, so OCCT renders the shapes.
+        const std::string pngName = opt.outDir + "image_" + rootPath + "_1" + imageExt;
+        const bool fromBuckets = !spill;
+        if (opt.images && spill && renderer == RenderBackend::Cpu) {
+            std::cout << "⚠️  Spilled assembly buckets are rendered with OCCT\n";
+        }
+        if (opt.images && fromBuckets) {
+            ScopedTimer t(cost.pngSec);
+            renderBuckets(triBucketsAsm, edgeBucketsAsm, matRegAssembly.materials(), pngName);
+        }
+
+        // The builder takes the buckets over; nothing else needs them
         GlbBuilder builder;
-        builder.addBuckets(triBucketsAsm, edgeBucketsAsm, matRegAssembly.materials());
+        builder.setBufferLayout(opt.bufferLayout, opt.maxBufferBytes);
+        if (spill) {
+            builder.addSpilled(*spill, matRegAssembly.materials());
+        } else {
+            builder.addBuckets(std::move(triBucketsAsm), std::move(edgeBucketsAsm),
+                               matRegAssembly.materials());
+        }
         ExportStats stats;
 
         if (assemblyShapes.size() == 1) {
             std::string glbName  = opt.outDir + "out_"   + rootPath + "_1.glb";
-            std::string pngName  = opt.outDir + "image_" + rootPath + "_1.png";
             std::string stepName = opt.outDir + "out_"   + rootPath + "_1.step";
 
             std::cout << "Single component assembly → exporting "
                       << glbName << " and " << pngName << "\n";
 
-            builder.writeGlb(glbName, opt.printStats, stats);
-            RenderPNG({assemblyShapes[0]}, {assemblyColors[0]}, pngName);
-            ExportShapeToSTEP(roots.Value(1), shapeTool, colorTool, stepName);
+            { ScopedTimer t(cost.glbSec);  builder.writeGlb(glbName, opt.printStats, stats); }
+            if (opt.images && !fromBuckets) {
+                ScopedTimer t(cost.pngSec);
+                renderSession.render({assemblyShapes[0]}, {assemblyColors[0]}, pngName, thumbSpec);
+            }
+            { ScopedTimer t(cost.stepSec); ExportShapeToSTEP(roots.Value(1), shapeTool, colorTool, stepName); }
+            cost.glbBytes  = stats.totalBytes;
+            cost.stepBytes = FileSizeOrZero(stepName);
         } else {
             std::string glbName  = opt.outDir + "out_"   + rootPath + "_1.glb";
-            std::string pngName  = opt.outDir + "image_" + rootPath + "_1.png";
 
-            builder.writeGlb(glbName, opt.printStats, stats);
-            RenderPNG(assemblyShapes, assemblyColors, pngName);
+            { ScopedTimer t(cost.glbSec); builder.writeGlb(glbName, opt.printStats, stats); }
+            if (opt.images && !fromBuckets) {
+                ScopedTimer t(cost.pngSec);
+                renderSession.render(assemblyShapes, assemblyColors, pngName, thumbSpec);
+            }
+            cost.glbBytes = stats.totalBytes;
+        }
+        if (opt.images) thumbnailFiles.push_back({rootPath, pngName});
+        if (opt.lowMemory) {
+            for (const auto& s : assemblyShapes) BRepTools::Clean(s);
         }
+        mem.sample("AssemblyOutputs", stats.bufferBytes);
+    }
+
+    // ───────────────────────────────── Tiled assembly (3D Tiles) ─────────────────────────
+    if (opt.tiles) {
+        TileOptions tileOpt;
+        tileOpt.maxTrianglesPerTile = opt.tileMaxTriangles;
+        if (!ExportTileset(index, leaves, index.roots(), opt.outDir + "tiles", tileOpt)) {
+            std::cerr << "ERROR: Failed to write the tileset\n";
+        }
+        if (opt.lowMemory) {
+            ReleaseFreeHeap();
+        }
+        mem.sample("Tileset");
+    }
+
+    // ───────────────────────────────── Sub-assembly GLBs ─────────────────────────────────
+    if (opt.subassemblies) {
+        SubassemblyOptions subOpt;
+        subOpt.bufferLayout   = opt.bufferLayout;
+        subOpt.maxBufferBytes = opt.maxBufferBytes;
+        subOpt.shared         = shared.get();
+        if (!ExportSubassemblies(index, leaves, index.roots(), opt.outDir + "subassemblies", subOpt)) {
+            std::cerr << "ERROR: Failed to write some sub-assembly GLBs\n";
+        }
+        if (opt.lowMemory) {
+            ReleaseFreeHeap();
+        }
+        mem.sample("Subassemblies");
     }
 
     // ────────────────────────────── Per-component GLB / PNG / STEP ──────────────────────
-    std::unordered_map<std::string, CachedMesh> meshCache;
+    bool cacheEnabled = true;
+
+    // Over --max-memory: drop cached meshes and BRep triangulations and
+    // hand the pages back. If that is not enough, stop caching altogether
+    // (the leaf meshes then only live for one component).
+    auto relieveMemoryPressure = [&]() {
+        if (!cacheEnabled) leaves.clear();
+        if (!mem.overLimit()) return;
+        std::cout << "⚠️  RSS " << CurrentRSS() / (1024*1024) << " MB over limit "
+                  << mem.limit() / (1024*1024) << " MB, flushing "
+                  << leaves.cache().size() << " cached mesh(es)\n";
+        Trace::Span span("FlushCaches", "memory");
+        leaves.clear();
+        for (Standard_Integer r=1; r<=roots.Length(); ++r) {
+            BRepTools::Clean(shapeTool->GetShape(roots.Value(r)));
+        }
+        ReleaseFreeHeap();
+        mem.sample("FlushCaches");
+        if (mem.overLimit() && cacheEnabled) {
+            std::cout << "⚠️  Still over limit, mesh cache disabled\n";
+            cacheEnabled = false;
+        }
+    };
 
-    for (Standard_Integer i=1; i<=leafComps.Length(); ++i) {
-        const TDF_Label instLab = leafComps.Value(i);
-        TopoDS_Shape s = shapeTool->GetShape(instLab);
+    for (std::uint32_t node : leafComps) {
+        const std::uint32_t slot = index.slot(node);
+        const TDF_Label& instLab = index.label(slot);
+        const TopoDS_Shape& s = index.shape(slot);
         if (s.IsNull()) continue;
 
-        RGBA col = ResolveColorRGBA(instLab, shapeTool, colorTool, defaultGray);
+        Trace::Span compSpan("Component", "component");
 
-        TDF_Label refLab;
-        bool isInstance = shapeTool->GetReferredShape(instLab, refLab);
-        TDF_Label namingLab = isInstance ? refLab : instLab;
-        std::string p = LabelPathForFilename(namingLab);
+        // Filenames come from the referred (definition) label
+        bool isInstance = index.isInstance(node);
+        const std::uint32_t namingSlot = index.def(node);
+        const std::string& p = index.path(namingSlot);
+        compSpan.setDetail(p);
 
         std::string gname = opt.outDir + "out_"   + p + "_1.glb";
-        std::string pname = opt.outDir + "image_" + p + "_1.png";
+        std::string pname = opt.outDir + "image_" + p + "_1" + imageExt;
         std::string sname = opt.outDir + "out_"   + p + "_1.step";
 
-        CachedMesh localMesh;
-        bool fromCache = false;
+        ComponentCost& cost = report.entry(p);
+        if (cost.instances++ == 0) {
+            cost.name = index.nameOr(namingSlot, "Unnamed");
+        }
 
-        auto it = meshCache.find(p);
-        if (it != meshCache.end()) {
-            localMesh = it->second;
-            fromCache = true;
+        if (auto dup = duplicateOf.find(p); dup != duplicateOf.end()) {
+            // Nothing to mesh or write: the earlier definition's files,
+            // moved by the matrix in duplicates.json, stand in for these
+            if (cost.sameAs.empty()) {
+                cost.sameAs = dup->second.sameAs;
+                std::cout << "\n--- Component " << p << " repeats " << cost.sameAs
+                          << ", outputs shared ---\n";
+            }
+            continue;
         }
 
-        if (!fromCache) {
-            MaterialRegistry localReg;
-            std::vector<TriBucket>  triBuckets;
-            std::vector<EdgeBucket> edgeBuckets;
+        if (shared) {
+            // Repeated definitions share the document written for the first
+            if (cost.instances > 1) continue;
+
+            // Leaf meshes in the frame of the located component shape,
+            // where the per-part GLB has them
+            std::vector<SharedPlacement> placements;
+            {
+                ScopedTimer t(cost.meshSec);
+                placements = sharedPlacements(node, index.local(node).Multiplied(index.world(node).Inverted()));
+            }
+            if (wantReport) CollectFaceStats(s, cost);
+
+            std::cout << "\n--- Exporting component (filename from "
+                      << (isInstance ? "referred" : "instance")
+                      << " label) " << p << " ---\n";
+
+            if (opt.images) {
+                MaterialRegistry reg;
+                std::vector<TriBucket>  tris;
+                std::vector<EdgeBucket> edges;
+                sharedBuckets(placements, reg, tris, edges);
+                AccumulateMeshCounts(tris, edges, cost);
+                ScopedTimer t(cost.pngSec);
+                renderBuckets(tris, edges, reg.materials(), pname);
+                thumbnailFiles.push_back({p, pname});
+            }
 
-            MeshShape(s, col, localReg, triBuckets, edgeBuckets);
+            const std::string gltfName = opt.outDir + "out_" + p + "_1.gltf";
+            shared->addDocument(gltfName, std::move(placements));
+            sharedFiles.push_back({p, gltfName});
 
-            localMesh.triBuckets = std::move(triBuckets);
-            localMesh.edgeBuckets = std::move(edgeBuckets);
-            localMesh.materials   = localReg.materials();
+            { ScopedTimer t(cost.stepSec); ExportShapeToSTEP(instLab, shapeTool, colorTool, sname); }
+            cost.stepBytes = FileSizeOrZero(sname);
 
-            meshCache.emplace(p, localMesh);
+            if (opt.lowMemory) {
+                BRepTools::Clean(s);
+            }
+            relieveMemoryPressure();
+            continue;
+        }
+
+        // The component's leaves, composed from their definition meshes in
+        // the frame of the located component shape
+        MaterialRegistry localReg;
+        std::vector<TriBucket>  triBuckets;
+        std::vector<EdgeBucket> edgeBuckets;
+        {
+            ScopedTimer t(cost.meshSec);
+            leaves.compose(node, index.local(node).Multiplied(index.world(node).Inverted()),
+                           localReg, triBuckets, edgeBuckets);
+            SimplifyToBudget(triBuckets, opt.maxPartTriangles, p, cost);
+        }
+        if (cost.instances == 1) {
+            AccumulateMeshCounts(triBuckets, edgeBuckets, cost);
+            if (wantReport) CollectFaceStats(s, cost);
         }
 
         std::cout << "\n--- Exporting component (filename from "
                   << (isInstance ? "referred" : "instance")
                   << " label) " << p << " ---\n";
 
-        GlbBuilder builder;
-        builder.addBuckets(localMesh.triBuckets,
-                           localMesh.edgeBuckets,
-                           localMesh.materials);
+        if (opt.images) {
+            // Drawn from the buckets before the builder takes them
+            ScopedTimer t(cost.pngSec);
+            renderBuckets(triBuckets, edgeBuckets, localReg.materials(), pname);
+        }
+
         ExportStats stats;
-        builder.writeGlb(gname, opt.printStats, stats);
+        {
+            GlbBuilder builder;
+            builder.setBufferLayout(opt.bufferLayout, opt.maxBufferBytes);
+            builder.addBuckets(std::move(triBuckets), std::move(edgeBuckets), localReg.materials());
+            ScopedTimer t(cost.glbSec);
+            builder.writeGlb(gname, opt.printStats, stats);
+        }
+        { ScopedTimer t(cost.stepSec); ExportShapeToSTEP(instLab, shapeTool, colorTool, sname); }
+        cost.glbBytes  = stats.totalBytes;
+        cost.stepBytes = FileSizeOrZero(sname);
+        if (opt.images) thumbnailFiles.push_back({p, pname});
+
+        // Buckets are extracted and the outputs are on disk: the BRep
+        // triangulation is no longer needed
+        if (opt.lowMemory) {
+            BRepTools::Clean(s);
+        }
+
+        relieveMemoryPressure();
+    }
+    mem.sample("Components", leaves.cache().bytes());
 
-        RenderPNG({s}, {col}, pname);
-        ExportShapeToSTEP(instLab, shapeTool, colorTool, sname);
+    if (imageWriter && !imageWriter->flush()) {
+        std::cerr << "❌ Some thumbnails could not be written\n";
+    }
+    for (const auto& [id, file] : thumbnailFiles) {
+        report.entry(id).pngBytes = ThumbnailBytes(file, thumbSpec);
+    }
+    if (shared) {
+        if (!shared->finish()) {
+            std::cerr << "❌ Shared geometry buffer or some .gltf files could not be written\n";
+        }
+        for (const auto& [id, file] : sharedFiles) {
+            report.entry(id).glbBytes = FileSizeOrZero(file);
+        }
+    }
+    if (leaves.cache().evictions() && opt.printStats) {
+        std::cout << "Mesh cache evictions: " << leaves.cache().evictions()
+                  << " (" << leaves.extracted() << " leaf mesh(es) extracted)\n";
+    }
+
+    if (opt.printStats) {
+        std::cout << "Label cache: " << labels.size() << " label(s), "
+                  << labels.hits() << " hit(s), " << labels.misses() << " miss(es)\n";
+        if (renderSession.imagesRendered()) {
+            std::cout << "Render session: " << renderSession.imagesRendered()
+                      << " image(s) from one viewer\n";
+        }
+        if (imageWriter) {
+            std::cout << "Image writer: " << imageWriter->bytesWritten()
+                      << " byte(s) encoded off the render thread\n";
+        }
+        mem.print();
+    }
+    if (wantReport) {
+        report.setMemory(mem.samples());
+        if (!report.writeJson(opt.reportFile, opt.reportTop)) {
+            std::cerr << "ERROR: Failed to write cost report\n";
+        }
     }
 
     return true;
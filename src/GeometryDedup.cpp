@@ -0,0 +1,405 @@
+#include "GeometryDedup.hpp"
+#include "Trace.hpp"
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/filewritestream.h>
+
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepGProp.hxx>
+#include <BRepTools.hxx>
+#include <BRep_Tool.hxx>
+#include <GProp_GProps.hxx>
+#include <GProp_PrincipalProps.hxx>
+#include <GeomAbs_SurfaceType.hxx>
+#include <Precision.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Vertex.hxx>
+#include <gp_Ax3.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Vec.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace rapidjson;
+
+namespace {
+
+// Invariants are compared relative to the part's size; point samples of
+// a confirmed match may differ by this fraction of its radius
+constexpr double kRelTol = 1e-5;
+
+// Principal moments closer than this (relative to the largest) leave the
+// axes in their plane undetermined
+constexpr double kDegenerateMoments = 1e-3;
+
+// Alignments tried per fingerprint match, for symmetric parts
+constexpr std::size_t kMaxCandidates = 64;
+
+constexpr int kSurfaceTypes = GeomAbs_OtherSurface + 1;
+
+struct Fingerprint {
+    std::array<int, 6>             topology{};   // solids, shells, faces, wires, edges, vertices
+    std::array<int, kSurfaceTypes> surfaces{};   // faces per GeomAbs_SurfaceType
+    std::vector<double> params;                  // radii and angles, sorted
+    double mass   = 0.0;                         // volume, or area without solids
+    double area   = 0.0;
+    std::array<double, 3> moments{};             // about the centroid, ascending
+    double radius = 0.0;                         // farthest sample from the centroid
+
+    std::uint64_t hash() const
+    {
+        std::uint64_t h = 1469598103934665603ull;
+        auto mix = [&](std::uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+        for (int v : topology) mix(static_cast<std::uint64_t>(v));
+        for (int v : surfaces) mix(static_cast<std::uint64_t>(v));
+        return h;
+    }
+};
+
+bool Close(double a, double b, double scale)
+{
+    return std::abs(a - b) <= kRelTol * std::max({std::abs(a), std::abs(b), scale});
+}
+
+int CountOf(const TopoDS_Shape& shape, TopAbs_ShapeEnum type)
+{
+    TopTools_IndexedMapOfShape map;
+    TopExp::MapShapes(shape, type, map);
+    return map.Extent();
+}
+
+gp_Dir Perpendicular(const gp_Vec& v, const gp_Dir& axis)
+{
+    const gp_Vec p = v - gp_Vec(axis) * v.Dot(gp_Vec(axis));
+    if (p.Magnitude() > Precision::Confusion()) return gp_Dir(p);
+    // Any direction across the axis
+    const gp_Dir other = std::abs(axis.X()) < 0.9 ? gp_Dir(1, 0, 0) : gp_Dir(0, 1, 0);
+    return gp_Dir(gp_Vec(axis).Crossed(gp_Vec(other)));
+}
+
+} // namespace
+
+struct GeometryDedup::Entry {
+    std::string         id;
+    std::uint64_t       group = 0;
+    Fingerprint         fp;
+    gp_Pnt              centroid;
+    std::array<gp_Dir, 3> axes;        // principal, in moment order
+    std::vector<gp_Pnt> points;        // vertices + one point per face
+    std::vector<gp_Pnt> sorted;        // points by X, for lookups
+    double              tol = 0.0;
+
+    void build(const TopoDS_Shape& shape)
+    {
+        fp.topology = {CountOf(shape, TopAbs_SOLID), CountOf(shape, TopAbs_SHELL),
+                       CountOf(shape, TopAbs_FACE),  CountOf(shape, TopAbs_WIRE),
+                       CountOf(shape, TopAbs_EDGE),  CountOf(shape, TopAbs_VERTEX)};
+
+        TopTools_IndexedMapOfShape vertices, faces;
+        TopExp::MapShapes(shape, TopAbs_VERTEX, vertices);
+        TopExp::MapShapes(shape, TopAbs_FACE, faces);
+
+        for (int i=1; i<=vertices.Extent(); ++i) {
+            points.push_back(BRep_Tool::Pnt(TopoDS::Vertex(vertices(i))));
+        }
+        for (int i=1; i<=faces.Extent(); ++i) {
+            const TopoDS_Face& face = TopoDS::Face(faces(i));
+            try {
+                BRepAdaptor_Surface surf(face);
+                const GeomAbs_SurfaceType type = surf.GetType();
+                ++fp.surfaces[type];
+                switch (type) {
+                    case GeomAbs_Cylinder: fp.params.push_back(surf.Cylinder().Radius()); break;
+                    case GeomAbs_Sphere:   fp.params.push_back(surf.Sphere().Radius()); break;
+                    case GeomAbs_Cone:
+                        fp.params.push_back(surf.Cone().RefRadius());
+                        fp.params.push_back(surf.Cone().SemiAngle());
+                        break;
+                    case GeomAbs_Torus:
+                        fp.params.push_back(surf.Torus().MajorRadius());
+                        fp.params.push_back(surf.Torus().MinorRadius());
+                        break;
+                    default:
+                        break;
+                }
+                // A point inside the face's parameter box follows the face
+                // through any rigid motion
+                double u1, u2, v1, v2;
+                BRepTools::UVBounds(face, u1, u2, v1, v2);
+                points.push_back(surf.Value(0.5 * (u1 + u2), 0.5 * (v1 + v2)));
+            } catch (const Standard_Failure&) {
+                ++fp.surfaces[GeomAbs_OtherSurface];
+            }
+        }
+        std::sort(fp.params.begin(), fp.params.end());
+
+        GProp_GProps surface;
+        BRepGProp::SurfaceProperties(shape, surface);
+        fp.area = surface.Mass();
+
+        GProp_GProps props;
+        if (fp.topology[0] > 0) {
+            BRepGProp::VolumeProperties(shape, props);
+        } else {
+            props = surface;
+        }
+        fp.mass  = std::abs(props.Mass());
+        centroid = props.CentreOfMass();
+
+        const GProp_PrincipalProps pp = props.PrincipalProperties();
+        std::array<double, 3> m{};
+        pp.Moments(m[0], m[1], m[2]);
+        const std::array<gp_Vec, 3> a = {pp.FirstAxisOfInertia(), pp.SecondAxisOfInertia(),
+                                         pp.ThirdAxisOfInertia()};
+        std::array<int, 3> order = {0, 1, 2};
+        std::sort(order.begin(), order.end(), [&](int x, int y) { return std::abs(m[x]) < std::abs(m[y]); });
+        for (int k=0; k<3; ++k) {
+            fp.moments[k] = std::abs(m[order[k]]);
+            const gp_Vec& axis = a[order[k]];
+            axes[k] = axis.Magnitude() > Precision::Confusion() ? gp_Dir(axis)
+                    : gp_Dir(k == 0 ? 1.0 : 0.0, k == 1 ? 1.0 : 0.0, k == 2 ? 1.0 : 0.0);
+        }
+
+        for (const auto& p : points) fp.radius = std::max(fp.radius, p.Distance(centroid));
+        tol = std::max(Precision::Confusion(), kRelTol * fp.radius);
+
+        sorted = points;
+        std::sort(sorted.begin(), sorted.end(), [](const gp_Pnt& x, const gp_Pnt& y) { return x.X() < y.X(); });
+    }
+
+    // Invariants equal within tolerance
+    bool sameInvariants(const Entry& o) const
+    {
+        const double r = std::max(fp.radius, o.fp.radius);
+        if (fp.topology != o.fp.topology || fp.surfaces != o.fp.surfaces ||
+            fp.params.size() != o.fp.params.size()) return false;
+        if (!Close(fp.radius, o.fp.radius, 0.0) ||
+            !Close(fp.area, o.fp.area, r * r) ||
+            !Close(fp.mass, o.fp.mass, r * r * r)) return false;
+        for (int k=0; k<3; ++k) {
+            if (!Close(fp.moments[k], o.fp.moments[k], fp.moments[2])) return false;
+        }
+        for (std::size_t i=0; i<fp.params.size(); ++i) {
+            if (!Close(fp.params[i], o.fp.params[i], r)) return false;
+        }
+        return true;
+    }
+
+    bool contains(const gp_Pnt& p, double t) const
+    {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), p.X() - t,
+                                   [](const gp_Pnt& q, double x) { return q.X() < x; });
+        for (; it != sorted.end() && it->X() <= p.X() + t; ++it) {
+            if (it->SquareDistance(p) <= t * t) return true;
+        }
+        return false;
+    }
+
+    // Rigid motions onto `b` worth verifying; see the definition
+    void motionsOnto(const Entry& b, std::vector<gp_Trsf>& out) const;
+
+    // Samples at distance `r` from the centroid
+    std::vector<gp_Pnt> samplesAt(double r, double t) const
+    {
+        std::vector<gp_Pnt> out;
+        for (const auto& p : points) {
+            if (std::abs(p.Distance(centroid) - r) <= t) out.push_back(p);
+        }
+        return out;
+    }
+};
+
+GeometryDedup::GeometryDedup() = default;
+GeometryDedup::~GeometryDedup() = default;
+
+// Frames of `b` to pair with one fixed frame of this entry; every rigid
+// motion that can map its principal axes onto b's is among them
+void GeometryDedup::Entry::motionsOnto(const Entry& b, std::vector<gp_Trsf>& out) const
+{
+    const Entry& a = *this;
+    const auto& m = a.fp.moments;
+    const double eps = kDegenerateMoments * std::max(m[2], Precision::Confusion());
+    const bool eq01 = m[1] - m[0] <= eps;
+    const bool eq12 = m[2] - m[1] <= eps;
+    const double t = std::max(a.tol, b.tol);
+
+    auto push = [&](const gp_Ax3& from, const gp_Ax3& to) {
+        if (out.size() >= kMaxCandidates) return;
+        gp_Trsf trsf;
+        trsf.SetDisplacement(from, to);
+        out.push_back(trsf);
+    };
+
+    if (!eq01 && !eq12) {
+        // Distinct moments: the axes are fixed up to their signs
+        const gp_Ax3 from(a.centroid, a.axes[2], a.axes[0]);
+        for (int sz : {1, -1}) {
+            for (int sx : {1, -1}) {
+                const gp_Dir z = sz > 0 ? b.axes[2] : b.axes[2].Reversed();
+                const gp_Dir x = sx > 0 ? b.axes[0] : b.axes[0].Reversed();
+                push(from, gp_Ax3(b.centroid, z, x));
+            }
+        }
+        return;
+    }
+
+    if (eq01 != eq12) {
+        // One symmetry axis: the rotation about it comes from a reference
+        // sample farthest from the axis, matched against b's candidates
+        const gp_Dir ua = eq01 ? a.axes[2] : a.axes[0];
+        const gp_Dir ub = eq01 ? b.axes[2] : b.axes[0];
+        auto radial = [](const gp_Pnt& p, const gp_Pnt& c, const gp_Dir& u, double& h) {
+            const gp_Vec v(c, p);
+            h = v.Dot(gp_Vec(u));
+            return (v - gp_Vec(u) * h).Magnitude();
+        };
+
+        const gp_Pnt* ref = nullptr;
+        double refR = -1.0, refH = 0.0;
+        for (const auto& p : a.points) {
+            double h;
+            const double r = radial(p, a.centroid, ua, h);
+            if (r > refR + t) { ref = &p; refR = r; refH = h; }
+        }
+        if (!ref) return;
+        const gp_Ax3 from(a.centroid, ua, Perpendicular(gp_Vec(a.centroid, *ref), ua));
+
+        for (int s : {1, -1}) {
+            const gp_Dir u = s > 0 ? ub : ub.Reversed();
+            for (const auto& q : b.points) {
+                double h;
+                const double r = radial(q, b.centroid, u, h);
+                if (std::abs(r - refR) > t || std::abs(h - refH) > t) continue;
+                push(from, gp_Ax3(b.centroid, u, Perpendicular(gp_Vec(b.centroid, q), u)));
+            }
+        }
+        return;
+    }
+
+    // No preferred axis (cube-like inertia): two reference samples
+    const gp_Pnt* p1 = nullptr;
+    double r1 = -1.0;
+    for (const auto& p : a.points) {
+        const double r = p.Distance(a.centroid);
+        if (r > r1 + t) { p1 = &p; r1 = r; }
+    }
+    if (!p1 || r1 <= t) return;
+    const gp_Dir d1(gp_Vec(a.centroid, *p1));
+
+    const gp_Pnt* p2 = nullptr;
+    double off2 = -1.0, h2 = 0.0, r2 = 0.0;
+    for (const auto& p : a.points) {
+        const gp_Vec v(a.centroid, p);
+        const double h = v.Dot(gp_Vec(d1));
+        const double off = (v - gp_Vec(d1) * h).Magnitude();
+        if (off > off2 + t) { p2 = &p; off2 = off; h2 = h; r2 = v.Magnitude(); }
+    }
+    const gp_Ax3 from(a.centroid, d1, Perpendicular(gp_Vec(a.centroid, *p2), d1));
+
+    for (const auto& q1 : b.samplesAt(r1, t)) {
+        const gp_Dir e1(gp_Vec(b.centroid, q1));
+        for (const auto& q2 : b.samplesAt(r2, t)) {
+            const gp_Vec v(b.centroid, q2);
+            const double h = v.Dot(gp_Vec(e1));
+            if (std::abs(h - h2) > t || std::abs((v - gp_Vec(e1) * h).Magnitude() - off2) > t) continue;
+            push(from, gp_Ax3(b.centroid, e1, Perpendicular(v, e1)));
+        }
+    }
+}
+
+bool GeometryDedup::add(const std::string& id, const TopoDS_Shape& shape, std::uint64_t group,
+                        std::string& sameAs, gp_Trsf& motion)
+{
+    Trace::Span span("FingerprintShape", "dedup", id);
+    ++m_definitions;
+
+    Entry e;
+    e.id    = id;
+    e.group = group;
+    try {
+        e.build(shape);
+    } catch (const Standard_Failure& ex) {
+        std::cerr << "⚠️  Cannot fingerprint " << id << ": " << ex.GetMessageString() << "\n";
+        return false;
+    }
+    // Nothing to align on: never merged
+    if (e.points.empty() || e.fp.mass <= 0.0) return false;
+
+    const std::uint64_t key = e.fp.hash() ^ (group * 0x9E3779B97F4A7C15ull);
+    std::vector<std::size_t>& bucket = m_buckets[key];
+
+    std::vector<gp_Trsf> candidates;
+    for (std::size_t idx : bucket) {
+        const Entry& c = m_entries[idx];
+        if (c.group != group || !c.sameInvariants(e)) continue;
+
+        candidates.clear();
+        c.motionsOnto(e, candidates);
+        const double t = std::max(c.tol, e.tol);
+        for (const gp_Trsf& trsf : candidates) {
+            bool all = true;
+            for (const auto& p : c.points) {
+                if (!e.contains(p.Transformed(trsf), t)) { all = false; break; }
+            }
+            if (all) {
+                sameAs = c.id;
+                motion = trsf;
+                ++m_duplicates;
+                return true;
+            }
+        }
+        ++m_rejected;
+    }
+
+    bucket.push_back(m_entries.size());
+    m_entries.push_back(std::move(e));
+    return false;
+}
+
+bool WriteGeometryDuplicates(const std::string& file, const std::vector<GeometryDuplicate>& dups)
+{
+    Trace::Span span("WriteDuplicates", "io", file);
+
+    FILE* f = fopen(file.c_str(), "w");
+    if (!f) {
+        std::cerr << "❌ Cannot write " << file << "\n";
+        return false;
+    }
+    char buff[65536];
+    FileWriteStream fs(f, buff, sizeof(buff));
+    PrettyWriter<FileWriteStream> w(fs);
+    w.SetIndent(' ', 2);
+
+    w.StartObject();
+    for (const auto& d : dups) {
+        w.Key(d.id.c_str());
+        w.StartObject();
+        w.Key("sameAs"); w.String(d.sameAs.c_str());
+        // glTF node matrix layout: column-major, translation last
+        w.Key("matrix");
+        w.StartArray();
+        for (int col=1; col<=4; ++col) {
+            for (int row=1; row<=3; ++row) w.Double(d.motion.Value(row, col));
+            w.Double(col == 4 ? 1.0 : 0.0);
+        }
+        w.EndArray();
+        w.EndObject();
+    }
+    w.EndObject();
+    fs.Flush();
+
+    const bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+        std::cerr << "❌ Write failed: " << file << "\n";
+        return false;
+    }
+    return true;
+}
@@ -1,9 +1,22 @@
 #include "GlbBuilder.hpp"
+#include "Trace.hpp"
+#include "GltfJsonWriter.hpp"
 
 #include <fstream>
-#include <sstream>
 #include <cstring>
 #include <chrono>
+#include <filesystem>
+
+namespace {
+
+using Gltf::AccessorType;
+
+int RemapMaterial(int idx, int matBase)
+{
+    return idx >= 0 ? idx + matBase : idx;
+}
+
+} // namespace
 
 void GlbBuilder::addBuckets(const std::vector<TriBucket>& tris,
                             const std::vector<EdgeBucket>& edges,
@@ -16,284 +29,384 @@ void GlbBuilder::addBuckets(const std::vector<TriBucket>& tris,
     // Triangles
     for (const auto& b : tris) {
         if (b.vertices.empty()) continue;
-        TriBucket dst = b;
-        if (dst.materialIndex >= 0) {
-            dst.materialIndex += matBase;
-        }
-        m_triBuckets.push_back(std::move(dst));
+        m_triBuckets.push_back({&b, RemapMaterial(b.materialIndex, matBase)});
     }
 
     // Edges
     for (const auto& e : edges) {
         if (e.vertices.empty()) continue;
-        EdgeBucket dst = e;
-        if (dst.materialIndex >= 0) {
-            dst.materialIndex += matBase;
-        }
-        m_edgeBuckets.push_back(std::move(dst));
+        m_edgeBuckets.push_back({&e, RemapMaterial(e.materialIndex, matBase)});
+    }
+}
+
+void GlbBuilder::addBuckets(std::vector<TriBucket>&&  tris,
+                            std::vector<EdgeBucket>&& edges,
+                            const std::vector<RGBA>&  materials)
+{
+    int matBase = static_cast<int>(m_materials.size());
+    m_materials.insert(m_materials.end(), materials.begin(), materials.end());
+
+    for (auto& b : tris) {
+        if (b.vertices.empty()) continue;
+        m_ownedTris.push_back(std::move(b));
+        const TriBucket& owned = m_ownedTris.back();
+        m_triBuckets.push_back({&owned, RemapMaterial(owned.materialIndex, matBase)});
+    }
+    for (auto& e : edges) {
+        if (e.vertices.empty()) continue;
+        m_ownedEdges.push_back(std::move(e));
+        const EdgeBucket& owned = m_ownedEdges.back();
+        m_edgeBuckets.push_back({&owned, RemapMaterial(owned.materialIndex, matBase)});
     }
+    tris.clear();
+    edges.clear();
+}
+
+void GlbBuilder::addSpilled(const SpillBucketStore& store,
+                            const std::vector<RGBA>& materials)
+{
+    int matBase = static_cast<int>(m_materials.size());
+    m_materials.insert(m_materials.end(), materials.begin(), materials.end());
+    m_spilled.push_back({&store, matBase});
+}
+
+void GlbBuilder::setBufferLayout(BufferLayout layout, std::uint64_t maxBufferBytes)
+{
+    m_layout         = layout;
+    m_maxBufferBytes = maxBufferBytes > 0 ? maxBufferBytes : kDefaultMaxBufferBytes;
 }
 
 bool GlbBuilder::writeGlb(const std::string& filename,
                           bool printStats,
                           ExportStats& outStats)
 {
-    if (m_triBuckets.empty() && m_edgeBuckets.empty()) {
+    if (m_triBuckets.empty() && m_edgeBuckets.empty() && m_spilled.empty()) {
         std::cerr << "[GlbBuilder] No geometry to write for " << filename << "\n";
         return false;
     }
 
+    Trace::Span span("WriteGlb", "io", filename);
     auto tStart = std::chrono::high_resolution_clock::now();
 
-    std::vector<std::uint8_t> bin;
-    bin.reserve(1 << 20);
-
-    struct BufferView {
-        std::uint32_t buffer;
-        std::uint32_t byteOffset;
-        std::uint32_t byteLength;
-        int           target;
+    // BIN is not assembled in memory: the layout pass records where each
+    // bucket array goes and the arrays are streamed straight to the file.
+    struct BinChunk {
+        const void*             data;
+        const SpillBucketStore* store;   // set for out-of-core arrays
+        const SpillArray*       array;
+        std::size_t             bytes;
+        std::uint32_t           buffer;
+    };
+    std::vector<BinChunk>      binChunks;
+    std::vector<std::uint64_t> bufferSizes;   // unpadded, per buffer
+
+    std::vector<Gltf::BufferView> bufferViews;
+    std::vector<Gltf::Accessor>   accessors;
+    std::vector<Gltf::Primitive>  primitives;
+
+    // All arrays of one bucket share a buffer, so each buffer carries whole
+    // primitives and can be fetched on its own. A new buffer is opened when
+    // the next bucket would push the current one past maxBuffer.
+    std::uint64_t maxBuffer = 0;
+    auto beginBucket = [&](std::uint64_t bytes) {
+        if (bufferSizes.empty() ||
+            (bufferSizes.back() > 0 && bufferSizes.back() + bytes > maxBuffer))
+        {
+            bufferSizes.push_back(0);
+        }
     };
-    struct Accessor {
-        int bufferView;
-        int componentType;
-        std::uint32_t count;
-        std::string type;
-        std::array<float,6> bounds;
-        bool hasBounds;
+    auto addView = [&](const void* data, const SpillBucketStore* store, const SpillArray* array,
+                       std::uint64_t bytes, int target) {
+        const std::uint32_t buf = static_cast<std::uint32_t>(bufferSizes.size() - 1);
+        bufferViews.push_back({buf, bufferSizes.back(), bytes, target});
+        binChunks.push_back({data, store, array, static_cast<std::size_t>(bytes), buf});
+        bufferSizes.back() += bytes;
+        return static_cast<int>(bufferViews.size() - 1);
     };
-    struct Primitive {
-        int posAcc;
-        int nrmAcc;
-        int idxAcc;
-        int material;
-        int mode; // 4 = TRIANGLES, 1 = LINES
+    auto appendBin = [&](const void* data, std::size_t bytes, int target) {
+        return addView(data, nullptr, nullptr, bytes, target);
+    };
+    auto appendSpill = [&](const SpillBucketStore& store, const SpillArray& array, int target) {
+        return addView(nullptr, &store, &array, array.size(), target);
     };
 
-    std::vector<BufferView> bufferViews;
-    std::vector<Accessor>   accessors;
-    std::vector<Primitive>  primitives;
+    auto layoutBuckets = [&](std::uint64_t limit) {
+        maxBuffer = limit;
+        binChunks.clear();
+        bufferSizes.clear();
+        bufferViews.clear();
+        accessors.clear();
+        primitives.clear();
 
-    auto appendBin = [&](const void* data, std::size_t bytes) {
-        std::size_t off = bin.size();
-        bin.resize(off + bytes);
-        std::memcpy(bin.data() + off, data, bytes);
-        return off;
-    };
+        // Triangles
+        for (const auto& ref : m_triBuckets) {
+            const TriBucket& b = *ref.bucket;
+            if (b.vertices.empty() || b.indices.empty()) continue;
 
-    // Triangles
-    for (const auto& b : m_triBuckets) {
-        if (b.vertices.empty() || b.indices.empty()) continue;
-
-        std::size_t posOff = appendBin(b.vertices.data(),
-                                       b.vertices.size() * sizeof(Vertex));
-        bufferViews.push_back({0, static_cast<std::uint32_t>(posOff),
-                               static_cast<std::uint32_t>(b.vertices.size() * sizeof(Vertex)),
-                               34962});
-        int posBV = static_cast<int>(bufferViews.size() - 1);
-
-        std::size_t nrmOff = appendBin(b.normals.data(),
-                                       b.normals.size() * sizeof(Normal));
-        bufferViews.push_back({0, static_cast<std::uint32_t>(nrmOff),
-                               static_cast<std::uint32_t>(b.normals.size() * sizeof(Normal)),
-                               34962});
-        int nrmBV = static_cast<int>(bufferViews.size() - 1);
-
-        std::size_t idxOff = appendBin(b.indices.data(),
-                                       b.indices.size() * sizeof(std::uint32_t));
-        bufferViews.push_back({0, static_cast<std::uint32_t>(idxOff),
-                               static_cast<std::uint32_t>(b.indices.size() * sizeof(std::uint32_t)),
-                               34963});
-        int idxBV = static_cast<int>(bufferViews.size() - 1);
-
-        auto vb = calcMinMax(b.vertices, false);
-        auto nb = calcMinMax(b.normals,  true);
-
-        accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(b.vertices.size()), "VEC3", vb, true});
-        int posAcc = static_cast<int>(accessors.size() - 1);
-
-        accessors.push_back({nrmBV, 5126, static_cast<std::uint32_t>(b.normals.size()),  "VEC3", nb, true});
-        int nrmAcc = static_cast<int>(accessors.size() - 1);
-
-        accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(b.indices.size()),  "SCALAR",
-                             {0,0,0,0,0,0}, false});
-        int idxAcc = static_cast<int>(accessors.size() - 1);
-
-        int matIndex = (b.materialIndex >= 0 && b.materialIndex < static_cast<int>(m_materials.size()))
-                     ? b.materialIndex
-                     : 0;
-
-        primitives.push_back({posAcc, nrmAcc, idxAcc, matIndex, 4});
-    }
+            beginBucket(b.vertices.size() * sizeof(Vertex) + b.normals.size() * sizeof(Normal)
+                        + b.indices.size() * sizeof(std::uint32_t));
+            int posBV = appendBin(b.vertices.data(), b.vertices.size() * sizeof(Vertex), 34962);
+            int nrmBV = appendBin(b.normals.data(),  b.normals.size() * sizeof(Normal),  34962);
+            int idxBV = appendBin(b.indices.data(),  b.indices.size() * sizeof(std::uint32_t), 34963);
 
-    // Lines
-    for (const auto& e : m_edgeBuckets) {
-        if (e.vertices.empty() || e.indices.empty()) continue;
+            auto vb = calcMinMax(b.vertices, false);
+            auto nb = calcMinMax(b.normals,  true);
 
-        std::size_t posOff = appendBin(e.vertices.data(),
-                                       e.vertices.size() * sizeof(Vertex));
-        bufferViews.push_back({0, static_cast<std::uint32_t>(posOff),
-                               static_cast<std::uint32_t>(e.vertices.size() * sizeof(Vertex)),
-                               34962});
-        int posBV = static_cast<int>(bufferViews.size() - 1);
+            accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(b.vertices.size()), AccessorType::Vec3, vb, true});
+            int posAcc = static_cast<int>(accessors.size() - 1);
 
-        std::size_t idxOff = appendBin(e.indices.data(),
-                                       e.indices.size() * sizeof(std::uint32_t));
-        bufferViews.push_back({0, static_cast<std::uint32_t>(idxOff),
-                               static_cast<std::uint32_t>(e.indices.size() * sizeof(std::uint32_t)),
-                               34963});
-        int idxBV = static_cast<int>(bufferViews.size() - 1);
+            accessors.push_back({nrmBV, 5126, static_cast<std::uint32_t>(b.normals.size()),  AccessorType::Vec3, nb, true});
+            int nrmAcc = static_cast<int>(accessors.size() - 1);
 
-        auto vb = calcMinMax(e.vertices, false);
+            accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(b.indices.size()),  AccessorType::Scalar,
+                                 {0,0,0,0,0,0}, false});
+            int idxAcc = static_cast<int>(accessors.size() - 1);
 
-        accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(e.vertices.size()), "VEC3", vb, true});
-        int posAcc = static_cast<int>(accessors.size() - 1);
+            int matIndex = (ref.materialIndex >= 0 && ref.materialIndex < static_cast<int>(m_materials.size()))
+                         ? ref.materialIndex
+                         : 0;
 
-        accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(e.indices.size()), "SCALAR",
-                             {0,0,0,0,0,0}, false});
-        int idxAcc = static_cast<int>(accessors.size() - 1);
+            primitives.push_back({posAcc, nrmAcc, idxAcc, matIndex, 4});
+        }
 
-        int matIndex = (e.materialIndex >= 0 && e.materialIndex < static_cast<int>(m_materials.size()))
-                     ? e.materialIndex
-                     : 0;
+        // Lines
+        for (const auto& ref : m_edgeBuckets) {
+            const EdgeBucket& e = *ref.bucket;
+            if (e.vertices.empty() || e.indices.empty()) continue;
 
-        primitives.push_back({posAcc, -1, idxAcc, matIndex, 1});
-    }
+            beginBucket(e.vertices.size() * sizeof(Vertex) + e.indices.size() * sizeof(std::uint32_t));
+            int posBV = appendBin(e.vertices.data(), e.vertices.size() * sizeof(Vertex), 34962);
+            int idxBV = appendBin(e.indices.data(),  e.indices.size() * sizeof(std::uint32_t), 34963);
 
-    // 4-byte align BIN
-    bin.resize(pad4(bin.size()), 0);
-
-    // Build JSON
-    std::ostringstream json;
-    json << "{\n";
-    json << "  \"asset\": {\"version\": \"2.0\", \"generator\": \"step2glb\"},\n";
-    json << "  \"scene\": 0,\n";
-    json << "  \"scenes\": [{\"nodes\": [0]}],\n";
-    json << "  \"nodes\": [{\"mesh\": 0}],\n";
-
-    // Materials
-    json << "  \"materials\": [\n";
-    for (std::size_t i=0; i<m_materials.size(); ++i) {
-        const auto& m = m_materials[i];
-        json << "    {\"pbrMetallicRoughness\": {"
-             << "\"baseColorFactor\": ["
-             << m.r << "," << m.g << "," << m.b << "," << m.a
-             << "], \"metallicFactor\": 0.0, \"roughnessFactor\": 1.0}, "
-             << "\"doubleSided\": true}";
-        if (i + 1 < m_materials.size()) json << ",";
-        json << "\n";
-    }
-    json << "  ],\n";
-
-    // Mesh
-    json << "  \"meshes\": [\n";
-    json << "    {\"primitives\": [\n";
-    for (std::size_t i=0; i<primitives.size(); ++i) {
-        const auto& p = primitives[i];
-        json << "      {\"attributes\": {\"POSITION\": " << p.posAcc;
-        if (p.nrmAcc >= 0) json << ", \"NORMAL\": " << p.nrmAcc;
-        json << "}, \"indices\": " << p.idxAcc
-             << ", \"material\": " << p.material
-             << ", \"mode\": " << p.mode << "}";
-        if (i + 1 < primitives.size()) json << ",";
-        json << "\n";
+            auto vb = calcMinMax(e.vertices, false);
+
+            accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(e.vertices.size()), AccessorType::Vec3, vb, true});
+            int posAcc = static_cast<int>(accessors.size() - 1);
+
+            accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(e.indices.size()), AccessorType::Scalar,
+                                 {0,0,0,0,0,0}, false});
+            int idxAcc = static_cast<int>(accessors.size() - 1);
+
+            int matIndex = (ref.materialIndex >= 0 && ref.materialIndex < static_cast<int>(m_materials.size()))
+                         ? ref.materialIndex
+                         : 0;
+
+            primitives.push_back({posAcc, -1, idxAcc, matIndex, 1});
+        }
+
+        // Out-of-core buckets: same layout, arrays come from the spill files
+        for (const auto& ref : m_spilled) {
+            for (const auto& b : ref.store->tris()) {
+                if (b.vertexCount == 0 || b.indexCount == 0) continue;
+
+                beginBucket(b.vertices.size() + b.normals.size() + b.indices.size());
+                int posBV = appendSpill(*ref.store, b.vertices, 34962);
+                int nrmBV = appendSpill(*ref.store, b.normals,  34962);
+                int idxBV = appendSpill(*ref.store, b.indices,  34963);
+
+                accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(b.vertexCount), AccessorType::Vec3, b.bounds, true});
+                int posAcc = static_cast<int>(accessors.size() - 1);
+                accessors.push_back({nrmBV, 5126, static_cast<std::uint32_t>(b.vertexCount), AccessorType::Vec3, b.normalBounds, true});
+                int nrmAcc = static_cast<int>(accessors.size() - 1);
+                accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(b.indexCount), AccessorType::Scalar,
+                                     {0,0,0,0,0,0}, false});
+                int idxAcc = static_cast<int>(accessors.size() - 1);
+
+                int matIndex = b.materialIndex + ref.matBase;
+                if (matIndex < 0 || matIndex >= static_cast<int>(m_materials.size())) matIndex = 0;
+                primitives.push_back({posAcc, nrmAcc, idxAcc, matIndex, 4});
+            }
+
+            for (const auto& e : ref.store->edges()) {
+                if (e.vertexCount == 0 || e.indexCount == 0) continue;
+
+                beginBucket(e.vertices.size() + e.indices.size());
+                int posBV = appendSpill(*ref.store, e.vertices, 34962);
+                int idxBV = appendSpill(*ref.store, e.indices,  34963);
+
+                accessors.push_back({posBV, 5126, static_cast<std::uint32_t>(e.vertexCount), AccessorType::Vec3, e.bounds, true});
+                int posAcc = static_cast<int>(accessors.size() - 1);
+                accessors.push_back({idxBV, 5125, static_cast<std::uint32_t>(e.indexCount), AccessorType::Scalar,
+                                     {0,0,0,0,0,0}, false});
+                int idxAcc = static_cast<int>(accessors.size() - 1);
+
+                int matIndex = e.materialIndex + ref.matBase;
+                if (matIndex < 0 || matIndex >= static_cast<int>(m_materials.size())) matIndex = 0;
+                primitives.push_back({posAcc, -1, idxAcc, matIndex, 1});
+            }
+        }
+    };
+
+    // External buffers are named after the output file: out_X.glb → out_X_N.bin
+    std::filesystem::path outPath(filename);
+    std::filesystem::path stem = outPath;
+    if (stem.extension() == ".glb" || stem.extension() == ".gltf") stem.replace_extension();
+    auto binPath = [&](std::size_t i) {
+        std::filesystem::path p = stem;
+        p += "_" + std::to_string(i) + ".bin";
+        return p;
+    };
+
+    // Build JSON (4-byte aligned buffers: all arrays are 4-byte types, so
+    // only the tail of each buffer pads)
+    BufferLayout layout = m_layout;
+    std::vector<Gltf::Buffer> buffers;
+    std::string jsonStr;
+    auto buildJson = [&]() {
+        buffers.clear();
+        for (std::size_t i=0; i<bufferSizes.size(); ++i) {
+            buffers.push_back({pad4(bufferSizes[i]),
+                               layout == BufferLayout::Single ? std::string()
+                                                              : binPath(i).filename().string()});
+        }
+        GltfJsonWriter json(GltfJsonWriter::EstimateBytes(m_materials.size(), primitives.size(),
+                                                          bufferViews.size(), accessors.size()));
+        json.writeScene(m_materials, primitives, buffers, bufferViews, accessors);
+        jsonStr = std::move(json.str());
+    };
+
+    layoutBuckets(layout == BufferLayout::Single ? UINT64_MAX : m_maxBufferBytes);
+    // Buckets without indices and empty spill stores add no primitive, and
+    // glTF has no valid encoding for a mesh or buffer with nothing in it
+    if (primitives.empty()) {
+        std::cerr << "[GlbBuilder] No geometry to write for " << filename << "\n";
+        return false;
     }
-    json << "    ]}\n";
-    json << "  ],\n";
-
-    // Buffers
-    json << "  \"buffers\": [ { \"byteLength\": " << bin.size() << " } ],\n";
-
-    // BufferViews
-    json << "  \"bufferViews\": [\n";
-    for (std::size_t i=0; i<bufferViews.size(); ++i) {
-        const auto& bv = bufferViews[i];
-        json << "    {\"buffer\": 0, \"byteOffset\": " << bv.byteOffset
-             << ", \"byteLength\": " << bv.byteLength
-             << ", \"target\": " << bv.target << "}";
-        if (i + 1 < bufferViews.size()) json << ",";
-        json << "\n";
+    buildJson();
+
+    // GLB lengths are uint32: past 4 GB offsets would silently wrap
+    if (layout == BufferLayout::Single &&
+        12 + 8 + pad4(jsonStr.size()) + 8 + buffers[0].byteLength > UINT32_MAX)
+    {
+        std::cerr << "⚠️ " << filename << " exceeds the 4 GB GLB limit, writing external .bin buffers\n";
+        layout = BufferLayout::Split;
+        layoutBuckets(m_maxBufferBytes);
+        buildJson();
     }
-    json << "  ],\n";
-
-    // Accessors
-    json << "  \"accessors\": [\n";
-    for (std::size_t i=0; i<accessors.size(); ++i) {
-        const auto& a = accessors[i];
-        json << "    {\"bufferView\": " << a.bufferView
-             << ", \"componentType\": " << a.componentType
-             << ", \"count\": " << a.count
-             << ", \"type\": \"" << a.type << "\"";
-        if (a.hasBounds) {
-            json << ", \"min\": ["
-                 << a.bounds[0] << "," << a.bounds[1] << "," << a.bounds[2] << "]";
-            json << ", \"max\": ["
-                 << a.bounds[3] << "," << a.bounds[4] << "," << a.bounds[5] << "]";
+
+    // Streams one buffer's arrays plus its tail padding
+    const char zeros[4] = {0, 0, 0, 0};
+    auto writeBuffer = [&](std::ofstream& out, std::uint32_t buf) {
+        for (const auto& c : binChunks) {
+            if (c.buffer != buf) continue;
+            if (c.store) {
+                if (!c.store->copyTo(out, *c.array)) return false;
+            } else {
+                out.write(reinterpret_cast<const char*>(c.data), static_cast<std::streamsize>(c.bytes));
+            }
         }
-        json << "}";
-        if (i + 1 < accessors.size()) json << ",";
-        json << "\n";
-    }
-    json << "  ]\n";
-    json << "}\n";
+        out.write(zeros, static_cast<std::streamsize>(buffers[buf].byteLength - bufferSizes[buf]));
+        return static_cast<bool>(out);
+    };
 
-    std::string jsonStr = json.str();
-    std::size_t jsonLenPadded = pad4(jsonStr.size());
-    jsonStr.resize(jsonLenPadded, ' ');
+    std::string outFile = filename;
+    std::uint64_t totalLen = 0;
 
-    std::uint32_t totalLen = 12 + 8 + static_cast<std::uint32_t>(jsonLenPadded)
-                             + 8 + static_cast<std::uint32_t>(bin.size());
+    if (layout == BufferLayout::Gltf) {
+        std::filesystem::path gltfPath = stem;
+        gltfPath += ".gltf";
+        outFile = gltfPath.string();
 
-    // Write GLB file
-    std::ofstream out(filename, std::ios::binary);
-    if (!out) {
-        std::cerr << "Cannot open output file: " << filename << "\n";
-        return false;
+        std::ofstream out(outFile, std::ios::binary);
+        if (!out) {
+            std::cerr << "Cannot open output file: " << outFile << "\n";
+            return false;
+        }
+        out.write(jsonStr.data(), static_cast<std::streamsize>(jsonStr.size()));
+        if (!out) {
+            std::cerr << "Write failed: " << outFile << "\n";
+            return false;
+        }
+        totalLen = jsonStr.size();
+    } else {
+        std::size_t jsonLenPadded = pad4(jsonStr.size());
+        jsonStr.resize(jsonLenPadded, ' ');
+
+        // Split keeps the GLB container but without a BIN chunk
+        const bool embedBin = layout == BufferLayout::Single;
+        totalLen = 12 + 8 + jsonLenPadded + (embedBin ? 8 + buffers[0].byteLength : 0);
+
+        // Write GLB file
+        std::ofstream out(filename, std::ios::binary);
+        if (!out) {
+            std::cerr << "Cannot open output file: " << filename << "\n";
+            return false;
+        }
+
+        const std::uint32_t magic      = 0x46546C67; // "glTF"
+        const std::uint32_t version    = 2;
+        const std::uint32_t totalLen32 = static_cast<std::uint32_t>(totalLen);
+
+        out.write(reinterpret_cast<const char*>(&magic),   4);
+        out.write(reinterpret_cast<const char*>(&version), 4);
+        out.write(reinterpret_cast<const char*>(&totalLen32),4);
+
+        const std::uint32_t jsonChunkLen  = static_cast<std::uint32_t>(jsonLenPadded);
+        const std::uint32_t jsonChunkType = 0x4E4F534A; // "JSON"
+        out.write(reinterpret_cast<const char*>(&jsonChunkLen), 4);
+        out.write(reinterpret_cast<const char*>(&jsonChunkType),4);
+        out.write(jsonStr.data(), jsonLenPadded);
+
+        bool ok = true;
+        if (embedBin) {
+            const std::uint32_t binChunkLen  = static_cast<std::uint32_t>(buffers[0].byteLength);
+            const std::uint32_t binChunkType = 0x004E4942; // "BIN\0"
+            out.write(reinterpret_cast<const char*>(&binChunkLen), 4);
+            out.write(reinterpret_cast<const char*>(&binChunkType),4);
+            ok = writeBuffer(out, 0);
+        }
+        if (!ok || !out) {
+            std::cerr << "Write failed: " << filename << "\n";
+            return false;
+        }
     }
 
-    const std::uint32_t magic   = 0x46546C67; // "glTF"
-    const std::uint32_t version = 2;
-
-    out.write(reinterpret_cast<const char*>(&magic),   4);
-    out.write(reinterpret_cast<const char*>(&version), 4);
-    out.write(reinterpret_cast<const char*>(&totalLen),4);
-
-    const std::uint32_t jsonChunkLen  = static_cast<std::uint32_t>(jsonLenPadded);
-    const std::uint32_t jsonChunkType = 0x4E4F534A; // "JSON"
-    out.write(reinterpret_cast<const char*>(&jsonChunkLen), 4);
-    out.write(reinterpret_cast<const char*>(&jsonChunkType),4);
-    out.write(jsonStr.data(), jsonLenPadded);
-
-    const std::uint32_t binChunkLen  = static_cast<std::uint32_t>(bin.size());
-    const std::uint32_t binChunkType = 0x004E4942; // "BIN\0"
-    out.write(reinterpret_cast<const char*>(&binChunkLen), 4);
-    out.write(reinterpret_cast<const char*>(&binChunkType),4);
-    if (binChunkLen) {
-        out.write(reinterpret_cast<const char*>(bin.data()), bin.size());
+    if (layout != BufferLayout::Single) {
+        for (std::uint32_t i=0; i<buffers.size(); ++i) {
+            const std::string binFile = binPath(i).string();
+            std::ofstream bin(binFile, std::ios::binary);
+            if (!bin || !writeBuffer(bin, i)) {
+                std::cerr << "Write failed: " << binFile << "\n";
+                return false;
+            }
+            totalLen += buffers[i].byteLength;
+        }
     }
 
     // Stats
     ExportStats st;
-    for (const auto& b : m_triBuckets) {
-        st.vertices  += b.vertices.size();
-        st.triangles += b.indices.size() / 3;
+    for (const auto& ref : m_triBuckets) {
+        st.vertices  += ref.bucket->vertices.size();
+        st.triangles += ref.bucket->indices.size() / 3;
+    }
+    for (const auto& ref : m_edgeBuckets) {
+        st.lines += ref.bucket->indices.size() / 2;
     }
-    for (const auto& e : m_edgeBuckets) {
-        st.lines += e.indices.size() / 2;
+    for (const auto& ref : m_spilled) {
+        for (const auto& b : ref.store->tris()) {
+            st.vertices  += b.vertexCount;
+            st.triangles += b.indexCount / 3;
+        }
+        for (const auto& e : ref.store->edges()) {
+            st.lines += e.indexCount / 2;
+        }
     }
     st.materials   = m_materials.size();
     st.primitives  = primitives.size();
-    st.bufferBytes = bin.size();
+    for (const auto& b : buffers) st.bufferBytes += b.byteLength;
     st.jsonBytes   = jsonStr.size();
     st.totalBytes  = totalLen;
     auto tEnd      = std::chrono::high_resolution_clock::now();
     st.elapsedSec  = std::chrono::duration<double>(tEnd - tStart).count();
 
     if (printStats) {
-        st.print(filename);
+        st.print(outFile);
     }
 
+    span.setBytes(totalLen);
     outStats = st;
-    std::cout << "✅ Export complete: " << filename << "\n";
+    std::cout << "✅ Export complete: " << outFile;
+    if (layout != BufferLayout::Single) std::cout << " (+" << buffers.size() << " .bin)";
+    std::cout << "\n";
     return true;
 }
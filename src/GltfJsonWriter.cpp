@@ -0,0 +1,193 @@
+#include "GltfJsonWriter.hpp"
+
+namespace {
+
+const char* AccessorTypeName(Gltf::AccessorType t)
+{
+    return t == Gltf::AccessorType::Vec3 ? "VEC3" : "SCALAR";
+}
+
+} // namespace
+
+std::size_t GltfJsonWriter::EstimateBytes(std::size_t materials, std::size_t primitives,
+                                          std::size_t bufferViews, std::size_t accessors)
+{
+    // Typical line lengths, with room for long numbers
+    return 512 + materials * 160 + primitives * 110 + bufferViews * 90 + accessors * 200;
+}
+
+void GltfJsonWriter::material(const RGBA& m)
+{
+    *this << "    {\"pbrMetallicRoughness\": {"
+          << "\"baseColorFactor\": ["
+          << m.r << ',' << m.g << ',' << m.b << ',' << m.a
+          << "], \"metallicFactor\": 0.0, \"roughnessFactor\": 1.0}, "
+          << "\"doubleSided\": true}";
+}
+
+void GltfJsonWriter::primitive(const Gltf::Primitive& p)
+{
+    *this << "      {\"attributes\": {\"POSITION\": " << p.posAcc;
+    if (p.nrmAcc >= 0) *this << ", \"NORMAL\": " << p.nrmAcc;
+    *this << "}, \"indices\": " << p.idxAcc
+          << ", \"material\": " << p.material
+          << ", \"mode\": " << p.mode << '}';
+}
+
+void GltfJsonWriter::buffer(const Gltf::Buffer& b)
+{
+    *this << "    {\"byteLength\": " << b.byteLength;
+    if (!b.uri.empty()) {
+        *this << ", \"uri\": ";
+        quoted(b.uri);
+    }
+    *this << '}';
+}
+
+void GltfJsonWriter::bufferView(const Gltf::BufferView& bv)
+{
+    *this << "    {\"buffer\": " << bv.buffer
+          << ", \"byteOffset\": " << bv.byteOffset
+          << ", \"byteLength\": " << bv.byteLength
+          << ", \"target\": " << bv.target << '}';
+}
+
+void GltfJsonWriter::accessor(const Gltf::Accessor& a)
+{
+    *this << "    {\"bufferView\": " << a.bufferView
+          << ", \"componentType\": " << a.componentType
+          << ", \"count\": " << a.count
+          << ", \"type\": \"" << AccessorTypeName(a.type) << '"';
+    if (a.hasBounds) {
+        *this << ", \"min\": ["
+              << a.bounds[0] << ',' << a.bounds[1] << ',' << a.bounds[2] << ']';
+        *this << ", \"max\": ["
+              << a.bounds[3] << ',' << a.bounds[4] << ',' << a.bounds[5] << ']';
+    }
+    *this << '}';
+}
+
+void GltfJsonWriter::node(const Gltf::Node& n)
+{
+    *this << "    {\"mesh\": " << n.mesh;
+    if (n.hasMatrix) {
+        *this << ", \"matrix\": [";
+        for (std::size_t i=0; i<n.matrix.size(); ++i) {
+            if (i) *this << ',';
+            *this << n.matrix[i];
+        }
+        *this << ']';
+    }
+    *this << '}';
+}
+
+void GltfJsonWriter::head(std::size_t nodeCount)
+{
+    *this << "{\n";
+    *this << "  \"asset\": {\"version\": \"2.0\", \"generator\": \"step2glb\"},\n";
+    *this << "  \"scene\": 0,\n";
+    *this << "  \"scenes\": [{\"nodes\": [";
+    for (std::size_t i=0; i<nodeCount; ++i) {
+        if (i) *this << ',';
+        *this << i;
+    }
+    *this << "]}],\n";
+}
+
+void GltfJsonWriter::materialList(const std::vector<RGBA>& materials)
+{
+    *this << "  \"materials\": [\n";
+    list(materials, [&](const RGBA& m) { material(m); });
+    *this << "  ],\n";
+}
+
+void GltfJsonWriter::mesh(const std::vector<Gltf::Primitive>& primitives, bool last)
+{
+    *this << "    {\"primitives\": [\n";
+    list(primitives, [&](const Gltf::Primitive& p) { primitive(p); });
+    *this << "    ]}";
+    if (!last) *this << ',';
+    *this << '\n';
+}
+
+void GltfJsonWriter::tail(const std::vector<Gltf::Buffer>&     buffers,
+                          const std::vector<Gltf::BufferView>& bufferViews,
+                          const std::vector<Gltf::Accessor>&   accessors)
+{
+    // Buffers; the common single GLB-stored buffer stays on one line
+    if (buffers.size() == 1 && buffers[0].uri.empty()) {
+        *this << "  \"buffers\": [ { \"byteLength\": " << buffers[0].byteLength << " } ],\n";
+    } else {
+        *this << "  \"buffers\": [\n";
+        list(buffers, [&](const Gltf::Buffer& b) { buffer(b); });
+        *this << "  ],\n";
+    }
+
+    // BufferViews
+    *this << "  \"bufferViews\": [\n";
+    list(bufferViews, [&](const Gltf::BufferView& bv) { bufferView(bv); });
+    *this << "  ],\n";
+
+    // Accessors
+    *this << "  \"accessors\": [\n";
+    list(accessors, [&](const Gltf::Accessor& a) { accessor(a); });
+    *this << "  ]\n";
+    *this << "}\n";
+}
+
+void GltfJsonWriter::writeScene(const std::vector<RGBA>&            materials,
+                                const std::vector<Gltf::Primitive>&  primitives,
+                                const std::vector<Gltf::Buffer>&     buffers,
+                                const std::vector<Gltf::BufferView>& bufferViews,
+                                const std::vector<Gltf::Accessor>&   accessors)
+{
+    head(1);
+    *this << "  \"nodes\": [{\"mesh\": 0}],\n";
+    materialList(materials);
+
+    *this << "  \"meshes\": [\n";
+    mesh(primitives, true);
+    *this << "  ],\n";
+
+    tail(buffers, bufferViews, accessors);
+}
+
+void GltfJsonWriter::writeInstancedScene(const std::vector<RGBA>&                          materials,
+                                         const std::vector<std::vector<Gltf::Primitive>>&  meshes,
+                                         const std::vector<Gltf::Node>&                    nodes,
+                                         const std::vector<Gltf::Buffer>&                  buffers,
+                                         const std::vector<Gltf::BufferView>&              bufferViews,
+                                         const std::vector<Gltf::Accessor>&                accessors)
+{
+    head(nodes.size());
+    *this << "  \"nodes\": [\n";
+    list(nodes, [&](const Gltf::Node& n) { node(n); });
+    *this << "  ],\n";
+    materialList(materials);
+
+    *this << "  \"meshes\": [\n";
+    for (std::size_t m=0; m<meshes.size(); ++m) mesh(meshes[m], m + 1 == meshes.size());
+    *this << "  ],\n";
+
+    tail(buffers, bufferViews, accessors);
+}
+
+GltfJsonWriter& GltfJsonWriter::quoted(std::string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+    m_out.push_back('"');
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            m_out.push_back('\\');
+            m_out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            m_out.append("\\u00");
+            m_out.push_back(hex[(c >> 4) & 0xF]);
+            m_out.push_back(hex[c & 0xF]);
+        } else {
+            m_out.push_back(c);
+        }
+    }
+    m_out.push_back('"');
+    return *this;
+}
@@ -0,0 +1,915 @@
+#include "ImageWriter.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <queue>
+
+namespace {
+
+// ── Checksums ───────────────────────────────────────────────────────────
+
+const std::array<std::uint32_t, 256>& CrcTable()
+{
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t n=0; n<256; ++n) {
+            std::uint32_t c = n;
+            for (int k=0; k<8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+std::uint32_t Crc32(const std::uint8_t* p, std::size_t n, std::uint32_t crc = 0)
+{
+    const auto& t = CrcTable();
+    crc = ~crc;
+    for (std::size_t i=0; i<n; ++i) crc = t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+std::uint32_t Adler32(const std::uint8_t* p, std::size_t n)
+{
+    std::uint32_t a = 1, b = 0;
+    while (n > 0) {
+        // 5552 is the largest block that cannot overflow b before the modulo
+        const std::size_t block = std::min<std::size_t>(n, 5552);
+        for (std::size_t i=0; i<block; ++i) {
+            a += p[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        p += block;
+        n -= block;
+    }
+    return (b << 16) | a;
+}
+
+// ── Bits and prefix codes (shared by deflate and VP8L) ──────────────────
+
+// LSB-first bit packer. Prefix codes are stored bit-reversed (see
+// PrefixCodes), so every write is a plain put().
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& out) : m_out(out) {}
+
+    void put(std::uint32_t bits, int count)
+    {
+        m_acc |= std::uint64_t(bits) << m_count;
+        m_count += count;
+        while (m_count >= 8) {
+            m_out.push_back(static_cast<std::uint8_t>(m_acc));
+            m_acc >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void flush()
+    {
+        if (m_count > 0) m_out.push_back(static_cast<std::uint8_t>(m_acc));
+        m_acc = 0;
+        m_count = 0;
+    }
+
+private:
+    std::vector<std::uint8_t>& m_out;
+    std::uint64_t m_acc   = 0;
+    int           m_count = 0;
+};
+
+// Huffman code lengths limited to maxBits. At least two symbols always get
+// a length, so every code is complete (both deflate and VP8L decoders
+// reject or special-case single-symbol codes). Over-long trees are
+// rebuilt from flattened frequencies until they fit.
+std::vector<std::uint8_t> HuffmanLengths(std::vector<std::uint32_t> freq, int maxBits)
+{
+    const std::size_t n = freq.size();
+    std::vector<std::uint8_t> lengths(n, 0);
+
+    std::size_t used = 0;
+    for (auto f : freq) used += f > 0;
+    for (std::size_t s=0; s<n && used < 2; ++s) {
+        if (freq[s] == 0) { freq[s] = 1; ++used; }
+    }
+
+    struct Node {
+        std::uint64_t weight;
+        int           parent;
+    };
+    for (;;) {
+        std::vector<Node> nodes;
+        nodes.reserve(2 * n);
+        using Entry = std::pair<std::uint64_t, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        std::vector<int> leaf(n, -1);
+        for (std::size_t s=0; s<n; ++s) {
+            if (freq[s] == 0) continue;
+            leaf[s] = static_cast<int>(nodes.size());
+            heap.push({freq[s], leaf[s]});
+            nodes.push_back({freq[s], -1});
+        }
+        while (heap.size() > 1) {
+            const Entry a = heap.top(); heap.pop();
+            const Entry b = heap.top(); heap.pop();
+            const int parent = static_cast<int>(nodes.size());
+            nodes.push_back({a.first + b.first, -1});
+            nodes[a.second].parent = parent;
+            nodes[b.second].parent = parent;
+            heap.push({a.first + b.first, parent});
+        }
+
+        int longest = 0;
+        for (std::size_t s=0; s<n; ++s) {
+            if (leaf[s] < 0) continue;
+            int depth = 0;
+            for (int k=leaf[s]; nodes[k].parent >= 0; k=nodes[k].parent) ++depth;
+            lengths[s] = static_cast<std::uint8_t>(depth);
+            longest = std::max(longest, depth);
+        }
+        if (longest <= maxBits) return lengths;
+
+        for (auto& f : freq) {
+            if (f) f = (f >> 1) | 1;
+        }
+    }
+}
+
+// Canonical codes for `lengths`, bit-reversed for the LSB-first writer
+std::vector<std::uint16_t> PrefixCodes(const std::vector<std::uint8_t>& lengths)
+{
+    int count[16] = {};
+    for (auto l : lengths) ++count[l];
+    count[0] = 0;
+
+    int next[16] = {};
+    int code = 0;
+    for (int bits=1; bits<16; ++bits) {
+        code = (code + count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+
+    std::vector<std::uint16_t> codes(lengths.size(), 0);
+    for (std::size_t s=0; s<lengths.size(); ++s) {
+        const int len = lengths[s];
+        if (len == 0) continue;
+        const int c = next[len]++;
+        int rev = 0;
+        for (int i=0; i<len; ++i) rev |= ((c >> i) & 1) << (len - 1 - i);
+        codes[s] = static_cast<std::uint16_t>(rev);
+    }
+    return codes;
+}
+
+struct PrefixCode {
+    std::vector<std::uint8_t>  lengths;
+    std::vector<std::uint16_t> codes;
+
+    PrefixCode() = default;
+    PrefixCode(const std::vector<std::uint32_t>& freq, int maxBits)
+        : lengths(HuffmanLengths(freq, maxBits)), codes(PrefixCodes(lengths)) {}
+
+    void put(BitWriter& bw, std::size_t symbol) const { bw.put(codes[symbol], lengths[symbol]); }
+};
+
+// Code-length sequence with run-length symbols: 16 = repeat the previous
+// length 3-6 times (deflate only), 17 = 3-10 zeros, 18 = 11-138 zeros.
+// Each entry is (symbol, extra bits value).
+std::vector<std::pair<int, int>> RunLengthCodeLengths(const std::vector<std::uint8_t>& lengths,
+                                                      bool allowRepeat)
+{
+    std::vector<std::pair<int, int>> out;
+    std::size_t i = 0;
+    while (i < lengths.size()) {
+        const int l = lengths[i];
+        std::size_t run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == l) ++run;
+
+        if (l == 0 && run >= 3) {
+            std::size_t left = run;
+            while (left >= 11) {
+                const std::size_t r = std::min<std::size_t>(left, 138);
+                out.push_back({18, static_cast<int>(r - 11)});
+                left -= r;
+            }
+            if (left >= 3) {
+                out.push_back({17, static_cast<int>(left - 3)});
+                left = 0;
+            }
+            for (; left > 0; --left) out.push_back({0, 0});
+        } else if (l != 0 && allowRepeat && run >= 4) {
+            out.push_back({l, 0});
+            std::size_t left = run - 1;
+            while (left >= 3) {
+                const std::size_t r = std::min<std::size_t>(left, 6);
+                out.push_back({16, static_cast<int>(r - 3)});
+                left -= r;
+            }
+            for (; left > 0; --left) out.push_back({l, 0});
+        } else {
+            for (std::size_t k=0; k<run; ++k) out.push_back({l, 0});
+        }
+        i += run;
+    }
+    return out;
+}
+
+int RunLengthExtraBits(int symbol)
+{
+    return symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0;
+}
+
+// ── Deflate (RFC 1951), dynamic Huffman blocks ──────────────────────────
+
+constexpr std::uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::uint8_t kCodeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+constexpr int kWindow      = 1 << 15;
+constexpr int kMinMatch    = 3;
+constexpr int kMaxMatch    = 258;
+constexpr int kHashBits    = 15;
+constexpr std::size_t kBlockTokens = std::size_t(1) << 16;
+
+struct Token {
+    std::uint16_t length;   // literal byte when dist == 0
+    std::uint16_t dist;
+};
+
+int LengthCode(int length)
+{
+    return static_cast<int>(std::upper_bound(kLengthBase, kLengthBase + 29, length) - kLengthBase) - 1;
+}
+
+int DistCode(int dist)
+{
+    return static_cast<int>(std::upper_bound(kDistBase, kDistBase + 30, dist) - kDistBase) - 1;
+}
+
+std::uint32_t Hash3(const std::uint8_t* p)
+{
+    const std::uint32_t v = std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16);
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// LZ77 over hash chains; `chain` candidates per position, optional
+// one-step lazy evaluation
+std::vector<Token> Tokenize(const std::uint8_t* data, std::size_t n, int chain, bool lazy)
+{
+    std::vector<Token> tokens;
+    tokens.reserve(n / 4 + 16);
+
+    std::vector<std::int64_t> head(std::size_t(1) << kHashBits, -1);
+    std::vector<std::int64_t> prev(kWindow, -1);
+    auto insert = [&](std::size_t pos) {
+        if (pos + kMinMatch > n) return;
+        const std::uint32_t h = Hash3(data + pos);
+        prev[pos & (kWindow - 1)] = head[h];
+        head[h] = static_cast<std::int64_t>(pos);
+    };
+    auto longest = [&](std::size_t i, int& bestDist) {
+        int bestLen = 0;
+        if (i + kMinMatch > n) return 0;
+        const int maxLen = static_cast<int>(std::min<std::size_t>(kMaxMatch, n - i));
+        std::int64_t cand = head[Hash3(data + i)];
+        for (int c=0; c<chain && cand >= 0; ++c) {
+            const std::size_t p = static_cast<std::size_t>(cand);
+            if (i - p > static_cast<std::size_t>(kWindow - 1)) break;
+            if (data[p + bestLen] == data[i + bestLen]) {
+                int len = 0;
+                while (len < maxLen && data[p + len] == data[i + len]) ++len;
+                if (len > bestLen) {
+                    bestLen  = len;
+                    bestDist = static_cast<int>(i - p);
+                    if (len == maxLen) break;
+                }
+            }
+            cand = prev[p & (kWindow - 1)];
+        }
+        return bestLen;
+    };
+
+    std::size_t i = 0;
+    while (i < n) {
+        int dist = 0;
+        int len  = longest(i, dist);
+        if (len >= kMinMatch && lazy && len < kMaxMatch && i + 1 < n) {
+            // A longer match one byte later wins over this one
+            insert(i);
+            int nextDist = 0;
+            const int nextLen = longest(i + 1, nextDist);
+            if (nextLen > len) {
+                tokens.push_back({data[i], 0});
+                ++i;
+                len  = nextLen;
+                dist = nextDist;
+            } else {
+                tokens.push_back({static_cast<std::uint16_t>(len), static_cast<std::uint16_t>(dist)});
+                const std::size_t end = i + static_cast<std::size_t>(len);
+                for (++i; i < end; ++i) insert(i);
+                continue;
+            }
+        }
+
+        if (len >= kMinMatch) {
+            tokens.push_back({static_cast<std::uint16_t>(len), static_cast<std::uint16_t>(dist)});
+            const std::size_t end = i + static_cast<std::size_t>(len);
+            if (chain > 1) {
+                for (; i < end; ++i) insert(i);
+            } else {
+                // Fast mode: only the match start feeds the chains
+                insert(i);
+                i = end;
+            }
+        } else {
+            tokens.push_back({data[i], 0});
+            insert(i);
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+void WriteDeflateBlock(BitWriter& bw, const Token* tok, std::size_t count, bool last)
+{
+    std::vector<std::uint32_t> litFreq(286, 0), distFreq(30, 0);
+    for (std::size_t i=0; i<count; ++i) {
+        if (tok[i].dist == 0) {
+            ++litFreq[tok[i].length];
+        } else {
+            ++litFreq[257 + LengthCode(tok[i].length)];
+            ++distFreq[DistCode(tok[i].dist)];
+        }
+    }
+    litFreq[256] = 1;
+
+    const PrefixCode lit(litFreq, 15), dist(distFreq, 15);
+
+    std::size_t hlit = 286, hdist = 30;
+    while (hlit > 257 && lit.lengths[hlit - 1] == 0) --hlit;
+    while (hdist > 1 && dist.lengths[hdist - 1] == 0) --hdist;
+
+    // Both length sequences go through one run-length pass
+    std::vector<std::uint8_t> all(lit.lengths.begin(), lit.lengths.begin() + hlit);
+    all.insert(all.end(), dist.lengths.begin(), dist.lengths.begin() + hdist);
+    const auto rle = RunLengthCodeLengths(all, true);
+
+    std::vector<std::uint32_t> clFreq(19, 0);
+    for (const auto& [sym, extra] : rle) ++clFreq[sym];
+    const PrefixCode cl(clFreq, 7);
+
+    std::size_t hclen = 19;
+    while (hclen > 4 && cl.lengths[kCodeLengthOrder[hclen - 1]] == 0) --hclen;
+
+    bw.put(last ? 1 : 0, 1);
+    bw.put(2, 2);   // BTYPE = dynamic Huffman
+    bw.put(static_cast<std::uint32_t>(hlit - 257), 5);
+    bw.put(static_cast<std::uint32_t>(hdist - 1), 5);
+    bw.put(static_cast<std::uint32_t>(hclen - 4), 4);
+    for (std::size_t i=0; i<hclen; ++i) bw.put(cl.lengths[kCodeLengthOrder[i]], 3);
+    for (const auto& [sym, extra] : rle) {
+        cl.put(bw, static_cast<std::size_t>(sym));
+        if (const int eb = RunLengthExtraBits(sym)) bw.put(static_cast<std::uint32_t>(extra), eb);
+    }
+
+    for (std::size_t i=0; i<count; ++i) {
+        const Token& t = tok[i];
+        if (t.dist == 0) {
+            lit.put(bw, t.length);
+            continue;
+        }
+        const int lc = LengthCode(t.length);
+        lit.put(bw, 257 + static_cast<std::size_t>(lc));
+        if (kLengthExtra[lc]) bw.put(static_cast<std::uint32_t>(t.length - kLengthBase[lc]), kLengthExtra[lc]);
+        const int dc = DistCode(t.dist);
+        dist.put(bw, static_cast<std::size_t>(dc));
+        if (kDistExtra[dc]) bw.put(static_cast<std::uint32_t>(t.dist - kDistBase[dc]), kDistExtra[dc]);
+    }
+    lit.put(bw, 256);   // end of block
+}
+
+// zlib stream (RFC 1950): tokens are split into blocks of kBlockTokens so
+// the Huffman tables follow the statistics of each region
+std::vector<std::uint8_t> ZlibCompress(const std::uint8_t* data, std::size_t n, PngEffort effort)
+{
+    const int  chain = effort == PngEffort::Fast ? 1 : effort == PngEffort::Default ? 32 : 256;
+    const bool lazy  = effort == PngEffort::Best;
+    const std::vector<Token> tokens = Tokenize(data, n, chain, lazy);
+
+    std::vector<std::uint8_t> out;
+    out.reserve(n / 4 + 64);
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    BitWriter bw(out);
+    std::size_t pos = 0;
+    do {
+        const std::size_t count = std::min(kBlockTokens, tokens.size() - pos);
+        WriteDeflateBlock(bw, tokens.data() + pos, count, pos + count == tokens.size());
+        pos += count;
+    } while (pos < tokens.size());
+    bw.flush();
+
+    const std::uint32_t adler = Adler32(data, n);
+    for (int s=24; s>=0; s-=8) out.push_back(static_cast<std::uint8_t>(adler >> s));
+    return out;
+}
+
+// ── PNG ─────────────────────────────────────────────────────────────────
+
+int Paeth(int a, int b, int c)
+{
+    const int p  = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Filter byte + filtered row for every scanline. Fast uses "up" (and
+// "sub" for the first row); otherwise each row takes the filter with the
+// smallest sum of absolute (signed) residuals.
+std::vector<std::uint8_t> FilterRows(const RgbImage& img, PngEffort effort)
+{
+    const std::size_t stride = static_cast<std::size_t>(img.width) * 3;
+    std::vector<std::uint8_t> out((stride + 1) * static_cast<std::size_t>(img.height));
+    std::vector<std::uint8_t> trial(stride);
+    const std::vector<std::uint8_t> zero(stride, 0);
+
+    for (int y=0; y<img.height; ++y) {
+        const std::uint8_t* cur = img.pixels.data() + static_cast<std::size_t>(y) * stride;
+        const std::uint8_t* up  = y > 0 ? cur - stride : zero.data();
+        std::uint8_t* dst = out.data() + static_cast<std::size_t>(y) * (stride + 1);
+
+        int first = 0, last = 4;
+        if (effort == PngEffort::Fast) first = last = (y == 0) ? 1 : 2;
+
+        long bestCost = -1;
+        for (int f=first; f<=last; ++f) {
+            long cost = 0;
+            for (std::size_t x=0; x<stride; ++x) {
+                const int a = x >= 3 ? cur[x - 3] : 0;
+                const int b = up[x];
+                const int c = x >= 3 ? up[x - 3] : 0;
+                int pred = 0;
+                switch (f) {
+                    case 1: pred = a; break;
+                    case 2: pred = b; break;
+                    case 3: pred = (a + b) / 2; break;
+                    case 4: pred = Paeth(a, b, c); break;
+                    default: break;
+                }
+                const std::uint8_t r = static_cast<std::uint8_t>(cur[x] - pred);
+                trial[x] = r;
+                cost += std::abs(static_cast<std::int8_t>(r));
+            }
+            if (bestCost < 0 || cost < bestCost) {
+                bestCost = cost;
+                dst[0] = static_cast<std::uint8_t>(f);
+                std::memcpy(dst + 1, trial.data(), stride);
+            }
+        }
+    }
+    return out;
+}
+
+void PutU32(std::vector<std::uint8_t>& out, std::uint32_t v)
+{
+    for (int s=24; s>=0; s-=8) out.push_back(static_cast<std::uint8_t>(v >> s));
+}
+
+void PutU32LE(std::vector<std::uint8_t>& out, std::uint32_t v)
+{
+    for (int s=0; s<32; s+=8) out.push_back(static_cast<std::uint8_t>(v >> s));
+}
+
+void PutChunk(std::vector<std::uint8_t>& out, const char type[4],
+              const std::uint8_t* data, std::size_t n)
+{
+    PutU32(out, static_cast<std::uint32_t>(n));
+    const std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (n) out.insert(out.end(), data, data + n);
+    PutU32(out, Crc32(out.data() + start, n + 4));
+}
+
+std::vector<std::uint8_t> EncodePng(const RgbImage& image, PngEffort effort)
+{
+    static const std::uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<std::uint8_t> png(kSignature, kSignature + 8);
+
+    std::vector<std::uint8_t> ihdr;
+    PutU32(ihdr, static_cast<std::uint32_t>(image.width));
+    PutU32(ihdr, static_cast<std::uint32_t>(image.height));
+    ihdr.push_back(8);   // bit depth
+    ihdr.push_back(2);   // color type: RGB
+    ihdr.push_back(0);   // deflate
+    ihdr.push_back(0);   // adaptive filtering
+    ihdr.push_back(0);   // no interlace
+    PutChunk(png, "IHDR", ihdr.data(), ihdr.size());
+
+    const std::vector<std::uint8_t> filtered = FilterRows(image, effort);
+    const std::vector<std::uint8_t> idat = ZlibCompress(filtered.data(), filtered.size(), effort);
+    PutChunk(png, "IDAT", idat.data(), idat.size());
+    PutChunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+// ── QOI ─────────────────────────────────────────────────────────────────
+
+std::vector<std::uint8_t> EncodeQoi(const RgbImage& image)
+{
+    std::vector<std::uint8_t> out;
+    out.reserve(image.pixels.size() / 4 + 32);
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    PutU32(out, static_cast<std::uint32_t>(image.width));
+    PutU32(out, static_cast<std::uint32_t>(image.height));
+    out.push_back(3);   // RGB
+    out.push_back(0);   // sRGB with linear alpha
+
+    std::array<std::array<std::uint8_t, 3>, 64> seen{};
+    std::array<std::uint8_t, 3> prev = {0, 0, 0};
+    // The decoder starts from opaque black and an index of transparent
+    // black, so an all-zero RGB pixel never matches a fresh index slot
+    std::array<bool, 64> valid{};
+    int run = 0;
+
+    const std::size_t count = static_cast<std::size_t>(image.width) * image.height;
+    for (std::size_t i=0; i<count; ++i) {
+        const std::uint8_t* p = &image.pixels[i * 3];
+        const std::array<std::uint8_t, 3> px = {p[0], p[1], p[2]};
+
+        if (px == prev) {
+            if (++run == 62 || i + 1 == count) {
+                out.push_back(static_cast<std::uint8_t>(0xC0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<std::uint8_t>(0xC0 | (run - 1)));
+            run = 0;
+        }
+
+        const int h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+        if (valid[h] && seen[h] == px) {
+            out.push_back(static_cast<std::uint8_t>(h));
+        } else {
+            seen[h]  = px;
+            valid[h] = true;
+            const int dr = static_cast<std::int8_t>(px[0] - prev[0]);
+            const int dg = static_cast<std::int8_t>(px[1] - prev[1]);
+            const int db = static_cast<std::int8_t>(px[2] - prev[2]);
+            const int drg = dr - dg, dbg = db - dg;
+            if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                out.push_back(static_cast<std::uint8_t>(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+            } else if (drg > -9 && drg < 8 && dg > -33 && dg < 32 && dbg > -9 && dbg < 8) {
+                out.push_back(static_cast<std::uint8_t>(0x80 | (dg + 32)));
+                out.push_back(static_cast<std::uint8_t>(((drg + 8) << 4) | (dbg + 8)));
+            } else {
+                out.push_back(0xFE);
+                out.insert(out.end(), px.begin(), px.end());
+            }
+        }
+        prev = px;
+    }
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+}
+
+// ── WebP lossless (VP8L) ────────────────────────────────────────────────
+
+constexpr std::uint8_t kVp8lCodeLengthOrder[19] = {
+    17, 18, 0, 1, 2, 3, 4, 5, 16, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+constexpr int kVp8lMaxLength = 4096;
+
+// VP8L prefix coding of a length or distance value (>= 1)
+void Vp8lPrefix(int value, int& code, int& extraBits, int& extra)
+{
+    const int u = value - 1;
+    if (u < 4) {
+        code = u; extraBits = 0; extra = 0;
+        return;
+    }
+    int h = 31;
+    while (!((u >> h) & 1)) --h;
+    const int second = (u >> (h - 1)) & 1;
+    code      = 2 * h + second;
+    extraBits = h - 1;
+    extra     = u & ((1 << extraBits) - 1);
+}
+
+// One of the five VP8L prefix codes. One- or two-symbol alphabets below
+// 256 use the "simple" form; everything else a normal code whose lengths
+// are themselves coded (no repeat-previous symbol, so no state to track).
+void WriteVp8lCode(BitWriter& bw, const std::vector<std::uint32_t>& freq, PrefixCode& code)
+{
+    std::vector<int> used;
+    for (std::size_t s=0; s<freq.size() && used.size() < 3; ++s) {
+        if (freq[s]) used.push_back(static_cast<int>(s));
+    }
+    if (used.empty()) used.push_back(0);
+
+    if (used.size() <= 2 && used.back() < 256) {
+        code.lengths.assign(freq.size(), 0);
+        code.codes.assign(freq.size(), 0);
+        bw.put(1, 1);                                   // simple code
+        bw.put(static_cast<std::uint32_t>(used.size() - 1), 1);
+        const bool wide0 = used[0] > 1;
+        bw.put(wide0 ? 1 : 0, 1);
+        bw.put(static_cast<std::uint32_t>(used[0]), wide0 ? 8 : 1);
+        if (used.size() == 2) {
+            bw.put(static_cast<std::uint32_t>(used[1]), 8);
+            code.lengths[used[0]] = 1;
+            code.lengths[used[1]] = 1;
+            code.codes[used[1]]   = 1;
+        }
+        return;
+    }
+
+    code = PrefixCode(freq, 15);
+    const auto rle = RunLengthCodeLengths(code.lengths, false);
+    std::vector<std::uint32_t> clFreq(19, 0);
+    for (const auto& [sym, extra] : rle) ++clFreq[sym];
+    const PrefixCode cl(clFreq, 7);
+
+    bw.put(0, 1);                                       // normal code
+    bw.put(19 - 4, 4);
+    for (int i=0; i<19; ++i) bw.put(cl.lengths[kVp8lCodeLengthOrder[i]], 3);
+    bw.put(0, 1);                                       // lengths for every symbol
+    for (const auto& [sym, extra] : rle) {
+        cl.put(bw, static_cast<std::size_t>(sym));
+        if (const int eb = RunLengthExtraBits(sym)) bw.put(static_cast<std::uint32_t>(extra), eb);
+    }
+}
+
+std::vector<std::uint8_t> EncodeWebp(const RgbImage& image)
+{
+    const int W = image.width, H = image.height;
+    const std::size_t count = static_cast<std::size_t>(W) * H;
+    auto argb = [&](std::size_t i) {
+        const std::uint8_t* p = &image.pixels[i * 3];
+        return 0xFF000000u | (std::uint32_t(p[0]) << 16) | (std::uint32_t(p[1]) << 8) | p[2];
+    };
+
+    // Backward references to the previous pixel (distance code 2) or the
+    // pixel above (distance code 1, the first entry of the VP8L distance map)
+    struct Ref {
+        std::uint32_t index;
+        std::uint16_t length;   // 0 = literal
+        std::uint8_t  distCode;
+    };
+    std::vector<Ref> refs;
+    refs.reserve(count / 8 + 16);
+
+    std::vector<std::uint32_t> green(256 + 24, 0), red(256, 0), blue(256, 0), alpha(256, 0), dist(40, 0);
+    std::size_t i = 0;
+    while (i < count) {
+        std::size_t runLeft = 0, runUp = 0;
+        if (i >= 1) {
+            while (i + runLeft < count && runLeft < kVp8lMaxLength && argb(i + runLeft) == argb(i + runLeft - 1)) ++runLeft;
+        }
+        if (i >= static_cast<std::size_t>(W)) {
+            while (i + runUp < count && runUp < kVp8lMaxLength && argb(i + runUp) == argb(i + runUp - W)) ++runUp;
+        }
+        const std::size_t len = std::max(runLeft, runUp);
+        if (len >= 3) {
+            const std::uint8_t dc = runUp >= runLeft ? 1 : 2;
+            refs.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint16_t>(len), dc});
+            int code, eb, extra;
+            Vp8lPrefix(static_cast<int>(len), code, eb, extra);
+            ++green[256 + code];
+            Vp8lPrefix(dc, code, eb, extra);
+            ++dist[code];
+            i += len;
+        } else {
+            const std::uint32_t c = argb(i);
+            refs.push_back({static_cast<std::uint32_t>(i), 0, 0});
+            ++green[(c >> 8) & 0xFF];
+            ++red[(c >> 16) & 0xFF];
+            ++blue[c & 0xFF];
+            ++alpha[c >> 24];
+            ++i;
+        }
+    }
+
+    std::vector<std::uint8_t> payload;
+    payload.reserve(count / 4 + 64);
+    BitWriter bw(payload);
+    bw.put(0x2F, 8);                                    // VP8L signature
+    bw.put(static_cast<std::uint32_t>(W - 1), 14);
+    bw.put(static_cast<std::uint32_t>(H - 1), 14);
+    bw.put(0, 1);                                       // alpha_is_used
+    bw.put(0, 3);                                       // version
+    bw.put(0, 1);                                       // no transforms
+    bw.put(0, 1);                                       // no color cache
+    bw.put(0, 1);                                       // no meta prefix codes
+
+    PrefixCode gc, rc, bc, ac, dcode;
+    WriteVp8lCode(bw, green, gc);
+    WriteVp8lCode(bw, red,   rc);
+    WriteVp8lCode(bw, blue,  bc);
+    WriteVp8lCode(bw, alpha, ac);
+    WriteVp8lCode(bw, dist,  dcode);
+
+    for (const Ref& r : refs) {
+        if (r.length == 0) {
+            const std::uint32_t c = argb(r.index);
+            gc.put(bw, (c >> 8) & 0xFF);
+            rc.put(bw, (c >> 16) & 0xFF);
+            bc.put(bw, c & 0xFF);
+            ac.put(bw, c >> 24);
+            continue;
+        }
+        int code, eb, extra;
+        Vp8lPrefix(r.length, code, eb, extra);
+        gc.put(bw, 256 + static_cast<std::size_t>(code));
+        if (eb) bw.put(static_cast<std::uint32_t>(extra), eb);
+        Vp8lPrefix(r.distCode, code, eb, extra);
+        dcode.put(bw, static_cast<std::size_t>(code));
+        if (eb) bw.put(static_cast<std::uint32_t>(extra), eb);
+    }
+    bw.flush();
+
+    std::vector<std::uint8_t> out;
+    const std::size_t padded = payload.size() + (payload.size() & 1);
+    out.reserve(20 + padded);
+    out.insert(out.end(), {'R', 'I', 'F', 'F'});
+    PutU32LE(out, static_cast<std::uint32_t>(4 + 8 + padded));
+    out.insert(out.end(), {'W', 'E', 'B', 'P', 'V', 'P', '8', 'L'});
+    PutU32LE(out, static_cast<std::uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+    if (payload.size() & 1) out.push_back(0);
+    return out;
+}
+
+bool WriteBytes(const std::vector<std::uint8_t>& bytes, const std::string& file)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out) {
+        std::cerr << "❌ Cannot open " << file << " for writing\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        std::cerr << "❌ Failed to write " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Valid(const RgbImage& image)
+{
+    return image.width > 0 && image.height > 0 &&
+           image.width <= 16384 && image.height <= 16384 &&   // VP8L's 14-bit sizes
+           image.pixels.size() == static_cast<std::size_t>(image.width) * image.height * 3;
+}
+
+} // namespace
+
+const char* ImageExtension(ImageFormat format)
+{
+    switch (format) {
+        case ImageFormat::Png:  return ".png";
+        case ImageFormat::Qoi:  return ".qoi";
+        case ImageFormat::Webp: return ".webp";
+    }
+    return ".png";
+}
+
+std::vector<std::uint8_t> EncodeImage(const RgbImage& image, const ImageEncodeOptions& opt)
+{
+    Trace::Span span("EncodeImage", "io");
+    if (!Valid(image)) return {};
+
+    std::vector<std::uint8_t> out;
+    switch (opt.format) {
+        case ImageFormat::Png:  out = EncodePng(image, opt.effort); break;
+        case ImageFormat::Qoi:  out = EncodeQoi(image);             break;
+        case ImageFormat::Webp: out = EncodeWebp(image);            break;
+    }
+    span.setBytes(out.size());
+    return out;
+}
+
+bool WriteImage(const RgbImage& image, const std::string& file, const ImageEncodeOptions& opt)
+{
+    Trace::Span span("SaveImage", "io", file);
+
+    if (!Valid(image)) {
+        std::cerr << "❌ Invalid image for " << file << "\n";
+        return false;
+    }
+    const std::vector<std::uint8_t> bytes = EncodeImage(image, opt);
+    if (!WriteBytes(bytes, file)) return false;
+    span.setBytes(bytes.size());
+    return true;
+}
+
+std::vector<std::uint8_t> EncodePNG(const RgbImage& image)
+{
+    return EncodeImage(image, ImageEncodeOptions{});
+}
+
+bool WritePNG(const RgbImage& image, const std::string& pngFile)
+{
+    return WriteImage(image, pngFile, ImageEncodeOptions{});
+}
+
+AsyncImageWriter::AsyncImageWriter(std::size_t maxPending)
+    : m_maxPending(std::max<std::size_t>(maxPending, 1)),
+      m_thread([this] { run(); })
+{
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void AsyncImageWriter::submit(RgbImage image, std::string file, const ImageEncodeOptions& opt)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_queue.size() < m_maxPending; });
+    m_queue.push_back({std::move(image), std::move(file), opt});
+    lock.unlock();
+    m_wake.notify_one();
+}
+
+bool AsyncImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_queue.empty() && !m_busy; });
+    const bool ok = m_failures == 0;
+    m_failures = 0;
+    return ok;
+}
+
+std::uint64_t AsyncImageWriter::bytesWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+void AsyncImageWriter::run()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+            // Drain the queue before honouring stop
+            if (m_queue.empty()) return;
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_busy = true;
+        }
+        m_done.notify_all();
+
+        const bool ok = WriteImage(job.image, job.file, job.opt);
+        std::error_code ec;
+        const std::uint64_t bytes = ok ? std::filesystem::file_size(job.file, ec) : 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy = false;
+            if (!ok) ++m_failures;
+            if (!ec) m_bytes += bytes;
+        }
+        m_done.notify_all();
+    }
+}
+
+bool StoreImage(RgbImage&& image, const std::string& file,
+                const ImageEncodeOptions& opt, AsyncImageWriter* async)
+{
+    if (async) {
+        async->submit(std::move(image), file, opt);
+        return true;
+    }
+    return WriteImage(image, file, opt);
+}
@@ -1,34 +1,22 @@
 #include "JsonExporter.hpp"
 #include "XcafTools.hpp"
+#include "LabelResolver.hpp"
+#include "AssemblyIndex.hpp"
+#include "Trace.hpp"
 
-#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/filewritestream.h>
 
 #include <TopoDS_Shape.hxx>
-#include <TopLoc_Location.hxx>
-#include <TDF_Tool.hxx>
-#include <TDataStd_Name.hxx>
+#include <gp_Trsf.hxx>
 #include <XCAFDoc_ShapeTool.hxx>
 #include <XCAFDoc_ColorTool.hxx>
 
-#include <set>
+#include <vector>
 
 using namespace rapidjson;
 
-//------------------------------------------------------------
-// Utility: Label entry "0:1:2:3" → "0-1-2-3"
-//------------------------------------------------------------
-static std::string LabelId(const TDF_Label& lab)
-{
-    TCollection_AsciiString s;
-    TDF_Tool::Entry(lab, s);
-    std::string id = s.ToCString();
-    for (char &c : id)
-        if (c == ':') c = '-';
-    return id;
-}
-
 //------------------------------------------------------------
 // Shape type to string (complete enum for OCCT 7.9.2)
 //------------------------------------------------------------
@@ -50,143 +38,130 @@ static const char* ShapeTypeString(TopAbs_ShapeEnum t)
 }
 
 //------------------------------------------------------------
-// Add gp_Trsf as a 4×4 matrix (OCCT 7.9.2 compliant)
+// Write gp_Trsf as a row-major 4×4 matrix
 //------------------------------------------------------------
-static void AddTransform(Value& parent, const gp_Trsf& T, Document::AllocatorType& alloc)
+template <typename JsonWriter>
+static void WriteTransform(JsonWriter& w, const gp_Trsf& T)
 {
-    Value arr(kArrayType);
-
     gp_Mat R = T.VectorialPart();     // 3×3 rotation
     gp_XYZ t = T.TranslationPart();   // translation
 
-    arr.PushBack(R(1,1), alloc); arr.PushBack(R(1,2), alloc);
-    arr.PushBack(R(1,3), alloc); arr.PushBack(t.X(),   alloc);
-
-    arr.PushBack(R(2,1), alloc); arr.PushBack(R(2,2), alloc);
-    arr.PushBack(R(2,3), alloc); arr.PushBack(t.Y(),   alloc);
-
-    arr.PushBack(R(3,1), alloc); arr.PushBack(R(3,2), alloc);
-    arr.PushBack(R(3,3), alloc); arr.PushBack(t.Z(),   alloc);
+    w.Key("transform");
+    w.StartArray();
+    w.Double(R(1,1)); w.Double(R(1,2)); w.Double(R(1,3)); w.Double(t.X());
+    w.Double(R(2,1)); w.Double(R(2,2)); w.Double(R(2,3)); w.Double(t.Y());
+    w.Double(R(3,1)); w.Double(R(3,2)); w.Double(R(3,3)); w.Double(t.Z());
 
     // Last row
-    arr.PushBack(0.0, alloc);
-    arr.PushBack(0.0, alloc);
-    arr.PushBack(0.0, alloc);
-    arr.PushBack(1.0, alloc);
+    w.Double(0.0); w.Double(0.0); w.Double(0.0); w.Double(1.0);
+    w.EndArray();
+}
 
-    parent.AddMember("transform", arr, alloc);
+template <typename JsonWriter>
+static void WriteString(JsonWriter& w, const std::string& s)
+{
+    w.String(s.c_str(), static_cast<SizeType>(s.size()));
 }
 
 //------------------------------------------------------------
-// Build a definition (unique geometry)
+// Definitions pass: each unique definition once, in the order the
+// instance pass first reaches it
 //------------------------------------------------------------
-static void BuildDefinition(
-    const TDF_Label& defLabel,
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const Handle(XCAFDoc_ColorTool)& colorTool,
-    Value& out,
-    Document::AllocatorType& alloc)
+template <typename JsonWriter>
+static void WriteDefinitions(JsonWriter& w, const AssemblyIndex& index, std::uint32_t rootNode)
 {
-    out.SetObject();
-
-    std::string id = LabelId(defLabel);
-    out.AddMember("id", Value(id.c_str(), alloc), alloc);
-
-    // Name from TDataStd_Name (ExtendedString → AsciiString)
-    Handle(TDataStd_Name) nameAttr;
-    if (defLabel.FindAttribute(TDataStd_Name::GetID(), nameAttr)) {
-        TCollection_AsciiString ascii(nameAttr->Get());
-        out.AddMember("name", Value(ascii.ToCString(), alloc), alloc);
-    } else {
-        out.AddMember("name", "Unnamed", alloc);
-    }
-
-    // Shape + type
-    TopoDS_Shape shape = shapeTool->GetShape(defLabel);
-    out.AddMember("shapeType", Value(ShapeTypeString(shape.ShapeType()), alloc), alloc);
-
-    // Color
-    Quantity_Color col;
-    if (GetEffectiveColor(defLabel, shapeTool, colorTool, col)) {
-        Value c(kArrayType);
-        c.PushBack(col.Red(),   alloc);
-        c.PushBack(col.Green(), alloc);
-        c.PushBack(col.Blue(),  alloc);
-        out.AddMember("color", c, alloc);
-    } else {
-        Value c(kArrayType);
-        c.PushBack(0.8, alloc);
-        c.PushBack(0.8, alloc);
-        c.PushBack(0.8, alloc);
-        out.AddMember("color", c, alloc);
+    std::vector<char> emitted(index.slotCount(), 0);
+
+    w.Key("definitions");
+    w.StartArray();
+    for (std::uint32_t n=rootNode; n<index.subtreeEnd(rootNode); ++n) {
+        const std::uint32_t defSlot = index.def(n);
+        if (emitted[defSlot]) continue;
+        emitted[defSlot] = 1;
+
+        w.StartObject();
+        w.Key("id");
+        WriteString(w, index.path(defSlot));
+
+        // Name from TDataStd_Name (ExtendedString → AsciiString)
+        w.Key("name");
+        if (index.hasName(defSlot)) WriteString(w, index.name(defSlot));
+        else                        w.String("Unnamed");
+
+        w.Key("shapeType");
+        w.String(ShapeTypeString(index.shape(defSlot).ShapeType()));
+
+        w.Key("color");
+        w.StartArray();
+        if (index.hasColor(defSlot)) {
+            const Quantity_Color& col = index.color(defSlot);
+            w.Double(col.Red());
+            w.Double(col.Green());
+            w.Double(col.Blue());
+        } else {
+            w.Double(0.8);
+            w.Double(0.8);
+            w.Double(0.8);
+        }
+        w.EndArray();
+        w.EndObject();
     }
+    w.EndArray();
 }
 
 //------------------------------------------------------------
-// Build instance tree — **corrected logic**
+// Instance pass: pre-order scan of the root's subtree. A node's
+// object stays open (inside its "children" array) until the scan
+// leaves its subtree, so no recursion is needed.
 //------------------------------------------------------------
-static void BuildInstance(
-    const TDF_Label& inst,
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const Handle(XCAFDoc_ColorTool)& colorTool,
-    std::set<std::string>& emittedDefs,
-    Value& outInst,
-    Document::AllocatorType& alloc,
-    Value& defsArray)
+template <typename JsonWriter>
+static void WriteInstances(JsonWriter& w, const AssemblyIndex& index, std::uint32_t rootNode)
 {
-    outInst.SetObject();
-
-    // Instance ID
-    std::string instId = LabelId(inst);
-    outInst.AddMember("id", Value(instId.c_str(), alloc), alloc);
-
-    // Resolve definition label
-    TDF_Label defLabel;
-    if (!XCAFDoc_ShapeTool::GetReferredShape(inst, defLabel))
-        defLabel = inst;   // free-shape root case
-
-    std::string defId = LabelId(defLabel);
-    outInst.AddMember("definitionId", Value(defId.c_str(), alloc), alloc);
-
-    bool isInstance = !defLabel.IsEqual(inst);
-    outInst.AddMember("isInstance", isInstance, alloc);
-
-    // Transform
-    TopLoc_Location L = shapeTool->GetLocation(inst);
-    if (!L.IsIdentity())
-        AddTransform(outInst, L.Transformation(), alloc);
+    std::vector<std::uint32_t> open;
+    auto close = [&]() {
+        w.EndArray();    // children
+        w.EndObject();
+        open.pop_back();
+    };
+
+    w.Key("root");
+    const std::uint32_t end = index.subtreeEnd(rootNode);
+    for (std::uint32_t n=rootNode; n<end; ++n) {
+        while (!open.empty() && n >= index.subtreeEnd(open.back())) close();
+
+        w.StartObject();
+        w.Key("id");
+        WriteString(w, index.path(index.slot(n)));
+
+        // Definition: referred label, or the node itself for a free-shape root
+        w.Key("definitionId");
+        WriteString(w, index.path(index.def(n)));
+        w.Key("isInstance");
+        w.Bool(index.isInstance(n));
+
+        if (!index.hasIdentityLocal(n))
+            WriteTransform(w, index.local(n));
+
+        w.Key("children");
+        w.StartArray();
+        open.push_back(n);
+    }
+    while (!open.empty()) close();
+}
 
-    // Emit definition once
-    if (!emittedDefs.count(defId))
+template <typename JsonWriter>
+static void WriteAssembly(JsonWriter& w, const AssemblyIndex& index, std::uint32_t rootNode)
+{
+    w.StartObject();
     {
-        Value defObj(kObjectType);
-        BuildDefinition(defLabel, shapeTool, colorTool, defObj, alloc);
-        defsArray.PushBack(defObj, alloc);
-        emittedDefs.insert(defId);
+        Trace::Span span("WriteDefinitions", "json");
+        WriteDefinitions(w, index, rootNode);
     }
-
-    //--------------------------------------------------------
-    // **CRITICAL FIX: expand children using the DEFINITION**
-    //--------------------------------------------------------
-    Value children(kArrayType);
-
-    if (shapeTool->IsAssembly(defLabel))
     {
-        TDF_LabelSequence seq;
-        shapeTool->GetComponents(defLabel, seq);
-
-        for (int i = 1; i <= seq.Length(); ++i)
-        {
-            TDF_Label childInst = seq.Value(i);
-
-            Value child(kObjectType);
-            BuildInstance(childInst, shapeTool, colorTool,
-                          emittedDefs, child, alloc, defsArray);
-            children.PushBack(child, alloc);
-        }
+        Trace::Span span("WriteInstances", "json");
+        WriteInstances(w, index, rootNode);
     }
-
-    outInst.AddMember("children", children, alloc);
+    w.EndObject();
 }
 
 //============================================================
@@ -198,33 +173,44 @@ bool Export(
     const TDF_Label& rootLabel,
     const Handle(XCAFDoc_ShapeTool)& shapeTool,
     const Handle(XCAFDoc_ColorTool)& colorTool,
-    const std::string& outputJson)
+    const std::string& outputJson,
+    bool pretty)
 {
-    Document doc;
-    doc.SetObject();
-    auto& alloc = doc.GetAllocator();
-
-    Value defs(kArrayType);
-    Value root(kObjectType);
-    std::set<std::string> emitted;
+    LabelResolver labels(shapeTool, colorTool);
+    TDF_LabelSequence roots;
+    roots.Append(rootLabel);
 
-    BuildInstance(rootLabel, shapeTool, colorTool, emitted, root, alloc, defs);
-
-    doc.AddMember("definitions", defs, alloc);
-    doc.AddMember("root", root, alloc);
+    AssemblyIndex index;
+    index.build(roots, labels);
+    return Export(index, index.roots().front(), outputJson, pretty);
+}
 
+bool Export(
+    const AssemblyIndex& index,
+    std::uint32_t rootNode,
+    const std::string& outputJson,
+    bool pretty)
+{
     FILE* f = fopen(outputJson.c_str(), "w");
     if (!f) return false;
 
+    Trace::Span span("WriteJson", "io", outputJson);
+
     char buff[65536];
     FileWriteStream fs(f, buff, sizeof(buff));
-    PrettyWriter<FileWriteStream> writer(fs);
-    writer.SetIndent(' ', 4);
-
-    doc.Accept(writer);
-    fclose(f);
+    if (pretty) {
+        PrettyWriter<FileWriteStream> writer(fs);
+        writer.SetIndent(' ', 4);
+        WriteAssembly(writer, index, rootNode);
+    } else {
+        Writer<FileWriteStream> writer(fs);
+        WriteAssembly(writer, index, rootNode);
+    }
+    fs.Flush();
 
-    return true;
+    const bool ok = !ferror(f);
+    if (fclose(f) != 0) return false;
+    return ok;
 }
 
 } // namespace JsonExporter
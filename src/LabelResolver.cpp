@@ -0,0 +1,73 @@
+#include "LabelResolver.hpp"
+#include "XcafTools.hpp"
+
+#include <TDataStd_Name.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <mutex>
+
+const LabelInfo& LabelResolver::info(const TDF_Label& label)
+{
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_cache.find(label);
+        if (it != m_cache.end()) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Resolve without holding the lock; OCAF attribute reads are read-only
+    LabelInfo li;
+    li.hasColor = GetEffectiveColor(label, m_shapeTool, m_colorTool, li.color);
+
+    Handle(TDataStd_Name) nameAttr;
+    if (label.FindAttribute(TDataStd_Name::GetID(), nameAttr)) {
+        TCollection_AsciiString ascii(nameAttr->Get());
+        li.hasName = true;
+        li.name    = ascii.ToCString();
+    }
+
+    TDF_Label ref;
+    if (XCAFDoc_ShapeTool::GetReferredShape(label, ref)) {
+        li.referred = ref;
+    }
+
+    std::unique_lock lock(m_mutex);
+    return m_cache.try_emplace(label, std::move(li)).first->second;
+}
+
+bool LabelResolver::color(const TDF_Label& label, Quantity_Color& out)
+{
+    const LabelInfo& li = info(label);
+    if (li.hasColor) out = li.color;
+    return li.hasColor;
+}
+
+RGBA LabelResolver::colorRGBA(const TDF_Label& label, const RGBA& defaultCol)
+{
+    const LabelInfo& li = info(label);
+    if (!li.hasColor) return defaultCol;
+    return RGBA{(float)li.color.Red(), (float)li.color.Green(), (float)li.color.Blue(), 1.0f};
+}
+
+std::string LabelResolver::name(const TDF_Label& label, const std::string& fallback)
+{
+    const LabelInfo& li = info(label);
+    return li.hasName ? li.name : fallback;
+}
+
+bool LabelResolver::referred(const TDF_Label& label, TDF_Label& out)
+{
+    const LabelInfo& li = info(label);
+    if (li.referred.IsNull()) return false;
+    out = li.referred;
+    return true;
+}
+
+std::size_t LabelResolver::size() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_cache.size();
+}
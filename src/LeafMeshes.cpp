@@ -0,0 +1,79 @@
+#include "LeafMeshes.hpp"
+#include "AssemblyIndex.hpp"
+#include "MeshExtractor.hpp"
+
+LeafMeshes::LeafMeshes(const AssemblyIndex& index, std::size_t cacheBytes)
+    : m_index(index), m_cache(cacheBytes)
+{
+}
+
+bool LeafMeshes::isLeaf(std::uint32_t n) const
+{
+    return m_index.firstChild(n) == AssemblyIndex::kNone
+        && !m_index.shape(m_index.def(n)).IsNull();
+}
+
+LeafRef LeafMeshes::ref(std::uint32_t n) const
+{
+    const RGBA defaultGray{0.7f, 0.7f, 0.7f, 1.0f};
+    const std::uint32_t def  = m_index.def(n);
+    const std::uint32_t slot = m_index.slot(n);
+
+    // The occurrence's own color wins over the definition's. A duplicate
+    // keeps its color but is drawn from the definition it repeats.
+    LeafRef r;
+    r.def   = def;
+    r.color = m_index.hasColor(slot) ? m_index.colorRGBA(slot, defaultGray)
+                                     : m_index.colorRGBA(def, defaultGray);
+    if (auto it = m_sameAs.find(def); it != m_sameAs.end()) {
+        r.def    = it->second.first;
+        r.motion = it->second.second;
+    }
+    r.key   = m_index.path(r.def) + "#" + std::to_string(MaterialRegistry::pack(r.color));
+    return r;
+}
+
+void LeafMeshes::setDuplicate(std::uint32_t dup, std::uint32_t sameAs, const gp_Trsf& motion)
+{
+    m_sameAs.insert_or_assign(dup, std::make_pair(sameAs, motion));
+}
+
+const CachedMesh& LeafMeshes::mesh(const LeafRef& r)
+{
+    if (const CachedMesh* hit = m_cache.find(r.key)) return *hit;
+
+    CachedMesh mesh;
+    MaterialRegistry reg;
+    {
+        // Extraction grows its buffers in the arena; the copy below moves
+        // the final, exactly-sized arrays to the default heap
+        std::vector<TriBucket>  tris;
+        std::vector<EdgeBucket> edges;
+        MeshShape(m_index.shape(r.def), r.color, reg, tris, edges, m_arena.resource());
+        mesh.triBuckets  = tris;
+        mesh.edgeBuckets = edges;
+    }
+    m_arena.reset();
+    mesh.materials = reg.materials();
+    ++m_extracted;
+    return m_cache.insert(r.key, std::move(mesh));
+}
+
+std::size_t LeafMeshes::compose(std::uint32_t            n,
+                                const gp_Trsf&           fromWorld,
+                                MaterialRegistry&        reg,
+                                std::vector<TriBucket>&  tris,
+                                std::vector<EdgeBucket>& edges)
+{
+    std::size_t placed = 0;
+    for (std::uint32_t m=n; m<m_index.subtreeEnd(n); ++m) {
+        if (!isLeaf(m)) continue;
+        const LeafRef r = ref(m);
+        const CachedMesh& leaf = mesh(r);
+        AppendTransformed(leaf.triBuckets, leaf.edgeBuckets, leaf.materials,
+                          fromWorld.Multiplied(m_index.world(m)).Multiplied(r.motion),
+                          reg, tris, edges);
+        ++placed;
+    }
+    return placed;
+}
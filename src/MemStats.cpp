@@ -0,0 +1,105 @@
+#include "MemStats.hpp"
+#include "Trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(__linux__)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+// Value of a "Key:   1234 kB" line in /proc/self/status, in bytes
+static std::size_t ProcStatusBytes(const char* key)
+{
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    const std::size_t keyLen = std::char_traits<char>::length(key);
+    while (std::getline(in, line)) {
+        if (line.compare(0, keyLen, key) == 0) {
+            std::istringstream ss(line.substr(keyLen));
+            std::size_t kb = 0;
+            ss >> kb;
+            return kb * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+std::size_t CurrentRSS()
+{
+#if defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return static_cast<std::size_t>(info.resident_size);
+    }
+    return 0;
+#elif defined(__linux__)
+    return ProcStatusBytes("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+std::size_t PeakRSS()
+{
+#if defined(__APPLE__)
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return static_cast<std::size_t>(ru.ru_maxrss);   // bytes on macOS
+#elif defined(__linux__)
+    return ProcStatusBytes("VmHWM:");
+#else
+    return 0;
+#endif
+}
+
+void ReleaseFreeHeap()
+{
+#if defined(__linux__) && defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+void MemoryTracker::sample(const std::string& phase, std::size_t trackedBytes)
+{
+    MemSample s;
+    s.phase        = phase;
+    s.rssBytes     = CurrentRSS();
+    s.peakRssBytes = PeakRSS();
+    s.trackedBytes = trackedBytes;
+    m_samples.push_back(s);
+
+    Trace::Counter("rssMB",     s.rssBytes     / (1024.0 * 1024.0));
+    Trace::Counter("trackedMB", s.trackedBytes / (1024.0 * 1024.0));
+}
+
+void MemoryTracker::print() const
+{
+    auto mb = [](std::size_t b) { return b / (1024.0 * 1024.0); };
+
+    std::cout << "\n--- Memory by phase (MB) ---\n"
+              << std::left << std::setw(22) << "Phase"
+              << std::right << std::setw(10) << "RSS"
+              << std::setw(10) << "Peak"
+              << std::setw(10) << "Tracked" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& s : m_samples) {
+        std::cout << std::left << std::setw(22) << s.phase
+                  << std::right << std::setw(10) << mb(s.rssBytes)
+                  << std::setw(10) << mb(s.peakRssBytes)
+                  << std::setw(10) << mb(s.trackedBytes) << "\n";
+    }
+    if (m_limit) {
+        std::cout << "Limit: " << mb(m_limit) << " MB\n";
+    }
+    std::cout << "----------------------------\n\n";
+}
@@ -0,0 +1,9 @@
+#include "MeshArena.hpp"
+
+std::pmr::memory_resource* MeshArena::ThreadPool()
+{
+    // Pool blocks up to 16 MB so arena growth chunks are recycled too
+    thread_local std::pmr::unsynchronized_pool_resource pool(
+        std::pmr::pool_options{0, std::size_t(1) << 24});
+    return &pool;
+}
@@ -0,0 +1,41 @@
+#include "MeshCache.hpp"
+
+const CachedMesh* MeshCache::find(const std::string& key)
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &it->second->second;
+}
+
+const CachedMesh& MeshCache::insert(const std::string& key, CachedMesh mesh)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes -= it->second->second.bytes();
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_bytes += mesh.bytes();
+    m_lru.emplace_front(key, std::move(mesh));
+    m_index.emplace(key, m_lru.begin());
+
+    while (m_maxBytes != 0 && m_bytes > m_maxBytes && m_lru.size() > 1) {
+        Entry& victim = m_lru.back();
+        m_bytes -= victim.second.bytes();
+        m_index.erase(victim.first);
+        m_lru.pop_back();
+        ++m_evictions;
+    }
+    return m_lru.front().second;
+}
+
+void MeshCache::clear()
+{
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
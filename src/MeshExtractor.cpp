@@ -1,4 +1,5 @@
 #include "MeshExtractor.hpp"
+#include "Trace.hpp"
 
 #include <BRepMesh_IncrementalMesh.hxx>
 #include <BRep_Tool.hxx>
@@ -14,6 +15,7 @@
 #include <GCPnts_AbscissaPoint.hxx>
 #include <gp_Pnt.hxx>
 #include <gp_Vec.hxx>
+#include <gp_Mat.hxx>
 #include <Standard_Failure.hxx>
 #include <iostream>
 
@@ -21,18 +23,24 @@ void MeshShape(const TopoDS_Shape& root,
                const RGBA&          shapeColorIn,
                MaterialRegistry&    matReg,
                std::vector<TriBucket>& triBuckets,
-               std::vector<EdgeBucket>& edgeBuckets)
+               std::vector<EdgeBucket>& edgeBuckets,
+               std::pmr::memory_resource* mem)
 {
     if (root.IsNull()) return;
 
+    Trace::Span span("MeshShape", "mesh");
+
     // Meshing tolerances
     const double linDefl  = 0.01;
     const double angDefl  = 0.10;
     const double edgeDeflBase = linDefl * 8.0;
 
     // Triangulate once for entire shape
-    BRepMesh_IncrementalMesh mesh(root, linDefl, Standard_False, angDefl, Standard_True);
-    mesh.Perform();
+    {
+        Trace::Span meshSpan("BRepMesh", "mesh");
+        BRepMesh_IncrementalMesh mesh(root, linDefl, Standard_False, angDefl, Standard_True);
+        mesh.Perform();
+    }
 
     // Default gray for shapes that are pure black
     RGBA shapeColor = shapeColorIn;
@@ -51,16 +59,24 @@ void MeshShape(const TopoDS_Shape& root,
         ? RGBA{0.1f,0.1f,0.1f,1.0f}
         : RGBA{0.9f,0.9f,0.9f,1.0f};
 
+    const TriBucket::allocator_type alloc(mem);
+
     int shapeMatIdx = matReg.getOrCreate(shapeColor);
-    if (shapeMatIdx >= static_cast<int>(triBuckets.size()))
-        triBuckets.resize(shapeMatIdx + 1);
+    while (shapeMatIdx >= static_cast<int>(triBuckets.size()))
+        triBuckets.emplace_back(alloc);
     triBuckets[shapeMatIdx].materialIndex = shapeMatIdx;
 
     int edgeMatIdx = matReg.getOrCreate(edgeColor);
-    if (edgeMatIdx >= static_cast<int>(edgeBuckets.size()))
-        edgeBuckets.resize(edgeMatIdx + 1);
+    while (edgeMatIdx >= static_cast<int>(edgeBuckets.size()))
+        edgeBuckets.emplace_back(alloc);
     edgeBuckets[edgeMatIdx].materialIndex = edgeMatIdx;
 
+    // Per-face normal accumulator, reused across faces
+    std::pmr::vector<gp_Vec> acc(alloc);
+
+    const std::size_t bytesBefore = BucketBytes(triBuckets[shapeMatIdx])
+                                  + BucketBytes(edgeBuckets[edgeMatIdx]);
+
     // Faces → triangles
     for (TopExp_Explorer ex(root, TopAbs_FACE); ex.More(); ex.Next()) {
         TopoDS_Face face = TopoDS::Face(ex.Current());
@@ -75,7 +91,7 @@ void MeshShape(const TopoDS_Shape& root,
             b.vertices.reserve(b.vertices.size() + static_cast<std::size_t>(n));
             b.normals .reserve(b.normals.size()  + static_cast<std::size_t>(n));
 
-            std::vector<gp_Vec> acc(static_cast<std::size_t>(n), gp_Vec(0,0,0));
+            acc.assign(static_cast<std::size_t>(n), gp_Vec(0,0,0));
 
             for (int i=1; i<=n; ++i) {
                 gp_Pnt p = tri->Node(i).Transformed(loc.Transformation());
@@ -154,4 +170,67 @@ void MeshShape(const TopoDS_Shape& root,
             std::cerr << "skip bad edge (unknown error)\n";
         }
     }
+
+    span.setBytes(BucketBytes(triBuckets[shapeMatIdx]) + BucketBytes(eB) - bytesBefore);
+}
+
+void AppendTransformed(const std::vector<TriBucket>&  srcTris,
+                       const std::vector<EdgeBucket>& srcEdges,
+                       const std::vector<RGBA>&       srcMaterials,
+                       const gp_Trsf&                 trsf,
+                       MaterialRegistry&              matReg,
+                       std::vector<TriBucket>&        triBuckets,
+                       std::vector<EdgeBucket>&       edgeBuckets)
+{
+    // VectorialPart includes the scale factor
+    const gp_Mat M = trsf.VectorialPart();
+    const gp_XYZ t = trsf.TranslationPart();
+    const bool   flip = trsf.IsNegative();
+
+    auto point = [&](const Vertex& v) {
+        gp_XYZ p(v.x, v.y, v.z);
+        p.Multiply(M);
+        p.Add(t);
+        return Vertex{(float)p.X(), (float)p.Y(), (float)p.Z()};
+    };
+    auto normal = [&](const Normal& n) {
+        gp_XYZ d(n.x, n.y, n.z);
+        d.Multiply(M);
+        const double len = d.Modulus();
+        if (len > 1e-12) d.Divide(len);
+        return Normal{(float)d.X(), (float)d.Y(), (float)d.Z()};
+    };
+    auto target = [&](auto& buckets, int srcMat) -> auto& {
+        const RGBA c = (srcMat >= 0 && srcMat < static_cast<int>(srcMaterials.size()))
+                     ? srcMaterials[srcMat]
+                     : RGBA{0.7f, 0.7f, 0.7f, 1.0f};
+        const int idx = matReg.getOrCreate(c);
+        while (idx >= static_cast<int>(buckets.size()))
+            buckets.emplace_back();
+        buckets[idx].materialIndex = idx;
+        return buckets[idx];
+    };
+
+    for (const auto& src : srcTris) {
+        if (src.vertices.empty()) continue;
+        TriBucket& b = target(triBuckets, src.materialIndex);
+        const std::uint32_t base = static_cast<std::uint32_t>(b.vertices.size());
+
+        for (const auto& v : src.vertices) b.vertices.push_back(point(v));
+        for (const auto& n : src.normals)  b.normals.push_back(normal(n));
+        for (std::size_t i=0; i+2<src.indices.size(); i+=3) {
+            b.indices.push_back(base + src.indices[i]);
+            b.indices.push_back(base + src.indices[flip ? i+2 : i+1]);
+            b.indices.push_back(base + src.indices[flip ? i+1 : i+2]);
+        }
+    }
+
+    for (const auto& src : srcEdges) {
+        if (src.vertices.empty()) continue;
+        EdgeBucket& e = target(edgeBuckets, src.materialIndex);
+        const std::uint32_t base = static_cast<std::uint32_t>(e.vertices.size());
+
+        for (const auto& v : src.vertices) e.vertices.push_back(point(v));
+        for (std::uint32_t i : src.indices) e.indices.push_back(base + i);
+    }
 }
@@ -0,0 +1,387 @@
+#include "MeshSimplifier.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::uint32_t kNone        = std::numeric_limits<std::uint32_t>::max();
+constexpr double        kCreaseCos   = 0.7071;    // 45°
+constexpr double        kMaxTiltCos  = 0.2;       // collapses may turn a face by < ~78°
+
+struct Vec3d {
+    double x, y, z;
+};
+
+Vec3d Sub(const Vec3d& a, const Vec3d& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+double Dot(const Vec3d& a, const Vec3d& b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+Vec3d Cross(const Vec3d& a, const Vec3d& b)
+{
+    return {a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+// Symmetric 4×4 plane quadric, upper triangle, plus the summed weight
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double w  = 0;
+
+    void addPlane(const Vec3d& n, double d, double weight)
+    {
+        a2 += weight*n.x*n.x; ab += weight*n.x*n.y; ac += weight*n.x*n.z; ad += weight*n.x*d;
+        b2 += weight*n.y*n.y; bc += weight*n.y*n.z; bd += weight*n.y*d;
+        c2 += weight*n.z*n.z; cd += weight*n.z*d;
+        d2 += weight*d*d;
+        w  += weight;
+    }
+
+    void add(const Quadric& o)
+    {
+        a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+        b2 += o.b2; bc += o.bc; bd += o.bd;
+        c2 += o.c2; cd += o.cd;
+        d2 += o.d2;
+        w  += o.w;
+    }
+
+    double error(const Vec3d& p) const
+    {
+        const double e = a2*p.x*p.x + 2*ab*p.x*p.y + 2*ac*p.x*p.z + 2*ad*p.x
+                       + b2*p.y*p.y + 2*bc*p.y*p.z + 2*bd*p.y
+                       + c2*p.z*p.z + 2*cd*p.z
+                       + d2;
+        return std::max(e, 0.0);
+    }
+};
+
+struct Candidate {
+    double        cost;
+    std::uint32_t from, to;          // `from` moves onto `to`
+    std::uint32_t fromVer, toVer;
+
+    bool operator>(const Candidate& o) const { return cost > o.cost; }
+};
+
+struct PositionKey {
+    std::uint32_t x, y, z;
+    bool operator==(const PositionKey& o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+struct PositionHash {
+    std::size_t operator()(const PositionKey& k) const {
+        std::uint64_t h = k.x * 0x9E3779B97F4A7C15ull;
+        h ^= (k.y + 0x7F4A7C15ull + (h << 6) + (h >> 2)) * 0xBF58476D1CE4E5B9ull;
+        h ^= (k.z + 0x94D049BBull + (h << 6) + (h >> 2)) * 0x94D049BB133111EBull;
+        return static_cast<std::size_t>(h ^ (h >> 31));
+    }
+};
+
+PositionKey KeyOf(const Vertex& v)
+{
+    // + 0.0f folds -0 into +0
+    PositionKey k;
+    const float x = v.x + 0.0f, y = v.y + 0.0f, z = v.z + 0.0f;
+    std::memcpy(&k.x, &x, 4);
+    std::memcpy(&k.y, &y, 4);
+    std::memcpy(&k.z, &z, 4);
+    return k;
+}
+
+std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+{
+    return a < b ? (std::uint64_t(a) << 32 | b) : (std::uint64_t(b) << 32 | a);
+}
+
+} // namespace
+
+SimplifyStats SimplifyBucket(TriBucket& bucket, std::size_t targetTriangles)
+{
+    SimplifyStats st;
+    st.trianglesIn  = bucket.indices.size() / 3;
+    st.trianglesOut = st.trianglesIn;
+    if (st.trianglesIn == 0 || targetTriangles >= st.trianglesIn) return st;
+
+    Trace::Span span("SimplifyBucket", "mesh");
+
+    // ── Weld by position; triangles that collapse to a point or a line go ─
+    std::vector<Vec3d>         pos;
+    std::vector<std::uint32_t> tri;
+    {
+        std::unordered_map<PositionKey, std::uint32_t, PositionHash> welded;
+        welded.reserve(bucket.vertices.size());
+        std::vector<std::uint32_t> remap(bucket.vertices.size());
+        for (std::size_t i=0; i<bucket.vertices.size(); ++i) {
+            const Vertex& v = bucket.vertices[i];
+            auto [it, inserted] = welded.try_emplace(KeyOf(v), static_cast<std::uint32_t>(pos.size()));
+            if (inserted) pos.push_back({v.x, v.y, v.z});
+            remap[i] = it->second;
+        }
+        tri.reserve(bucket.indices.size());
+        for (std::size_t i=0; i+2<bucket.indices.size(); i+=3) {
+            const std::uint32_t a = remap[bucket.indices[i]];
+            const std::uint32_t b = remap[bucket.indices[i + 1]];
+            const std::uint32_t c = remap[bucket.indices[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            tri.insert(tri.end(), {a, b, c});
+        }
+    }
+    const std::size_t nv = pos.size();
+    const std::size_t nt = tri.size() / 3;
+
+    auto faceNormal = [&](std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+        return Cross(Sub(pos[b], pos[a]), Sub(pos[c], pos[a]));
+    };
+
+    // ── Quadrics, adjacency, locked (boundary / non-manifold) vertices ─────
+    std::vector<Quadric>                    quadric(nv);
+    std::vector<std::vector<std::uint32_t>> vertTris(nv);
+    std::unordered_map<std::uint64_t, std::uint32_t> edgeUse;
+    edgeUse.reserve(nt * 3 / 2 + 1);
+    for (std::uint32_t t=0; t<nt; ++t) {
+        const std::uint32_t* v = &tri[3 * t];
+        Vec3d n = faceNormal(v[0], v[1], v[2]);
+        const double len = std::sqrt(Dot(n, n));
+        if (len > 0.0) {
+            n = {n.x / len, n.y / len, n.z / len};
+            const double d = -Dot(n, pos[v[0]]);
+            for (int k=0; k<3; ++k) quadric[v[k]].addPlane(n, d, 0.5 * len);
+        }
+        for (int k=0; k<3; ++k) {
+            vertTris[v[k]].push_back(t);
+            ++edgeUse[EdgeKey(v[k], v[(k + 1) % 3])];
+        }
+    }
+    std::vector<std::uint8_t> locked(nv, 0);
+    for (const auto& [key, uses] : edgeUse) {
+        if (uses == 2) continue;
+        locked[key >> 32] = 1;
+        locked[key & 0xFFFFFFFFu] = 1;
+    }
+
+    std::vector<std::uint8_t>  removed(nv, 0), deadTri(nt, 0);
+    std::vector<std::uint32_t> version(nv, 0);
+
+    // Distinct neighbours of x over its live triangles, sorted
+    auto neighbours = [&](std::uint32_t x, std::vector<std::uint32_t>& out) {
+        out.clear();
+        for (std::uint32_t t : vertTris[x]) {
+            if (deadTri[t]) continue;
+            for (int k=0; k<3; ++k) {
+                if (tri[3 * t + k] != x) out.push_back(tri[3 * t + k]);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    // x becomes locked once one of its edges is no longer shared by
+    // exactly two live triangles (locks are never lifted)
+    std::unordered_map<std::uint32_t, std::uint32_t> edgeCount;
+    auto relock = [&](std::uint32_t x) {
+        if (locked[x]) return;
+        edgeCount.clear();
+        for (std::uint32_t t : vertTris[x]) {
+            if (deadTri[t]) continue;
+            for (int k=0; k<3; ++k) {
+                if (tri[3 * t + k] != x) ++edgeCount[tri[3 * t + k]];
+            }
+        }
+        for (const auto& [w, n] : edgeCount) {
+            if (n != 2) {
+                locked[x] = 1;
+                return;
+            }
+        }
+    };
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+    auto push = [&](std::uint32_t from, std::uint32_t to) {
+        if (locked[from]) return;
+        Quadric q = quadric[from];
+        q.add(quadric[to]);
+        heap.push({q.error(pos[to]), from, to, version[from], version[to]});
+    };
+    for (const auto& [key, uses] : edgeUse) {
+        const std::uint32_t a = static_cast<std::uint32_t>(key >> 32);
+        const std::uint32_t b = static_cast<std::uint32_t>(key & 0xFFFFFFFFu);
+        push(a, b);
+        push(b, a);
+    }
+    edgeUse.clear();
+
+    // ── Collapse cheapest edges until the budget is met ────────────────────
+    std::size_t live = nt;
+    double      worst = 0.0;
+    std::vector<std::uint32_t> ring, ringU, ringV, shared, opposite;
+    while (live > targetTriangles && !heap.empty()) {
+        const Candidate c = heap.top();
+        heap.pop();
+        const std::uint32_t u = c.from, v = c.to;
+        if (removed[u] || removed[v] || version[u] != c.fromVer || version[v] != c.toVer) continue;
+        if (locked[u]) continue;
+
+        // Link condition: u and v may only share the apexes of the faces on
+        // edge (u, v). Any other common neighbour would fold two fans
+        // together into duplicate faces and edges with 3+ faces.
+        opposite.clear();
+        for (std::uint32_t t : vertTris[u]) {
+            if (deadTri[t]) continue;
+            const std::uint32_t* tv = &tri[3 * t];
+            if (tv[0] != v && tv[1] != v && tv[2] != v) continue;
+            for (int k=0; k<3; ++k) {
+                if (tv[k] != u && tv[k] != v) opposite.push_back(tv[k]);
+            }
+        }
+        std::sort(opposite.begin(), opposite.end());
+        if (opposite.empty() || opposite.size() > 2 ||
+            std::adjacent_find(opposite.begin(), opposite.end()) != opposite.end()) continue;
+        neighbours(u, ringU);
+        neighbours(v, ringV);
+        shared.clear();
+        std::set_intersection(ringU.begin(), ringU.end(), ringV.begin(), ringV.end(),
+                              std::back_inserter(shared));
+        if (shared != opposite) continue;
+
+        // A closed tetrahedron would collapse into two faces on the same
+        // three vertices
+        if (opposite.size() == 2 && ringU.size() == 3 && ringV.size() == 3) continue;
+
+        // Reject collapses that flip, tilt or flatten a surviving triangle
+        bool ok = true;
+        for (std::uint32_t t : vertTris[u]) {
+            if (deadTri[t]) continue;
+            const std::uint32_t* tv = &tri[3 * t];
+            if (tv[0] == v || tv[1] == v || tv[2] == v) continue;
+            const Vec3d before = faceNormal(tv[0], tv[1], tv[2]);
+            std::uint32_t moved[3] = {tv[0], tv[1], tv[2]};
+            for (auto& x : moved) if (x == u) x = v;
+            const Vec3d after = faceNormal(moved[0], moved[1], moved[2]);
+            if (Dot(before, after) <= kMaxTiltCos * std::sqrt(Dot(before, before) * Dot(after, after))) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) continue;
+
+        for (std::uint32_t t : vertTris[u]) {
+            if (deadTri[t]) continue;
+            std::uint32_t* tv = &tri[3 * t];
+            if (tv[0] == v || tv[1] == v || tv[2] == v) {
+                deadTri[t] = 1;
+                --live;
+                continue;
+            }
+            for (int k=0; k<3; ++k) if (tv[k] == u) tv[k] = v;
+            vertTris[v].push_back(t);
+        }
+        vertTris[u].clear();
+        vertTris[u].shrink_to_fit();
+        removed[u] = 1;
+        quadric[v].add(quadric[u]);
+        ++version[v];
+        if (quadric[v].w > 0.0) worst = std::max(worst, std::sqrt(c.cost / quadric[v].w));
+
+        // Drop dead triangles from v and queue its edges with the new quadric
+        auto& vt = vertTris[v];
+        vt.erase(std::remove_if(vt.begin(), vt.end(), [&](std::uint32_t t) { return deadTri[t]; }), vt.end());
+        ring.clear();
+        for (std::uint32_t t : vt) {
+            for (int k=0; k<3; ++k) {
+                if (tri[3 * t + k] != v) ring.push_back(tri[3 * t + k]);
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+        relock(v);
+        for (std::uint32_t w : ring) relock(w);
+        for (std::uint32_t w : ring) {
+            push(v, w);
+            push(w, v);
+        }
+    }
+
+    // ── Rebuild the bucket: crease-aware normals, one vertex per ───────────
+    // (position, normal) pair
+    std::vector<Vec3d>  faceN(nt, Vec3d{0, 0, 0});
+    std::vector<double> faceArea(nt, 0.0);
+    for (std::uint32_t t=0; t<nt; ++t) {
+        if (deadTri[t]) continue;
+        const Vec3d n = faceNormal(tri[3*t], tri[3*t + 1], tri[3*t + 2]);
+        const double len = std::sqrt(Dot(n, n));
+        faceArea[t] = 0.5 * len;
+        if (len > 0.0) faceN[t] = {n.x / len, n.y / len, n.z / len};
+    }
+
+    std::vector<Vertex>        outV;
+    std::vector<Normal>        outN;
+    std::vector<std::uint32_t> outI;
+    std::vector<std::uint32_t> firstOut(nv, kNone), nextOut;
+    outI.reserve(live * 3);
+
+    for (std::uint32_t t=0; t<nt; ++t) {
+        if (deadTri[t]) continue;
+        for (int k=0; k<3; ++k) {
+            const std::uint32_t p = tri[3 * t + k];
+            Vec3d n{0, 0, 0};
+            for (std::uint32_t t2 : vertTris[p]) {
+                if (deadTri[t2] || Dot(faceN[t2], faceN[t]) < kCreaseCos) continue;
+                n = {n.x + faceN[t2].x * faceArea[t2], n.y + faceN[t2].y * faceArea[t2],
+                     n.z + faceN[t2].z * faceArea[t2]};
+            }
+            const double len = std::sqrt(Dot(n, n));
+            const Normal nn = len > 0.0 ? Normal{(float)(n.x / len), (float)(n.y / len), (float)(n.z / len)}
+                                        : Normal{(float)faceN[t].x, (float)faceN[t].y, (float)faceN[t].z};
+
+            std::uint32_t out = firstOut[p];
+            while (out != kNone) {
+                const Normal& o = outN[out];
+                if (o.x*nn.x + o.y*nn.y + o.z*nn.z > 0.9999f) break;
+                out = nextOut[out];
+            }
+            if (out == kNone) {
+                out = static_cast<std::uint32_t>(outV.size());
+                outV.push_back({(float)pos[p].x, (float)pos[p].y, (float)pos[p].z});
+                outN.push_back(nn);
+                nextOut.push_back(firstOut[p]);
+                firstOut[p] = out;
+            }
+            outI.push_back(out);
+        }
+    }
+
+    bucket.vertices.assign(outV.begin(), outV.end());
+    bucket.normals .assign(outN.begin(), outN.end());
+    bucket.indices .assign(outI.begin(), outI.end());
+    bucket.vertices.shrink_to_fit();
+    bucket.normals .shrink_to_fit();
+    bucket.indices .shrink_to_fit();
+
+    st.trianglesOut = live;
+    st.maxError     = worst;
+    span.setBytes(BucketBytes(bucket));
+    return st;
+}
+
+SimplifyStats SimplifyBuckets(std::vector<TriBucket>& buckets, std::size_t targetTriangles)
+{
+    std::size_t total = 0;
+    for (const auto& b : buckets) total += b.indices.size() / 3;
+
+    SimplifyStats st;
+    if (total <= targetTriangles) {
+        st.trianglesIn = st.trianglesOut = total;
+        return st;
+    }
+
+    const double keep = static_cast<double>(targetTriangles) / static_cast<double>(total);
+    for (auto& b : buckets) {
+        const std::size_t n = b.indices.size() / 3;
+        st.add(SimplifyBucket(b, static_cast<std::size_t>(std::floor(n * keep))));
+    }
+    return st;
+}
@@ -0,0 +1,134 @@
+#include "QueryCommand.hpp"
+#include "AssemblyBinary.hpp"
+#include "AssemblyBvh.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void Usage()
+{
+    std::cerr << "Usage: stepguru query DIR box XMIN YMIN ZMIN XMAX YMAX ZMAX\n"
+                 "       stepguru query DIR ray OX OY OZ DX DY DZ\n"
+                 "       stepguru query DIR near ID DISTANCE\n"
+                 "DIR holds assembly.bin and assembly.bvh from a previous export run with --bvh.\n";
+}
+
+bool ParseDoubles(char* argv[], int count, double* out)
+{
+    for (int i=0; i<count; ++i) {
+        char* end = nullptr;
+        out[i] = std::strtod(argv[i], &end);
+        if (end == argv[i] || *end != '\0') {
+            std::cerr << "❌ Not a number: " << argv[i] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void PrintHit(const AssemblyBinary::Reader& bin, const AssemblyBvh::Item& it)
+{
+    if (it.node >= bin.nodeCount()) {
+        std::cout << "  <node " << it.node << " missing from assembly.bin>\n";
+        return;
+    }
+    const AssemblyBinary::NodeRecord&       r = bin.node(it.node);
+    const AssemblyBinary::DefinitionRecord& d = bin.definition(r.definition);
+    std::string_view name = d.name == AssemblyBinary::kNone ? std::string_view("Unnamed")
+                                                            : bin.string(d.name);
+    std::cout << "  " << bin.string(r.id) << "\t" << name
+              << "\t[" << it.box.min[0] << ' ' << it.box.min[1] << ' ' << it.box.min[2]
+              << " .. " << it.box.max[0] << ' ' << it.box.max[1] << ' ' << it.box.max[2] << "]";
+}
+
+} // namespace
+
+int RunQuery(int argc, char* argv[])
+{
+    if (argc < 3) {
+        Usage();
+        return 1;
+    }
+
+    std::string dir = argv[1];
+    if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') dir.push_back('/');
+    const std::string what = argv[2];
+
+    auto tStart = std::chrono::high_resolution_clock::now();
+
+    AssemblyBinary::MappedFile binMap(dir + "assembly.bin");
+    AssemblyBinary::Reader     bin(binMap.data(), binMap.size());
+    AssemblyBvh::MappedFile    bvhMap(dir + "assembly.bvh");
+    AssemblyBvh::Reader        bvh(bvhMap.data(), bvhMap.size());
+    if (!bin.ok() || !bvh.ok()) {
+        std::cerr << "❌ Cannot open " << (bin.ok() ? "assembly.bvh" : "assembly.bin")
+                  << " in " << dir << (bin.ok() ? " (export with --bvh)" : "") << "\n";
+        return 1;
+    }
+
+    std::size_t hits = 0;
+    if (what == "box" && argc == 9) {
+        double v[6];
+        if (!ParseDoubles(argv + 3, 6, v)) return 1;
+        const AssemblyBvh::Box q{{v[0], v[1], v[2]}, {v[3], v[4], v[5]}};
+        for (std::uint32_t i : bvh.overlapping(q)) {
+            PrintHit(bin, bvh.item(i));
+            std::cout << "\n";
+            ++hits;
+        }
+    } else if (what == "ray" && argc == 9) {
+        double v[6];
+        if (!ParseDoubles(argv + 3, 6, v)) return 1;
+        if (v[3] == 0.0 && v[4] == 0.0 && v[5] == 0.0) {
+            std::cerr << "❌ Ray direction is zero\n";
+            return 1;
+        }
+        for (const auto& [i, t] : bvh.ray(v, v + 3)) {
+            PrintHit(bin, bvh.item(i));
+            std::cout << "\tt=" << t << "\n";
+            ++hits;
+        }
+    } else if (what == "near" && argc == 5) {
+        const std::string id = argv[3];
+        double dist = 0.0;
+        if (!ParseDoubles(argv + 4, 1, &dist)) return 1;
+
+        // Every occurrence carrying that id (repeated sub-assemblies share
+        // label paths); results exclude the occurrences themselves
+        std::vector<std::uint32_t> self;
+        for (std::uint32_t i=0; i<bvh.itemCount(); ++i) {
+            const std::uint32_t n = bvh.item(i).node;
+            if (n < bin.nodeCount() && bin.string(bin.node(n).id) == id) self.push_back(i);
+        }
+        if (self.empty()) {
+            std::cerr << "❌ No leaf occurrence with id " << id << "\n";
+            return 1;
+        }
+        std::vector<char> seen(bvh.itemCount(), 0);
+        for (std::uint32_t s : self) seen[s] = 1;
+        for (std::uint32_t s : self) {
+            const AssemblyBvh::Box& q = bvh.item(s).box;
+            for (std::uint32_t i : bvh.within(q, dist)) {
+                if (seen[i]) continue;
+                seen[i] = 1;
+                PrintHit(bin, bvh.item(i));
+                std::cout << "\tgap=" << AssemblyBvh::Distance(bvh.item(i).box, q) << "\n";
+                ++hits;
+            }
+        }
+    } else {
+        Usage();
+        return 1;
+    }
+
+    auto tEnd = std::chrono::high_resolution_clock::now();
+    std::cout << hits << " hit(s) among " << bvh.itemCount() << " occurrence(s) in "
+              << std::chrono::duration<double, std::milli>(tEnd - tStart).count() << " ms\n";
+    return 0;
+}
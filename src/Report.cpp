@@ -0,0 +1,226 @@
+#include "Report.hpp"
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/filewritestream.h>
+
+#include <BRepAdaptor_Surface.hxx>
+#include <GeomAbs_SurfaceType.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+using namespace rapidjson;
+
+static const char* SurfaceTypeString(GeomAbs_SurfaceType t)
+{
+    switch (t)
+    {
+        case GeomAbs_Plane:               return "PLANE";
+        case GeomAbs_Cylinder:            return "CYLINDER";
+        case GeomAbs_Cone:                return "CONE";
+        case GeomAbs_Sphere:              return "SPHERE";
+        case GeomAbs_Torus:               return "TORUS";
+        case GeomAbs_BezierSurface:       return "BEZIER";
+        case GeomAbs_BSplineSurface:      return "BSPLINE";
+        case GeomAbs_SurfaceOfRevolution: return "REVOLUTION";
+        case GeomAbs_SurfaceOfExtrusion:  return "EXTRUSION";
+        case GeomAbs_OffsetSurface:       return "OFFSET";
+        case GeomAbs_OtherSurface:        return "OTHER";
+    }
+    return "UNKNOWN";
+}
+
+ComponentCost& CostReport::entry(const std::string& id)
+{
+    auto it = m_lookup.find(id);
+    if (it != m_lookup.end()) {
+        return m_entries[it->second];
+    }
+    m_lookup.emplace(id, m_entries.size());
+    m_entries.emplace_back();
+    m_entries.back().id = id;
+    return m_entries.back();
+}
+
+void CollectFaceStats(const TopoDS_Shape& shape, ComponentCost& out)
+{
+    if (shape.IsNull()) return;
+
+    for (TopExp_Explorer ex(shape, TopAbs_FACE); ex.More(); ex.Next()) {
+        ++out.faces;
+        const char* type = "UNKNOWN";
+        try {
+            BRepAdaptor_Surface surf(TopoDS::Face(ex.Current()), Standard_False);
+            type = SurfaceTypeString(surf.GetType());
+        } catch (const Standard_Failure&) {
+            // keep UNKNOWN
+        }
+        ++out.surfaceTypes[type];
+    }
+}
+
+std::uintmax_t FileSizeOrZero(const std::string& filename)
+{
+    std::error_code ec;
+    auto n = std::filesystem::file_size(filename, ec);
+    return ec ? 0 : n;
+}
+
+template <typename W>
+static void WriteEntry(W& w, const ComponentCost& c)
+{
+    w.StartObject();
+    w.Key("id");        w.String(c.id.c_str());
+    w.Key("name");      w.String(c.name.c_str());
+    w.Key("kind");      w.String(c.kind.c_str());
+    w.Key("instances"); w.Uint64(c.instances);
+    if (!c.sameAs.empty()) {
+        w.Key("sameAs"); w.String(c.sameAs.c_str());
+    }
+
+    w.Key("mesh");
+    w.StartObject();
+    w.Key("seconds");      w.Double(c.meshSec);
+    w.Key("triangles");    w.Uint64(c.triangles);
+    w.Key("vertices");     w.Uint64(c.vertices);
+    w.Key("edgeSegments"); w.Uint64(c.edgeSegments);
+    if (c.sourceTriangles) {
+        w.Key("sourceTriangles"); w.Uint64(c.sourceTriangles);
+        w.Key("simplifyError");   w.Double(c.simplifyError);
+    }
+    w.EndObject();
+
+    w.Key("outputs");
+    w.StartObject();
+    w.Key("glb");  w.StartObject();
+    w.Key("seconds"); w.Double(c.glbSec);  w.Key("bytes"); w.Uint64(c.glbBytes);
+    w.EndObject();
+    w.Key("png");  w.StartObject();
+    w.Key("seconds"); w.Double(c.pngSec);  w.Key("bytes"); w.Uint64(c.pngBytes);
+    w.EndObject();
+    w.Key("step"); w.StartObject();
+    w.Key("seconds"); w.Double(c.stepSec); w.Key("bytes"); w.Uint64(c.stepBytes);
+    w.EndObject();
+    w.EndObject();
+
+    w.Key("brep");
+    w.StartObject();
+    w.Key("faces"); w.Uint64(c.faces);
+    w.Key("surfaceTypes");
+    w.StartObject();
+    for (const auto& [type, n] : c.surfaceTypes) {
+        w.Key(type.c_str()); w.Uint64(n);
+    }
+    w.EndObject();
+    w.EndObject();
+
+    w.Key("totalSeconds"); w.Double(c.totalSec());
+    w.EndObject();
+}
+
+bool CostReport::writeJson(const std::string& filename, std::size_t topN) const
+{
+    FILE* f = fopen(filename.c_str(), "w");
+    if (!f) {
+        std::cerr << "❌ Cannot write report file: " << filename << "\n";
+        return false;
+    }
+
+    char buff[65536];
+    FileWriteStream fs(f, buff, sizeof(buff));
+    PrettyWriter<FileWriteStream> w(fs);
+    w.SetIndent(' ', 2);
+
+    ComponentCost sum;
+    sum.id = "total";
+    for (const auto& c : m_entries) {
+        sum.instances    += c.instances;
+        sum.meshSec      += c.meshSec;
+        sum.triangles    += c.triangles;
+        sum.vertices     += c.vertices;
+        sum.edgeSegments += c.edgeSegments;
+        sum.sourceTriangles += c.sourceTriangles;
+        sum.simplifyError    = std::max(sum.simplifyError, c.simplifyError);
+        sum.glbSec       += c.glbSec;
+        sum.pngSec       += c.pngSec;
+        sum.stepSec      += c.stepSec;
+        sum.glbBytes     += c.glbBytes;
+        sum.pngBytes     += c.pngBytes;
+        sum.stepBytes    += c.stepBytes;
+        sum.faces        += c.faces;
+        for (const auto& [type, n] : c.surfaceTypes) {
+            sum.surfaceTypes[type] += n;
+        }
+    }
+
+    // Rank parts only; the assembly entry would always dominate
+    std::vector<const ComponentCost*> ranked;
+    for (const auto& c : m_entries) {
+        if (c.kind == "part") ranked.push_back(&c);
+    }
+    std::size_t n = std::min(topN, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(),
+                      [](const ComponentCost* a, const ComponentCost* b) {
+                          return a->totalSec() > b->totalSec();
+                      });
+
+    w.StartObject();
+    w.Key("components");
+    w.StartArray();
+    for (const auto& c : m_entries) {
+        WriteEntry(w, c);
+    }
+    w.EndArray();
+
+    w.Key("aggregate");
+    w.StartObject();
+    w.Key("definitions"); w.Uint64(m_entries.size());
+    w.Key("totals");
+    WriteEntry(w, sum);
+    w.EndObject();
+
+    w.Key("memory");
+    w.StartArray();
+    for (const auto& m : m_memory) {
+        w.StartObject();
+        w.Key("phase");        w.String(m.phase.c_str());
+        w.Key("rssBytes");     w.Uint64(m.rssBytes);
+        w.Key("peakRssBytes"); w.Uint64(m.peakRssBytes);
+        w.Key("trackedBytes"); w.Uint64(m.trackedBytes);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("slowest");
+    w.StartArray();
+    for (std::size_t i=0; i<n; ++i) {
+        const ComponentCost& c = *ranked[i];
+        w.StartObject();
+        w.Key("rank");         w.Uint64(i + 1);
+        w.Key("id");           w.String(c.id.c_str());
+        w.Key("name");         w.String(c.name.c_str());
+        w.Key("totalSeconds"); w.Double(c.totalSec());
+        w.Key("meshSeconds");  w.Double(c.meshSec);
+        w.Key("triangles");    w.Uint64(c.triangles);
+        w.EndObject();
+    }
+    w.EndArray();
+    w.EndObject();
+
+    fs.Flush();
+
+    const bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+        std::cerr << "❌ Write failed: " << filename << "\n";
+        return false;
+    }
+
+    std::cout << "📊 Report written: " << filename << "\n";
+    return true;
+}
@@ -0,0 +1,251 @@
+#include "SharedGeometry.hpp"
+#include "GltfJsonWriter.hpp"
+#include "Trace.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+using Gltf::AccessorType;
+
+RGBA MaterialOf(const std::vector<RGBA>& materials, int idx)
+{
+    return (idx >= 0 && idx < static_cast<int>(materials.size())) ? materials[idx]
+                                                                   : RGBA{0.7f, 0.7f, 0.7f, 1.0f};
+}
+
+// Column-major 4x4 of a gp_Trsf (scale folded into the linear part)
+std::array<double,16> ColumnMajor(const gp_Trsf& t)
+{
+    std::array<double,16> m{};
+    for (int c=0; c<4; ++c) {
+        for (int r=0; r<3; ++r) m[c*4 + r] = t.Value(r + 1, c + 1);
+    }
+    m[15] = 1.0;
+    return m;
+}
+
+template <typename Array>
+bool ReadArray(std::ifstream& in, const SharedArray& range, Array& out)
+{
+    out.resize(range.bytes / sizeof(typename Array::value_type));
+    in.seekg(static_cast<std::streamoff>(range.offset));
+    in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(range.bytes));
+    return static_cast<bool>(in);
+}
+
+template <typename Bucket>
+Bucket& BucketAt(std::vector<Bucket>& buckets, int idx)
+{
+    while (idx >= static_cast<int>(buckets.size())) buckets.emplace_back();
+    buckets[idx].materialIndex = idx;
+    return buckets[idx];
+}
+
+} // namespace
+
+SharedGeometryBuffer::SharedGeometryBuffer(std::string binFile)
+    : m_binFile(std::move(binFile)),
+      m_out(m_binFile, std::ios::binary | std::ios::trunc)
+{
+    if (!m_out) {
+        std::cerr << "Cannot open output file: " << m_binFile << "\n";
+        m_ok = false;
+    }
+}
+
+std::uint32_t SharedGeometryBuffer::find(const std::string& key) const
+{
+    auto it = m_ids.find(key);
+    return it == m_ids.end() ? kNone : it->second;
+}
+
+std::uint32_t SharedGeometryBuffer::add(const std::string& key, const CachedMesh& mesh)
+{
+    auto [it, inserted] = m_ids.try_emplace(key, static_cast<std::uint32_t>(m_meshes.size()));
+    if (!inserted) return it->second;
+
+    Trace::Span span("SharedMesh", "io", key);
+    const std::uint64_t before = m_bytes;
+
+    auto append = [&](const void* data, std::size_t bytes) {
+        SharedArray range{m_bytes, bytes};
+        m_out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        m_bytes += bytes;
+        return range;
+    };
+
+    std::vector<SharedPrimitive> prims;
+    for (const auto& b : mesh.triBuckets) {
+        if (b.vertices.empty() || b.indices.empty()) continue;
+        SharedPrimitive p;
+        p.positions    = append(b.vertices.data(), b.vertices.size() * sizeof(Vertex));
+        p.normals      = append(b.normals.data(),  b.normals.size()  * sizeof(Normal));
+        p.indices      = append(b.indices.data(),  b.indices.size()  * sizeof(std::uint32_t));
+        p.vertexCount  = static_cast<std::uint32_t>(b.vertices.size());
+        p.indexCount   = static_cast<std::uint32_t>(b.indices.size());
+        p.bounds       = calcMinMax(b.vertices, false);
+        p.normalBounds = calcMinMax(b.normals, false);
+        p.color        = MaterialOf(mesh.materials, b.materialIndex);
+        p.mode         = 4;
+        prims.push_back(p);
+    }
+    for (const auto& e : mesh.edgeBuckets) {
+        if (e.vertices.empty() || e.indices.empty()) continue;
+        SharedPrimitive p;
+        p.positions    = append(e.vertices.data(), e.vertices.size() * sizeof(Vertex));
+        p.indices      = append(e.indices.data(),  e.indices.size()  * sizeof(std::uint32_t));
+        p.vertexCount  = static_cast<std::uint32_t>(e.vertices.size());
+        p.indexCount   = static_cast<std::uint32_t>(e.indices.size());
+        p.bounds       = calcMinMax(e.vertices, false);
+        p.color        = MaterialOf(mesh.materials, e.materialIndex);
+        p.mode         = 1;
+        prims.push_back(p);
+    }
+    if (m_ok && !m_out) {
+        std::cerr << "Write failed: " << m_binFile << "\n";
+        m_ok = false;
+    }
+
+    span.setBytes(m_bytes - before);
+    m_meshes.push_back(std::move(prims));
+    return it->second;
+}
+
+std::uint32_t SharedGeometryBuffer::store(LeafMeshes& meshes, const LeafRef& ref)
+{
+    const std::uint32_t id = find(ref.key);
+    return id != kNone ? id : add(ref.key, meshes.mesh(ref));
+}
+
+bool SharedGeometryBuffer::load(std::uint32_t mesh, CachedMesh& out)
+{
+    if (mesh >= m_meshes.size()) return false;
+    m_out.flush();
+
+    std::ifstream in(m_binFile, std::ios::binary);
+    if (!in) return false;
+
+    MaterialRegistry reg;
+    out = CachedMesh();
+    for (const SharedPrimitive& p : m_meshes[mesh]) {
+        const int idx = reg.getOrCreate(p.color);
+        bool ok = true;
+        if (p.mode == 4) {
+            TriBucket& b = BucketAt(out.triBuckets, idx);
+            ok = ReadArray(in, p.positions, b.vertices) && ReadArray(in, p.normals, b.normals)
+              && ReadArray(in, p.indices, b.indices);
+        } else {
+            EdgeBucket& e = BucketAt(out.edgeBuckets, idx);
+            ok = ReadArray(in, p.positions, e.vertices) && ReadArray(in, p.indices, e.indices);
+        }
+        if (!ok) return false;
+    }
+    out.materials = reg.materials();
+    return true;
+}
+
+void SharedGeometryBuffer::addDocument(const std::string& gltfFile,
+                                       std::vector<SharedPlacement> placements)
+{
+    m_documents.push_back({gltfFile, std::move(placements)});
+}
+
+bool SharedGeometryBuffer::writeDocument(const Document& doc) const
+{
+    std::vector<Gltf::BufferView>              bufferViews;
+    std::vector<Gltf::Accessor>                accessors;
+    std::vector<std::vector<Gltf::Primitive>>  meshes;
+    std::vector<Gltf::Node>                    nodes;
+    MaterialRegistry                           reg;
+    std::unordered_map<std::uint32_t, int>     meshOf;   // stored id → document mesh
+
+    auto view = [&](const SharedArray& range, int target) {
+        bufferViews.push_back({0, range.offset, range.bytes, target});
+        return static_cast<int>(bufferViews.size() - 1);
+    };
+    auto accessor = [&](int bv, int componentType, std::uint32_t count, AccessorType type,
+                        const std::array<float,6>& bounds, bool hasBounds) {
+        accessors.push_back({bv, componentType, count, type, bounds, hasBounds});
+        return static_cast<int>(accessors.size() - 1);
+    };
+
+    for (const SharedPlacement& pl : doc.placements) {
+        if (pl.mesh >= m_meshes.size() || m_meshes[pl.mesh].empty()) continue;
+
+        auto [it, inserted] = meshOf.try_emplace(pl.mesh, static_cast<int>(meshes.size()));
+        if (inserted) {
+            std::vector<Gltf::Primitive> prims;
+            for (const SharedPrimitive& p : m_meshes[pl.mesh]) {
+                const int posAcc = accessor(view(p.positions, 34962), 5126, p.vertexCount,
+                                            AccessorType::Vec3, p.bounds, true);
+                const int nrmAcc = p.mode == 4
+                    ? accessor(view(p.normals, 34962), 5126, p.vertexCount,
+                               AccessorType::Vec3, p.normalBounds, true)
+                    : -1;
+                const int idxAcc = accessor(view(p.indices, 34963), 5125, p.indexCount,
+                                            AccessorType::Scalar, {0,0,0,0,0,0}, false);
+                prims.push_back({posAcc, nrmAcc, idxAcc, reg.getOrCreate(p.color), p.mode});
+            }
+            meshes.push_back(std::move(prims));
+        }
+
+        const bool identity = pl.trsf.Form() == gp_Identity;
+        nodes.push_back({it->second, identity ? std::array<double,16>{} : ColumnMajor(pl.trsf), !identity});
+    }
+
+    if (nodes.empty()) {
+        std::cerr << "[SharedGeometry] No geometry to write for " << doc.file << "\n";
+        return false;
+    }
+
+    // The buffer is referenced relative to the document, which may sit in
+    // a subdirectory (sub-assemblies)
+    std::error_code ec;
+    const std::filesystem::path docDir = std::filesystem::path(doc.file).parent_path();
+    std::filesystem::path uri = std::filesystem::relative(m_binFile, docDir.empty() ? "." : docDir, ec);
+    if (ec || uri.empty()) uri = std::filesystem::path(m_binFile).filename();
+
+    const std::vector<Gltf::Buffer> buffers = {{m_bytes, uri.generic_string()}};
+    GltfJsonWriter json(GltfJsonWriter::EstimateBytes(reg.materials().size(), accessors.size() / 3,
+                                                      bufferViews.size(), accessors.size())
+                        + nodes.size() * 200);
+    json.writeInstancedScene(reg.materials(), meshes, nodes, buffers, bufferViews, accessors);
+
+    std::ofstream out(doc.file, std::ios::binary);
+    if (!out) {
+        std::cerr << "Cannot open output file: " << doc.file << "\n";
+        return false;
+    }
+    out.write(json.str().data(), static_cast<std::streamsize>(json.str().size()));
+    out.close();
+    if (!out) {
+        std::cerr << "Write failed: " << doc.file << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool SharedGeometryBuffer::finish()
+{
+    Trace::Span span("SharedDocuments", "io", m_binFile);
+
+    m_out.close();
+    if (!m_out) m_ok = false;
+
+    std::size_t written = 0;
+    for (const Document& doc : m_documents) {
+        if (writeDocument(doc)) ++written;
+    }
+    const std::size_t queued = m_documents.size();
+    m_documents.clear();
+
+    std::cout << "✅ Shared geometry: " << m_meshes.size() << " mesh(es), "
+              << m_bytes / 1024.0 << " KB in " << m_binFile << ", referenced by "
+              << written << " .gltf file(s)\n";
+    if (written != queued) {
+        std::cerr << "❌ " << queued - written << " of " << queued << " .gltf file(s) not written\n";
+    }
+    return m_ok && written == queued;
+}
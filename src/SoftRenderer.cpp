@@ -0,0 +1,452 @@
+#include "SoftRenderer.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace {
+
+constexpr float  kAmbient   = 0.35f;
+constexpr float  kDiffuse   = 0.65f;
+constexpr double kFitMargin = 0.05;     // of the image, on every side
+constexpr double kEdgeBias  = 0.005;    // of the scene diagonal, toward the eye
+constexpr std::uint32_t kBackground = 0xFFFFFF;
+
+struct Vec3d {
+    double x, y, z;
+};
+
+double Dot(const Vec3d& a, const Vec3d& b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+
+Vec3d Cross(const Vec3d& a, const Vec3d& b)
+{
+    return {a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+Vec3d Normalized(const Vec3d& v)
+{
+    const double l = std::sqrt(Dot(v, v));
+    return l > 0.0 ? Vec3d{v.x / l, v.y / l, v.z / l} : Vec3d{0, 0, 1};
+}
+
+// Orthographic camera along one of the RenderView directions (the
+// projections RenderSession uses), scaled to fit the frame
+struct Camera {
+    Vec3d  right, up, forward;   // forward points into the screen
+    Vec3d  center;
+    double scale = 1.0;          // pixels per model unit
+    double cx = 0.0, cy = 0.0;   // frame position of `center`
+
+    float px(const Vertex& v) const { return static_cast<float>(cx + scale * along(v, right)); }
+    float py(const Vertex& v) const { return static_cast<float>(cy - scale * along(v, up)); }
+    float pz(const Vertex& v) const { return static_cast<float>(along(v, forward)); }
+
+    double along(const Vertex& v, const Vec3d& axis) const {
+        return (v.x - center.x) * axis.x + (v.y - center.y) * axis.y + (v.z - center.z) * axis.z;
+    }
+};
+
+struct ScreenVertex {
+    float x, y, z;
+    float shade;                 // Lambert term (smooth shading)
+};
+
+struct ScreenTri {
+    std::uint32_t v[3];
+    float         rgb[3];
+    float         shade;         // Lambert term of the face (flat shading)
+};
+
+struct ScreenSeg {
+    std::uint32_t v[2];
+    std::uint32_t color;
+};
+
+struct Frame {
+    int width = 0, height = 0;
+    std::vector<float>         depth;
+    std::vector<std::uint32_t> color;   // 0xRRGGBB
+};
+
+std::uint32_t Pack(float r, float g, float b)
+{
+    auto c = [](float v) {
+        return static_cast<std::uint32_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+    };
+    return (c(r) << 16) | (c(g) << 8) | c(b);
+}
+
+RGBA SurfaceColor(const std::vector<RGBA>& materials, int index)
+{
+    const RGBA defaultGray{0.7f, 0.7f, 0.7f, 1.0f};
+    if (index < 0 || static_cast<std::size_t>(index) >= materials.size()) return defaultGray;
+    const RGBA& c = materials[static_cast<std::size_t>(index)];
+    if (c.r == 0.0f && c.g == 0.0f && c.b == 0.0f) return defaultGray;
+    return c;
+}
+
+std::uint32_t EdgeColor(const RGBA& surface)
+{
+    const float brightness = 0.299f*surface.r + 0.587f*surface.g + 0.114f*surface.b;
+    return brightness > 0.5f ? Pack(0.1f, 0.1f, 0.1f) : Pack(0.9f, 0.9f, 0.9f);
+}
+
+// Edge-function rasterization of one triangle, limited to rows [y0, y1)
+void RasterTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c,
+                    const ScreenTri& t, bool smooth, int y0, int y1, Frame& f)
+{
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (!(std::fabs(area) > 0.0f)) return;
+
+    const int xMin = std::max(0,        static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+    const int xMax = std::min(f.width,  static_cast<int>(std::ceil (std::max({a.x, b.x, c.x}))) + 1);
+    const int yMin = std::max(y0,       static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+    const int yMax = std::min(y1,       static_cast<int>(std::ceil (std::max({a.y, b.y, c.y}))) + 1);
+    if (xMin >= xMax || yMin >= yMax) return;
+
+    // Barycentric weights of a, b, c as affine functions of the pixel centre
+    const float inv = 1.0f / area;
+    const float dw0x = (b.y - c.y) * inv;
+    const float dw1x = (c.y - a.y) * inv;
+
+    for (int y=yMin; y<yMax; ++y) {
+        const float sy = static_cast<float>(y) + 0.5f;
+        const float sx = static_cast<float>(xMin) + 0.5f;
+        float w0 = ((b.x - sx) * (c.y - sy) - (b.y - sy) * (c.x - sx)) * inv;
+        float w1 = ((c.x - sx) * (a.y - sy) - (c.y - sy) * (a.x - sx)) * inv;
+
+        std::size_t idx = static_cast<std::size_t>(y) * f.width + xMin;
+        for (int x=xMin; x<xMax; ++x, ++idx, w0 += dw0x, w1 += dw1x) {
+            const float w2 = 1.0f - w0 - w1;
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+            const float z = w0 * a.z + w1 * b.z + w2 * c.z;
+            if (z >= f.depth[idx]) continue;
+            f.depth[idx] = z;
+
+            const float s = smooth ? w0 * a.shade + w1 * b.shade + w2 * c.shade : t.shade;
+            f.color[idx] = Pack(t.rgb[0] * s, t.rgb[1] * s, t.rgb[2] * s);
+        }
+    }
+}
+
+// Segment stamped with a square pen `pen` pixels wide, depth-tested with a
+// bias so edges lying on a face win against it; rows [y0, y1) only
+void RasterSegment(const ScreenVertex& a, const ScreenVertex& b, std::uint32_t color,
+                   int pen, float bias, int y0, int y1, Frame& f)
+{
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::fabs(dx), std::fabs(dy)))));
+    const int lo = pen / 2, hi = pen - lo;
+
+    for (int s=0; s<=steps; ++s) {
+        const float t = static_cast<float>(s) / static_cast<float>(steps);
+        const int   cx = static_cast<int>(std::floor(a.x + dx * t));
+        const int   cy = static_cast<int>(std::floor(a.y + dy * t));
+        const float z  = a.z + (b.z - a.z) * t - bias;
+
+        const int ys = std::max(y0, cy - lo), ye = std::min(y1, cy + hi);
+        const int xs = std::max(0,  cx - lo), xe = std::min(f.width, cx + hi);
+        for (int y=ys; y<ye; ++y) {
+            std::size_t idx = static_cast<std::size_t>(y) * f.width + xs;
+            for (int x=xs; x<xe; ++x, ++idx) {
+                if (z <= f.depth[idx]) f.color[idx] = color;
+            }
+        }
+    }
+}
+
+} // namespace
+
+RgbImage RenderBuckets(const std::vector<TriBucket>&  tris,
+                       const std::vector<EdgeBucket>& edges,
+                       const std::vector<RGBA>&       materials,
+                       const SoftRenderOptions&       opt)
+{
+    Trace::Span span("RenderBuckets", "render");
+
+    const int ss = std::max(1, opt.supersample);
+    const int W  = std::max(1, opt.width), H = std::max(1, opt.height);
+
+    // Bounds of everything drawn
+    double lo[3] = { 1e300,  1e300,  1e300};
+    double hi[3] = {-1e300, -1e300, -1e300};
+    auto extend = [&](const Vertex& v) {
+        lo[0] = std::min(lo[0], double(v.x)); hi[0] = std::max(hi[0], double(v.x));
+        lo[1] = std::min(lo[1], double(v.y)); hi[1] = std::max(hi[1], double(v.y));
+        lo[2] = std::min(lo[2], double(v.z)); hi[2] = std::max(hi[2], double(v.z));
+    };
+    for (const auto& b : tris)  for (const auto& v : b.vertices) extend(v);
+    if (opt.edges) {
+        for (const auto& e : edges) for (const auto& v : e.vertices) extend(v);
+    }
+    if (lo[0] > hi[0]) return {};
+
+    Camera cam;
+    Vec3d eye{1.0, -1.0, 1.0}, upHint{0.0, 0.0, 1.0};
+    switch (opt.view) {
+        case RenderView::Iso:   break;
+        case RenderView::Front: eye = {0.0, -1.0, 0.0}; break;
+        case RenderView::Top:   eye = {0.0,  0.0, 1.0}; upHint = {0.0, 1.0, 0.0}; break;
+        case RenderView::Side:  eye = {1.0,  0.0, 0.0}; break;
+    }
+    cam.forward = Normalized({-eye.x, -eye.y, -eye.z});
+    const double k = Dot(upHint, cam.forward);
+    cam.up      = Normalized({upHint.x - k * cam.forward.x,
+                              upHint.y - k * cam.forward.y,
+                              upHint.z - k * cam.forward.z});
+    cam.right   = Cross(cam.forward, cam.up);
+    cam.center  = {0.5 * (lo[0] + hi[0]), 0.5 * (lo[1] + hi[1]), 0.5 * (lo[2] + hi[2])};
+
+    // Fit the projected bounding box, as V3d_View::FitAll does
+    double minR = 1e300, maxR = -1e300, minU = 1e300, maxU = -1e300;
+    for (int c=0; c<8; ++c) {
+        const Vertex corner{static_cast<float>((c & 1) ? hi[0] : lo[0]),
+                            static_cast<float>((c & 2) ? hi[1] : lo[1]),
+                            static_cast<float>((c & 4) ? hi[2] : lo[2])};
+        const double r = cam.along(corner, cam.right), u = cam.along(corner, cam.up);
+        minR = std::min(minR, r); maxR = std::max(maxR, r);
+        minU = std::min(minU, u); maxU = std::max(maxU, u);
+    }
+    const int FW = W * ss, FH = H * ss;
+    const double usable = 1.0 - 2.0 * kFitMargin;
+    const double spanR = std::max(maxR - minR, 1e-12), spanU = std::max(maxU - minU, 1e-12);
+    cam.scale = std::min(FW * usable / spanR, FH * usable / spanU);
+    cam.cx    = 0.5 * FW - cam.scale * 0.5 * (minR + maxR);
+    cam.cy    = 0.5 * FH + cam.scale * 0.5 * (minU + maxU);
+
+    const double diag = std::sqrt((hi[0]-lo[0])*(hi[0]-lo[0]) + (hi[1]-lo[1])*(hi[1]-lo[1])
+                                + (hi[2]-lo[2])*(hi[2]-lo[2]));
+    const float bias = static_cast<float>(kEdgeBias * diag);
+
+    // Key light over the viewer's right shoulder; two-sided
+    const Vec3d light = Normalized({-cam.forward.x + 0.4*cam.up.x + 0.3*cam.right.x,
+                                    -cam.forward.y + 0.4*cam.up.y + 0.3*cam.right.y,
+                                    -cam.forward.z + 0.4*cam.up.z + 0.3*cam.right.z});
+    auto lambert = [&](const Vec3d& n) {
+        return kAmbient + kDiffuse * static_cast<float>(std::fabs(Dot(Normalized(n), light)));
+    };
+
+    // ── Project ─────────────────────────────────────────────────────────
+    const bool smooth = opt.shading == SoftShading::Lambert;
+    std::vector<ScreenVertex> sv;
+    std::vector<ScreenTri>    st;
+    {
+        std::size_t nv = 0, nt = 0;
+        for (const auto& b : tris) { nv += b.vertices.size(); nt += b.indices.size() / 3; }
+        sv.reserve(nv);
+        st.reserve(nt);
+    }
+    for (const auto& b : tris) {
+        const std::uint32_t base = static_cast<std::uint32_t>(sv.size());
+        const bool haveNormals = smooth && b.normals.size() == b.vertices.size();
+        for (std::size_t i=0; i<b.vertices.size(); ++i) {
+            const Vertex& v = b.vertices[i];
+            float shade = 1.0f;
+            if (haveNormals) {
+                const Normal& n = b.normals[i];
+                shade = lambert({n.x, n.y, n.z});
+            }
+            sv.push_back({cam.px(v), cam.py(v), cam.pz(v), shade});
+        }
+
+        const RGBA col = SurfaceColor(materials, b.materialIndex);
+        for (std::size_t i=0; i+2<b.indices.size(); i+=3) {
+            const std::uint32_t i0 = b.indices[i], i1 = b.indices[i+1], i2 = b.indices[i+2];
+            if (i0 >= b.vertices.size() || i1 >= b.vertices.size() || i2 >= b.vertices.size()) continue;
+
+            const Vertex& p0 = b.vertices[i0];
+            const Vertex& p1 = b.vertices[i1];
+            const Vertex& p2 = b.vertices[i2];
+            const Vec3d n = Cross({double(p1.x) - p0.x, double(p1.y) - p0.y, double(p1.z) - p0.z},
+                                  {double(p2.x) - p0.x, double(p2.y) - p0.y, double(p2.z) - p0.z});
+            ScreenTri t{{base + i0, base + i1, base + i2}, {col.r, col.g, col.b}, lambert(n)};
+            if (smooth && !haveNormals) {
+                // No vertex normals: fall back to the face term
+                for (std::uint32_t k : t.v) sv[k].shade = t.shade;
+            }
+            st.push_back(t);
+        }
+    }
+
+    std::vector<ScreenVertex> ev;
+    std::vector<ScreenSeg>    es;
+    if (opt.edges) {
+        for (const auto& e : edges) {
+            const std::uint32_t base = static_cast<std::uint32_t>(ev.size());
+            for (const auto& v : e.vertices) ev.push_back({cam.px(v), cam.py(v), cam.pz(v), 1.0f});
+            const std::uint32_t color = EdgeColor(SurfaceColor(materials, e.materialIndex));
+            for (std::size_t i=0; i+1<e.indices.size(); i+=2) {
+                const std::uint32_t i0 = e.indices[i], i1 = e.indices[i+1];
+                if (i0 >= e.vertices.size() || i1 >= e.vertices.size()) continue;
+                es.push_back({{base + i0, base + i1}, color});
+            }
+        }
+    }
+
+    // ── Bin into horizontal bands ───────────────────────────────────────
+    unsigned threads = opt.threads ? opt.threads : std::thread::hardware_concurrency();
+    threads = std::max(1u, threads);
+    const int bands  = std::min(FH, static_cast<int>(threads) * 8);
+    const int bandH  = (FH + bands - 1) / bands;
+    const int pen    = ss;
+
+    auto bandRange = [&](float yMin, float yMax, int pad, int& first, int& last) {
+        first = std::max(0,         static_cast<int>(std::floor(yMin)) - pad) / bandH;
+        last  = std::min(FH - 1,    static_cast<int>(std::ceil (yMax)) + pad) / bandH;
+    };
+
+    std::vector<std::vector<std::uint32_t>> triBins(bands), segBins(bands);
+    for (std::uint32_t i=0; i<st.size(); ++i) {
+        const ScreenTri& t = st[i];
+        const float y0 = std::min({sv[t.v[0]].y, sv[t.v[1]].y, sv[t.v[2]].y});
+        const float y1 = std::max({sv[t.v[0]].y, sv[t.v[1]].y, sv[t.v[2]].y});
+        if (y1 < 0.0f || y0 >= FH) continue;
+        int first, last;
+        bandRange(y0, y1, 0, first, last);
+        for (int b=first; b<=last; ++b) triBins[b].push_back(i);
+    }
+    for (std::uint32_t i=0; i<es.size(); ++i) {
+        const ScreenSeg& s = es[i];
+        const float y0 = std::min(ev[s.v[0]].y, ev[s.v[1]].y);
+        const float y1 = std::max(ev[s.v[0]].y, ev[s.v[1]].y);
+        if (y1 + pen < 0.0f || y0 - pen >= FH) continue;
+        int first, last;
+        bandRange(y0, y1, pen, first, last);
+        for (int b=first; b<=last; ++b) segBins[b].push_back(i);
+    }
+
+    // ── Rasterize bands in parallel ─────────────────────────────────────
+    Frame frame;
+    frame.width  = FW;
+    frame.height = FH;
+    frame.depth.assign(static_cast<std::size_t>(FW) * FH, std::numeric_limits<float>::infinity());
+    frame.color.assign(static_cast<std::size_t>(FW) * FH, kBackground);
+
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int b = next++; b < bands; b = next++) {
+            const int y0 = b * bandH, y1 = std::min(FH, y0 + bandH);
+            for (std::uint32_t i : triBins[b]) {
+                const ScreenTri& t = st[i];
+                RasterTriangle(sv[t.v[0]], sv[t.v[1]], sv[t.v[2]], t, smooth, y0, y1, frame);
+            }
+            for (std::uint32_t i : segBins[b]) {
+                const ScreenSeg& s = es[i];
+                RasterSegment(ev[s.v[0]], ev[s.v[1]], s.color, pen, bias, y0, y1, frame);
+            }
+        }
+    };
+    {
+        Trace::Span rasterSpan("Rasterize", "render");
+        std::vector<std::thread> pool;
+        const unsigned extra = std::min<unsigned>(threads, static_cast<unsigned>(bands)) - 1;
+        for (unsigned t=0; t<extra; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+    }
+
+    // ── Box-filter down to the output size ──────────────────────────────
+    RgbImage image(W, H);
+    const unsigned n = static_cast<unsigned>(ss * ss);
+    for (int y=0; y<H; ++y) {
+        for (int x=0; x<W; ++x) {
+            unsigned r = 0, g = 0, b = 0;
+            for (int sy=0; sy<ss; ++sy) {
+                const std::uint32_t* row = frame.color.data()
+                                         + static_cast<std::size_t>(y * ss + sy) * FW + x * ss;
+                for (int sx=0; sx<ss; ++sx) {
+                    r += (row[sx] >> 16) & 0xFF;
+                    g += (row[sx] >> 8)  & 0xFF;
+                    b +=  row[sx]        & 0xFF;
+                }
+            }
+            std::uint8_t* px = &image.pixels[(static_cast<std::size_t>(y) * W + x) * 3];
+            px[0] = static_cast<std::uint8_t>((r + n / 2) / n);
+            px[1] = static_cast<std::uint8_t>((g + n / 2) / n);
+            px[2] = static_cast<std::uint8_t>((b + n / 2) / n);
+        }
+    }
+    return image;
+}
+
+int SupersampleFor(RenderQuality quality)
+{
+    switch (quality) {
+        case RenderQuality::Draft:    return 1;
+        case RenderQuality::Standard: return 2;
+        case RenderQuality::High:     return 3;
+    }
+    return 3;
+}
+
+bool RenderBucketsPNG(const std::vector<TriBucket>&  tris,
+                      const std::vector<EdgeBucket>& edges,
+                      const std::vector<RGBA>&       materials,
+                      const std::string&             pngFile,
+                      const ThumbnailSpec&           spec,
+                      AsyncImageWriter*              async)
+{
+    std::cout << "Rendering PNG (software) for " << pngFile << " ...\n";
+    Trace::Span span("RenderBucketsPNG", "render", pngFile);
+
+    const std::vector<RenderView> views =
+        spec.views.empty() ? std::vector<RenderView>{RenderView::Iso} : spec.views;
+    const std::vector<std::string> files = ThumbnailFiles(pngFile, spec);
+
+    SoftRenderOptions opt;
+    opt.width       = spec.size;
+    opt.height      = spec.size;
+    opt.supersample = SupersampleFor(spec.quality);
+
+    // Synchronous writes are counted here; queued ones by the writer
+    std::uint64_t bytes = 0;
+    auto store = [&](RgbImage&& image, const std::string& file) {
+        if (!StoreImage(std::move(image), file, spec.encode, async)) {
+            std::cerr << "❌ Failed to save image file.\n";
+            return false;
+        }
+        if (!async) {
+            std::error_code ec;
+            bytes += std::filesystem::file_size(file, ec);
+        }
+        return true;
+    };
+
+    RgbImage sheet;
+    for (std::size_t v=0; v<views.size(); ++v) {
+        opt.view = views[v];
+        RgbImage image = RenderBuckets(tris, edges, materials, opt);
+        if (image.width == 0) {
+            std::cerr << "❌ No mesh available for rendering.\n";
+            return false;
+        }
+
+        if (spec.spriteSheet && views.size() > 1) {
+            // Views side by side, left to right in request order
+            if (sheet.width == 0) sheet = RgbImage(image.width * static_cast<int>(views.size()), image.height);
+            const std::size_t rowBytes = static_cast<std::size_t>(image.width) * 3;
+            for (int y=0; y<image.height; ++y) {
+                std::copy_n(&image.pixels[static_cast<std::size_t>(y) * rowBytes], rowBytes,
+                            &sheet.pixels[(static_cast<std::size_t>(y) * sheet.width + v * image.width) * 3]);
+            }
+            continue;
+        }
+
+        if (!store(std::move(image), files[v])) return false;
+        std::cout << "🖼️  Anti-aliased image " << (async ? "queued for " : "saved as ") << files[v] << std::endl;
+    }
+
+    if (sheet.width != 0) {
+        if (!store(std::move(sheet), pngFile)) return false;
+        std::cout << "🖼️  Sprite sheet (" << views.size() << " views) "
+                  << (async ? "queued for " : "saved as ") << pngFile << std::endl;
+    }
+    span.setBytes(bytes);
+    return true;
+}
@@ -0,0 +1,186 @@
+#include "SpillStore.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SpillFile::SpillFile(const std::string& dir, std::size_t chunkBytes)
+{
+    m_page  = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    m_chunk = std::max(m_page, (chunkBytes + m_page - 1) / m_page * m_page);
+
+    std::string tmpl = (dir.empty() ? std::string(".") : dir) + "/stepguru_spill_XXXXXX";
+    m_fd = mkstemp(tmpl.data());
+    if (m_fd < 0) {
+        throw std::runtime_error("Cannot create spill file in " + dir + ": "
+                                 + std::strerror(errno));
+    }
+    // Anonymous from here on: the space is reclaimed when the fd closes
+    unlink(tmpl.c_str());
+}
+
+SpillFile::~SpillFile()
+{
+    unmapWindow();
+    if (m_fd >= 0) close(m_fd);
+}
+
+void SpillFile::unmapWindow()
+{
+    if (m_window) {
+        munmap(m_window, m_chunk);
+        m_window = nullptr;
+    }
+}
+
+void SpillFile::mapWindow(std::size_t offset)
+{
+    unmapWindow();
+
+    std::size_t end = offset + m_chunk;
+    if (end > m_fileSize) {
+        if (ftruncate(m_fd, static_cast<off_t>(end)) != 0) {
+            throw std::runtime_error(std::string("Cannot grow spill file: ") + std::strerror(errno));
+        }
+        m_fileSize = end;
+    }
+
+    void* p = mmap(nullptr, m_chunk, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   m_fd, static_cast<off_t>(offset));
+    if (p == MAP_FAILED) {
+        throw std::runtime_error(std::string("Cannot map spill file: ") + std::strerror(errno));
+    }
+    m_window    = static_cast<char*>(p);
+    m_windowOff = offset;
+}
+
+std::size_t SpillFile::append(const void* data, std::size_t bytes)
+{
+    const std::size_t start = m_size;
+    const char* src = static_cast<const char*>(data);
+
+    while (bytes > 0) {
+        if (!m_window || m_size >= m_windowOff + m_chunk) {
+            mapWindow(m_size / m_chunk * m_chunk);
+        }
+        std::size_t inWindow = m_size - m_windowOff;
+        std::size_t n = std::min(bytes, m_chunk - inWindow);
+        std::memcpy(m_window + inWindow, src, n);
+        src    += n;
+        bytes  -= n;
+        m_size += n;
+    }
+    return start;
+}
+
+bool SpillFile::copyTo(std::ostream& out, std::size_t offset, std::size_t bytes) const
+{
+    const std::size_t end = std::min(offset + bytes, m_size);
+    while (offset < end) {
+        // Page-aligned mapping of at most one chunk
+        const std::size_t mapOff = offset / m_page * m_page;
+        const std::size_t n      = std::min(m_chunk, end - mapOff);
+        void* p = mmap(nullptr, n, PROT_READ, MAP_SHARED, m_fd, static_cast<off_t>(mapOff));
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        madvise(p, n, MADV_SEQUENTIAL);
+        out.write(static_cast<const char*>(p) + (offset - mapOff),
+                  static_cast<std::streamsize>(mapOff + n - offset));
+        munmap(p, n);
+        if (!out) return false;
+        offset = mapOff + n;
+    }
+    return true;
+}
+
+template <typename Vec3Array>
+static void GrowBounds(std::array<float,6>& b, bool first, const Vec3Array& v)
+{
+    if (v.empty()) return;
+    auto mm = calcMinMax(v, false);
+    if (first) {
+        b = mm;
+        return;
+    }
+    for (int k=0; k<3; ++k) {
+        b[k]     = std::min(b[k],     mm[k]);
+        b[k + 3] = std::max(b[k + 3], mm[k + 3]);
+    }
+}
+
+void SpillBucketStore::put(SpillArray& array, const void* data, std::size_t bytes)
+{
+    if (bytes == 0) return;
+    if (!m_file) m_file = std::make_unique<SpillFile>(m_dir);
+
+    const std::size_t offset = m_file->append(data, bytes);
+    if (!array.ranges.empty() &&
+        array.ranges.back().offset + array.ranges.back().bytes == offset)
+    {
+        array.ranges.back().bytes += bytes;
+    } else {
+        array.ranges.push_back({offset, bytes});
+    }
+    array.bytes += bytes;
+}
+
+bool SpillBucketStore::copyTo(std::ostream& out, const SpillArray& array) const
+{
+    if (!m_file) return array.ranges.empty();
+    for (const auto& r : array.ranges) {
+        if (!m_file->copyTo(out, r.offset, r.bytes)) return false;
+    }
+    return true;
+}
+
+void SpillBucketStore::append(const std::vector<TriBucket>& tris,
+                              const std::vector<EdgeBucket>& edges)
+{
+    std::vector<std::uint32_t> rebased;
+
+    for (std::size_t m=0; m<tris.size(); ++m) {
+        const TriBucket& b = tris[m];
+        if (b.vertices.empty() || b.indices.empty()) continue;
+        if (m >= m_tris.size()) m_tris.resize(m + 1);
+
+        SpilledTriBucket& dst = m_tris[m];
+        dst.materialIndex = static_cast<int>(m);
+
+        const auto base = static_cast<std::uint32_t>(dst.vertexCount);
+        rebased.resize(b.indices.size());
+        for (std::size_t i=0; i<b.indices.size(); ++i) rebased[i] = b.indices[i] + base;
+
+        GrowBounds(dst.bounds, dst.vertexCount == 0, b.vertices);
+        GrowBounds(dst.normalBounds, dst.vertexCount == 0, b.normals);
+        put(dst.vertices, b.vertices.data(), b.vertices.size() * sizeof(Vertex));
+        put(dst.normals,  b.normals.data(),  b.normals.size()  * sizeof(Normal));
+        put(dst.indices,  rebased.data(),    rebased.size()    * sizeof(std::uint32_t));
+        dst.vertexCount += b.vertices.size();
+        dst.indexCount  += b.indices.size();
+    }
+
+    for (std::size_t m=0; m<edges.size(); ++m) {
+        const EdgeBucket& e = edges[m];
+        if (e.vertices.empty() || e.indices.empty()) continue;
+        if (m >= m_edges.size()) m_edges.resize(m + 1);
+
+        SpilledEdgeBucket& dst = m_edges[m];
+        dst.materialIndex = static_cast<int>(m);
+
+        const auto base = static_cast<std::uint32_t>(dst.vertexCount);
+        rebased.resize(e.indices.size());
+        for (std::size_t i=0; i<e.indices.size(); ++i) rebased[i] = e.indices[i] + base;
+
+        GrowBounds(dst.bounds, dst.vertexCount == 0, e.vertices);
+        put(dst.vertices, e.vertices.data(), e.vertices.size() * sizeof(Vertex));
+        put(dst.indices,  rebased.data(),    rebased.size()    * sizeof(std::uint32_t));
+        dst.vertexCount += e.vertices.size();
+        dst.indexCount  += e.indices.size();
+    }
+}
@@ -0,0 +1,76 @@
+#include "SubassemblyExporter.hpp"
+#include "AssemblyIndex.hpp"
+#include "GlbBuilder.hpp"
+#include "LeafMeshes.hpp"
+#include "SharedGeometry.hpp"
+#include "Trace.hpp"
+
+#include <gp_Trsf.hxx>
+
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+bool ExportSubassemblies(const AssemblyIndex&              index,
+                         LeafMeshes&                       meshes,
+                         const std::vector<std::uint32_t>& rootNodes,
+                         const std::string&                dir,
+                         const SubassemblyOptions&         opt)
+{
+    Trace::Span span("Subassemblies", "phase", dir);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    const std::string prefix = (dir.empty() || dir.back() == '/') ? dir : dir + "/";
+
+    const std::size_t extractedBefore = meshes.extracted();
+    std::unordered_set<std::string> written;
+    std::size_t glbs = 0, failed = 0, placements = 0;
+    for (std::uint32_t root : rootNodes) {
+        for (std::uint32_t a=root+1; a<index.subtreeEnd(root); ++a) {
+            if (index.firstChild(a) == AssemblyIndex::kNone) continue;
+            const std::string& path = index.path(index.def(a));
+            if (!written.insert(path).second) continue;
+
+            Trace::Span asmSpan("Subassembly", "component", path);
+
+            // Leaves are placed relative to this occurrence, which puts them
+            // in the definition's frame whichever occurrence comes first
+            const gp_Trsf toLocal = index.world(a).Inverted();
+            if (opt.shared) {
+                std::vector<SharedPlacement> shared;
+                for (std::uint32_t n=a+1; n<index.subtreeEnd(a); ++n) {
+                    if (!meshes.isLeaf(n)) continue;
+                    const LeafRef ref = meshes.ref(n);
+                    shared.push_back({opt.shared->store(meshes, ref),
+                                      toLocal.Multiplied(index.world(n)).Multiplied(ref.motion)});
+                }
+                placements += shared.size();
+                if (shared.empty()) continue;
+                opt.shared->addDocument(prefix + "out_" + path + "_1.gltf", std::move(shared));
+                ++glbs;
+                continue;
+            }
+
+            MaterialRegistry reg;
+            std::vector<TriBucket>  tris;
+            std::vector<EdgeBucket> edges;
+            placements += meshes.compose(a, toLocal, reg, tris, edges);
+            if (tris.empty() && edges.empty()) continue;
+
+            GlbBuilder builder;
+            builder.setBufferLayout(opt.bufferLayout, opt.maxBufferBytes);
+            builder.addBuckets(std::move(tris), std::move(edges), reg.materials());
+            ExportStats stats;
+            if (builder.writeGlb(prefix + "out_" + path + "_1.glb", false, stats)) ++glbs;
+            else ++failed;
+        }
+    }
+
+    std::cout << "✅ Sub-assemblies: " << glbs << (opt.shared ? " .gltf(s)" : " GLB(s)")
+              << " from " << placements << " leaf placement(s), "
+              << meshes.extracted() - extractedBefore << " leaf mesh(es) extracted → "
+              << prefix << "\n";
+    return failed == 0;
+}
@@ -0,0 +1,397 @@
+#include "TileExporter.hpp"
+#include "AssemblyIndex.hpp"
+#include "GlbBuilder.hpp"
+#include "LeafMeshes.hpp"
+#include "MeshExtractor.hpp"
+#include "Trace.hpp"
+
+#include <rapidjson/writer.h>
+#include <rapidjson/filewritestream.h>
+
+#include <gp_Pnt.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace rapidjson;
+
+namespace {
+
+using Box = std::array<double, 6>;   // min xyz, max xyz
+
+constexpr Box kEmptyBox = {1e300, 1e300, 1e300, -1e300, -1e300, -1e300};
+
+bool IsEmpty(const Box& b) { return b[0] > b[3]; }
+
+void Extend(Box& b, const Box& o)
+{
+    for (int k=0; k<3; ++k) {
+        b[k]     = std::min(b[k],     o[k]);
+        b[k + 3] = std::max(b[k + 3], o[k + 3]);
+    }
+}
+
+double Diagonal(const Box& b)
+{
+    if (IsEmpty(b)) return 0.0;
+    const double dx = b[3] - b[0], dy = b[4] - b[1], dz = b[5] - b[2];
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+double HalfExtent(const Box& b)
+{
+    return 0.5 * std::max({b[3] - b[0], b[4] - b[1], b[5] - b[2]});
+}
+
+// World AABB of a transformed definition-space box (all eight corners)
+Box TransformBox(const Box& b, const gp_Trsf& T)
+{
+    Box out = kEmptyBox;
+    for (int c=0; c<8; ++c) {
+        gp_Pnt p((c & 1) ? b[3] : b[0], (c & 2) ? b[4] : b[1], (c & 4) ? b[5] : b[2]);
+        p.Transform(T);
+        Extend(out, {p.X(), p.Y(), p.Z(), p.X(), p.Y(), p.Z()});
+    }
+    return out;
+}
+
+// One definition meshed in one color, in definition coordinates
+struct MeshSource {
+    LeafRef       ref;
+    Box           box;
+    std::size_t   triangles;
+};
+
+// One leaf occurrence
+struct Item {
+    std::uint32_t source;
+    gp_Trsf       placement;    // source mesh → world
+    Box           box;          // world space
+};
+
+struct OctNode {
+    Box           cell;         // cubic cell; items are sorted by center
+    std::uint32_t level, x, y, z;
+    std::vector<std::uint32_t>   items;
+    std::array<std::uint32_t, 8> children;
+    Box           bounds;       // content of the whole subtree
+    double        maxItemSize;  // largest item diagonal in the subtree
+};
+
+// Loose octree (looseness 2): an item goes to the child octant holding its
+// center as long as it is no larger than that child's cell, so it can
+// overhang the cell by at most half a cell on each side. Items too large
+// for every child stay in the node and are drawn in its tile.
+class LooseOctree {
+public:
+    LooseOctree(const std::vector<Item>&       items,
+                const std::vector<MeshSource>& sources,
+                const TileOptions&             opt)
+        : m_items(items), m_sources(sources), m_opt(opt) {}
+
+    void build()
+    {
+        Box all = kEmptyBox;
+        std::vector<std::uint32_t> ids(m_items.size());
+        for (std::uint32_t i=0; i<ids.size(); ++i) {
+            ids[i] = i;
+            Extend(all, m_items[i].box);
+        }
+        const double half = std::max(HalfExtent(all), 1e-6);
+        const double c[3] = {0.5 * (all[0] + all[3]), 0.5 * (all[1] + all[4]), 0.5 * (all[2] + all[5])};
+
+        m_nodes.clear();
+        addNode({c[0] - half, c[1] - half, c[2] - half, c[0] + half, c[1] + half, c[2] + half},
+                0, 0, 0, 0, std::move(ids));
+        split(0);
+        finish();
+    }
+
+    const std::vector<OctNode>& nodes() const { return m_nodes; }
+
+private:
+    std::uint32_t addNode(const Box& cell, std::uint32_t level, std::uint32_t x,
+                          std::uint32_t y, std::uint32_t z, std::vector<std::uint32_t> items)
+    {
+        OctNode n;
+        n.cell  = cell;
+        n.level = level; n.x = x; n.y = y; n.z = z;
+        n.items = std::move(items);
+        n.children.fill(AssemblyIndex::kNone);
+        n.bounds      = kEmptyBox;
+        n.maxItemSize = 0.0;
+        m_nodes.push_back(std::move(n));
+        return static_cast<std::uint32_t>(m_nodes.size() - 1);
+    }
+
+    void split(std::uint32_t n)
+    {
+        std::size_t tris = 0;
+        for (std::uint32_t i : m_nodes[n].items) tris += m_sources[m_items[i].source].triangles;
+        if (tris <= m_opt.maxTrianglesPerTile || m_nodes[n].level >= m_opt.maxDepth) return;
+
+        const Box cell = m_nodes[n].cell;
+        const double childHalf = 0.25 * (cell[3] - cell[0]);
+        const double mid[3] = {0.5 * (cell[0] + cell[3]), 0.5 * (cell[1] + cell[4]), 0.5 * (cell[2] + cell[5])};
+
+        std::vector<std::uint32_t> keep;
+        std::array<std::vector<std::uint32_t>, 8> octants;
+        for (std::uint32_t i : m_nodes[n].items) {
+            const Box& b = m_items[i].box;
+            if (HalfExtent(b) > childHalf) {
+                keep.push_back(i);
+                continue;
+            }
+            int o = 0;
+            for (int k=0; k<3; ++k) {
+                if (0.5 * (b[k] + b[k + 3]) >= mid[k]) o |= 1 << k;
+            }
+            octants[o].push_back(i);
+        }
+        if (keep.size() == m_nodes[n].items.size()) return;
+        m_nodes[n].items = std::move(keep);
+
+        for (int o=0; o<8; ++o) {
+            if (octants[o].empty()) continue;
+            Box c;
+            for (int k=0; k<3; ++k) {
+                c[k]     = (o & (1 << k)) ? mid[k]  : cell[k];
+                c[k + 3] = (o & (1 << k)) ? cell[k + 3] : mid[k];
+            }
+            const OctNode& p = m_nodes[n];
+            const std::uint32_t child = addNode(c, p.level + 1,
+                                                2 * p.x + (o & 1), 2 * p.y + ((o >> 1) & 1),
+                                                2 * p.z + ((o >> 2) & 1), std::move(octants[o]));
+            m_nodes[n].children[o] = child;
+            split(child);
+        }
+    }
+
+    // Children are created after their parent, so one backward pass
+    // accumulates subtree bounds
+    void finish()
+    {
+        for (std::uint32_t n=static_cast<std::uint32_t>(m_nodes.size()); n-- > 0; ) {
+            OctNode& node = m_nodes[n];
+            for (std::uint32_t i : node.items) {
+                Extend(node.bounds, m_items[i].box);
+                node.maxItemSize = std::max(node.maxItemSize, Diagonal(m_items[i].box));
+            }
+            for (std::uint32_t c : node.children) {
+                if (c == AssemblyIndex::kNone) continue;
+                Extend(node.bounds, m_nodes[c].bounds);
+                node.maxItemSize = std::max(node.maxItemSize, m_nodes[c].maxItemSize);
+            }
+        }
+    }
+
+    const std::vector<Item>&       m_items;
+    const std::vector<MeshSource>& m_sources;
+    const TileOptions&             m_opt;
+    std::vector<OctNode>           m_nodes;
+};
+
+std::string TileFileName(const OctNode& n)
+{
+    return "tile_" + std::to_string(n.level) + "_" + std::to_string(n.x) + "_"
+         + std::to_string(n.y) + "_" + std::to_string(n.z) + ".glb";
+}
+
+// Error left on screen when the node's descendants are not drawn: the
+// largest occurrence they hold
+double GeometricError(const std::vector<OctNode>& nodes, const OctNode& n)
+{
+    double err = 0.0;
+    for (std::uint32_t c : n.children) {
+        if (c != AssemblyIndex::kNone) err = std::max(err, nodes[c].maxItemSize);
+    }
+    return err;
+}
+
+// 3D Tiles is z-up and rotates glTF content from y-up, so a GLB point
+// (x, y, z) sits at (x, -z, y) in the tileset frame
+template <typename JsonWriter>
+void WriteBoundingBox(JsonWriter& w, const Box& b)
+{
+    const double c[3] = {0.5 * (b[0] + b[3]), 0.5 * (b[1] + b[4]), 0.5 * (b[2] + b[5])};
+    const double h[3] = {0.5 * (b[3] - b[0]), 0.5 * (b[4] - b[1]), 0.5 * (b[5] - b[2])};
+    const double box[12] = {
+        c[0], -c[2], c[1],
+        h[0],  0.0,  0.0,
+        0.0,   h[2], 0.0,
+        0.0,   0.0,  h[1]
+    };
+    w.Key("boundingVolume");
+    w.StartObject();
+    w.Key("box");
+    w.StartArray();
+    for (double v : box) w.Double(v);
+    w.EndArray();
+    w.EndObject();
+}
+
+// Nodes whose GLB was not written keep their bounds but get no content
+template <typename JsonWriter>
+void WriteTile(JsonWriter& w, const std::vector<OctNode>& nodes, const std::vector<bool>& written,
+               std::uint32_t n)
+{
+    const OctNode& node = nodes[n];
+    w.StartObject();
+    WriteBoundingBox(w, node.bounds);
+    w.Key("geometricError"); w.Double(GeometricError(nodes, node));
+    if (n == 0) {
+        w.Key("refine"); w.String("ADD");
+    }
+    if (written[n]) {
+        const std::string uri = TileFileName(node);
+        w.Key("content");
+        w.StartObject();
+        w.Key("uri"); w.String(uri.c_str(), static_cast<SizeType>(uri.size()));
+        w.EndObject();
+    }
+    bool any = false;
+    for (std::uint32_t c : node.children) {
+        if (c == AssemblyIndex::kNone) continue;
+        if (!any) {
+            w.Key("children");
+            w.StartArray();
+            any = true;
+        }
+        WriteTile(w, nodes, written, c);
+    }
+    if (any) w.EndArray();
+    w.EndObject();
+}
+
+bool WriteTilesetJson(const std::vector<OctNode>& nodes, const std::vector<bool>& written,
+                      const std::string& file)
+{
+    FILE* f = fopen(file.c_str(), "wb");
+    if (!f) {
+        std::cerr << "❌ Cannot write " << file << "\n";
+        return false;
+    }
+    char buff[65536];
+    FileWriteStream os(f, buff, sizeof(buff));
+    Writer<FileWriteStream> w(os);
+
+    w.StartObject();
+    w.Key("asset");
+    w.StartObject();
+    w.Key("version");   w.String("1.1");
+    w.Key("generator"); w.String("step2glb");
+    w.EndObject();
+    w.Key("geometricError"); w.Double(Diagonal(nodes[0].bounds));
+    w.Key("root");
+    WriteTile(w, nodes, written, 0);
+    w.EndObject();
+    os.Flush();
+
+    // A full disk shows up as a stream error or a failed close
+    const bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+        std::cerr << "❌ Write failed: " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ExportTileset(const AssemblyIndex&              index,
+                   LeafMeshes&                       meshes,
+                   const std::vector<std::uint32_t>& rootNodes,
+                   const std::string&                dir,
+                   const TileOptions&                opt)
+{
+    Trace::Span span("Tileset", "phase", dir);
+
+    // Leaf occurrences; each definition + color is fetched from the shared
+    // leaf meshes here to size the octree and again when its tiles are built
+    std::vector<MeshSource> sources;
+    std::vector<Item>       items;
+    std::unordered_map<std::string, std::uint32_t> sourceOf;
+    {
+        Trace::Span meshSpan("TilesetMeshing", "mesh");
+        for (std::uint32_t root : rootNodes) {
+            for (std::uint32_t n=root; n<index.subtreeEnd(root); ++n) {
+                if (!meshes.isLeaf(n)) continue;
+
+                LeafRef ref = meshes.ref(n);
+                auto [it, inserted] = sourceOf.try_emplace(ref.key, static_cast<std::uint32_t>(sources.size()));
+                if (inserted) {
+                    MeshSource src{ref, kEmptyBox, 0};
+                    const CachedMesh& mesh = meshes.mesh(src.ref);
+                    for (const auto& b : mesh.triBuckets) {
+                        auto mm = calcMinMax(b.vertices, false);
+                        if (!b.vertices.empty()) Extend(src.box, {mm[0], mm[1], mm[2], mm[3], mm[4], mm[5]});
+                        src.triangles += b.indices.size() / 3;
+                    }
+                    for (const auto& e : mesh.edgeBuckets) {
+                        auto mm = calcMinMax(e.vertices, false);
+                        if (!e.vertices.empty()) Extend(src.box, {mm[0], mm[1], mm[2], mm[3], mm[4], mm[5]});
+                    }
+                    sources.push_back(std::move(src));
+                }
+
+                // Duplicates share their source's mesh, moved onto their own shape
+                const MeshSource& src = sources[it->second];
+                if (IsEmpty(src.box)) continue;
+                const gp_Trsf placement = index.world(n).Multiplied(ref.motion);
+                items.push_back({it->second, placement, TransformBox(src.box, placement)});
+            }
+        }
+    }
+
+    if (items.empty()) {
+        std::cerr << "❌ No meshable leaf components for the tileset.\n";
+        return false;
+    }
+
+    LooseOctree octree(items, sources, opt);
+    octree.build();
+    const std::vector<OctNode>& nodes = octree.nodes();
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    const std::string prefix = (dir.empty() || dir.back() == '/') ? dir : dir + "/";
+
+    std::vector<bool> written(nodes.size(), false);
+    std::size_t tiles = 0, failed = 0;
+    for (std::uint32_t n=0; n<nodes.size(); ++n) {
+        const OctNode& node = nodes[n];
+        if (node.items.empty()) continue;
+
+        MaterialRegistry reg;
+        std::vector<TriBucket>  tris;
+        std::vector<EdgeBucket> edges;
+        for (std::uint32_t i : node.items) {
+            const Item& it = items[i];
+            const CachedMesh& mesh = meshes.mesh(sources[it.source].ref);
+            AppendTransformed(mesh.triBuckets, mesh.edgeBuckets, mesh.materials,
+                              it.placement, reg, tris, edges);
+        }
+
+        GlbBuilder builder;
+        builder.addBuckets(std::move(tris), std::move(edges), reg.materials());
+        ExportStats stats;
+        written[n] = builder.writeGlb(prefix + TileFileName(node), false, stats);
+        if (written[n]) ++tiles;
+        else ++failed;
+    }
+
+    // tileset.json only references the tiles that made it to disk
+    const std::string tilesetFile = prefix + "tileset.json";
+    if (!WriteTilesetJson(nodes, written, tilesetFile)) return false;
+
+    std::cout << (failed ? "⚠️  Tileset: " : "✅ Tileset: ") << items.size() << " occurrence(s) in "
+              << tiles << " tile(s), " << nodes.size() << " octree node(s) → " << tilesetFile << "\n";
+    if (failed) std::cerr << "❌ " << failed << " tile GLB(s) could not be written\n";
+    return failed == 0;
+}
@@ -0,0 +1,182 @@
+#include "Trace.hpp"
+
+#include <rapidjson/writer.h>
+#include <rapidjson/filewritestream.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace rapidjson;
+
+namespace Trace {
+
+namespace detail {
+    std::atomic<bool> g_enabled{false};
+}
+
+namespace {
+
+struct Event {
+    const char*   name;
+    const char*   cat;
+    std::string   detail;
+    std::uint64_t ts;
+    std::uint64_t dur;
+    std::int64_t  bytes;
+    double        value;
+    bool          counter;
+};
+
+struct ThreadBuffer {
+    std::uint32_t      tid = 0;
+    std::vector<Event> events;
+};
+
+std::mutex                                 g_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+std::string                                g_file;
+std::chrono::steady_clock::time_point      g_origin;
+
+std::uint64_t NowUs()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - g_origin).count());
+}
+
+// Buffers are owned by the registry so events survive thread exit.
+ThreadBuffer& LocalBuffer()
+{
+    thread_local ThreadBuffer* tb = nullptr;
+    if (!tb) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        tb = g_buffers.back().get();
+        tb->tid = static_cast<std::uint32_t>(g_buffers.size());
+        tb->events.reserve(1024);
+    }
+    return *tb;
+}
+
+} // namespace
+
+void Enable(const std::string& file)
+{
+    g_file   = file;
+    g_origin = std::chrono::steady_clock::now();
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Counter(const char* name, double value)
+{
+    if (!Enabled()) return;
+    LocalBuffer().events.push_back({name, "counter", {}, NowUs(), 0, -1, value, true});
+}
+
+Span::Span(const char* name, const char* cat)
+    : m_name(name), m_cat(cat)
+{
+    if (Enabled()) {
+        m_active  = true;
+        m_startUs = NowUs();
+    }
+}
+
+Span::Span(const char* name, const char* cat, const std::string& detail)
+    : m_name(name), m_cat(cat)
+{
+    if (Enabled()) {
+        m_active  = true;
+        m_detail  = detail;
+        m_startUs = NowUs();
+    }
+}
+
+Span::~Span()
+{
+    if (!m_active) return;
+    std::uint64_t end = NowUs();
+    LocalBuffer().events.push_back({m_name, m_cat, std::move(m_detail),
+                                    m_startUs, end - m_startUs, m_bytes, 0.0, false});
+}
+
+bool Flush()
+{
+    if (!Enabled()) return true;
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+
+    FILE* f = fopen(g_file.c_str(), "w");
+    if (!f) {
+        std::cerr << "❌ Cannot write trace file: " << g_file << "\n";
+        return false;
+    }
+
+    char buff[65536];
+    FileWriteStream fs(f, buff, sizeof(buff));
+    Writer<FileWriteStream> w(fs);
+
+    std::size_t count = 0;
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    w.StartObject();
+    w.Key("displayTimeUnit"); w.String("ms");
+    w.Key("traceEvents");
+    w.StartArray();
+    for (const auto& tb : g_buffers) {
+        // Thread name metadata so tracks are labelled in the viewer
+        w.StartObject();
+        w.Key("name"); w.String("thread_name");
+        w.Key("ph");   w.String("M");
+        w.Key("pid");  w.Uint(1);
+        w.Key("tid");  w.Uint(tb->tid);
+        w.Key("args");
+        w.StartObject();
+        w.Key("name");
+        std::string tname = tb->tid == 1 ? "main" : "worker-" + std::to_string(tb->tid);
+        w.String(tname.c_str());
+        w.EndObject();
+        w.EndObject();
+
+        for (const auto& e : tb->events) {
+            w.StartObject();
+            w.Key("name"); w.String(e.name);
+            w.Key("cat");  w.String(e.cat);
+            w.Key("ph");   w.String(e.counter ? "C" : "X");
+            w.Key("pid");  w.Uint(1);
+            w.Key("tid");  w.Uint(tb->tid);
+            w.Key("ts");   w.Uint64(e.ts);
+            if (!e.counter) {
+                w.Key("dur"); w.Uint64(e.dur);
+            }
+            if (e.counter || e.bytes >= 0 || !e.detail.empty()) {
+                w.Key("args");
+                w.StartObject();
+                if (e.counter) {
+                    w.Key("value"); w.Double(e.value);
+                }
+                if (!e.detail.empty()) {
+                    w.Key("detail"); w.String(e.detail.c_str());
+                }
+                if (e.bytes >= 0) {
+                    w.Key("bytes"); w.Int64(e.bytes);
+                }
+                w.EndObject();
+            }
+            w.EndObject();
+            ++count;
+        }
+    }
+    w.EndArray();
+    w.EndObject();
+    fs.Flush();
+    fclose(f);
+
+    std::cout << "⏱️  Trace written: " << g_file << " (" << count << " events)\n";
+    return true;
+}
+
+} // namespace Trace
@@ -1,4 +1,6 @@
 #include "XcafTools.hpp"
+#include "Trace.hpp"
+#include "AssemblyIndex.hpp"
 
 #include <TDF_Tool.hxx>
 #include <TCollection_AsciiString.hxx>
@@ -13,6 +15,7 @@
 #include <TopoDS_Shape.hxx>
 
 #include <iostream>
+#include <filesystem>
 
 // Label path → "0-1-1-2"
 std::string LabelPathForFilename(const TDF_Label& lab)
@@ -27,6 +30,16 @@ std::string LabelPathForFilename(const TDF_Label& lab)
     return s;
 }
 
+std::string LabelName(const TDF_Label& lab, const std::string& fallback)
+{
+    Handle(TDataStd_Name) nameAttr;
+    if (lab.FindAttribute(TDataStd_Name::GetID(), nameAttr)) {
+        TCollection_AsciiString ascii(nameAttr->Get());
+        return ascii.ToCString();
+    }
+    return fallback;
+}
+
 bool GetEffectiveColor(const TDF_Label&              label,
                        const Handle(XCAFDoc_ShapeTool)& shapeTool,
                        const Handle(XCAFDoc_ColorTool)& colorTool,
@@ -93,6 +106,8 @@ bool ExportShapeToSTEP(const TDF_Label&                    compLabel,
         return false;
     }
 
+    Trace::Span span("ExportShapeToSTEP", "io", stepFile);
+
     try {
         Interface_Static::SetCVal("write.step.schema", "AP242DIS");
     } catch (...) {
@@ -114,159 +129,55 @@ bool ExportShapeToSTEP(const TDF_Label&                    compLabel,
         return false;
     }
 
+    std::error_code ec;
+    auto bytes = std::filesystem::file_size(stepFile, ec);
+    if (!ec) span.setBytes(bytes);
+
     std::cout << "📄 Colored STEP saved: " << stepFile << "\n";
     return true;
 }
 
-void CollectAssemblyComponentsShallow(
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const TDF_LabelSequence&         roots,
-    TDF_LabelSequence&               out)
+void DumpAssemblyTreeDeep(const AssemblyIndex& index)
 {
-    for (Standard_Integer r = 1; r <= roots.Length(); ++r) {
-        const TDF_Label& root = roots.Value(r);
-
-        TDF_LabelSequence children;
-        shapeTool->GetComponents(root, children, Standard_False); // shallow
-
-        if (children.IsEmpty()) {
-            out.Append(root);
-        } else {
-            for (Standard_Integer i = 1; i <= children.Length(); ++i) {
-                out.Append(children.Value(i));
-            }
+    // prefix[0, cut[d]) is the tree-drawing prefix of nodes at depth d
+    std::string              prefix;
+    std::vector<std::size_t> cut(1, 0);
+
+    for (std::uint32_t n=0; n<index.size(); ) {
+        // A label already printed also had its whole subtree printed
+        if (!index.isFirstOccurrence(n)) {
+            n = index.subtreeEnd(n);
+            continue;
         }
-    }
-}
 
-void CollectLeafComponentsDeep(
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const TDF_LabelSequence&         roots,
-    TDF_LabelSequence&               out)
-{
-    std::set<std::string> seen;
-
-    for (Standard_Integer r=1; r<=roots.Length(); ++r) {
-        const TDF_Label& root = roots.Value(r);
-
-        TDF_LabelSequence allComps;
-        shapeTool->GetComponents(root, allComps, Standard_True); // deep
+        const std::uint32_t depth = index.depth(n);
+        const std::uint32_t slot  = index.slot(n);
+        const bool isLast = index.nextSibling(n) == AssemblyIndex::kNone;
+        const bool isLeaf = index.firstChild(n) == AssemblyIndex::kNone;
 
-        for (Standard_Integer i=1; i<=allComps.Length(); ++i) {
-            const TDF_Label& lab = allComps.Value(i);
+        prefix.resize(cut[depth]);
+        std::cout << prefix << (isLast ? "└─ " : "├─ ")
+                  << "[" << index.entry(slot) << "] "
+                  << (isLeaf ? "Part" : "Assembly") << ": "
+                  << (index.hasName(slot) ? index.name(slot).c_str() : "(unnamed)");
 
-            TCollection_AsciiString entry;
-            TDF_Tool::Entry(lab, entry);
-            std::string key = entry.ToCString();
-            if (!seen.insert(key).second) {
-                continue;
-            }
-
-            TDF_LabelSequence children;
-            shapeTool->GetComponents(lab, children, Standard_False);
-            if (!children.IsEmpty()) {
-                continue;
-            }
-
-            out.Append(lab);
+        if (index.isInstance(n)) {
+            std::cout << " (→ " << index.entry(index.def(n)) << ")";
         }
-    }
 
-    if (out.IsEmpty()) {
-        for (Standard_Integer r=1; r<=roots.Length(); ++r) {
-            out.Append(roots.Value(r));
+        if (index.hasColor(slot)) {
+            const Quantity_Color& qc = index.color(slot);
+            std::cout << "  Color=("
+                      << qc.Red() << ", "
+                      << qc.Green() << ", "
+                      << qc.Blue() << ")";
         }
-    }
-}
-
-void DumpAssemblyTreeDeep(
-    const TDF_Label&                 label,
-    const Handle(XCAFDoc_ShapeTool)& shapeTool,
-    const Handle(XCAFDoc_ColorTool)& colorTool,
-    std::set<std::string>&           visited,
-    int                              depth,
-    bool                             isLast,
-    const std::string&               prefix)
-{
-    (void)depth;
-
-    if (label.IsNull()) return;
-
-    TCollection_AsciiString entry;
-    TDF_Tool::Entry(label, entry);
-    std::string key = entry.ToCString();
-    if (visited.count(key)) return;
-    visited.insert(key);
-
-    TDF_LabelSequence instChildren;
-    shapeTool->GetComponents(label, instChildren);
-
-    TDF_Label ref;
-    bool isInstance = shapeTool->GetReferredShape(label, ref);
-
-    TDF_LabelSequence protoChildren;
-    if (isInstance) {
-        shapeTool->GetComponents(ref, protoChildren);
-    }
-
-    std::vector<TDF_Label> children;
-    children.reserve(instChildren.Length() + protoChildren.Length());
-    for (Standard_Integer i=1; i<=instChildren.Length(); ++i)
-        children.push_back(instChildren.Value(i));
-    for (Standard_Integer i=1; i<=protoChildren.Length(); ++i)
-        children.push_back(protoChildren.Value(i));
-
-    bool isLeaf = children.empty();
-
-    std::string branch = isLast ? "└─ " : "├─ ";
-    std::string childPrefix = prefix + (isLast ? "   " : "│  ");
-
-    TCollection_AsciiString path;
-    TDF_Tool::Entry(label, path);
-
-    TCollection_ExtendedString xName;
-    Handle(TDataStd_Name) nAttr;
-    if (label.FindAttribute(TDataStd_Name::GetID(), nAttr))
-        xName = nAttr->Get();
-    else
-        xName = "(unnamed)";
-    TCollection_AsciiString asciiName(xName);
-
-    std::string type = isLeaf ? "Part" : "Assembly";
-
-    Quantity_Color qc;
-    bool hasColor = GetEffectiveColor(label, shapeTool, colorTool, qc);
-
-    std::cout << prefix << branch
-              << "[" << path << "] "
-              << type << ": "
-              << asciiName.ToCString();
-
-    if (isInstance) {
-        TCollection_AsciiString refPath;
-        TDF_Tool::Entry(ref, refPath);
-        std::cout << " (→ " << refPath << ")";
-    }
-
-    if (hasColor) {
-        std::cout << "  Color=("
-                  << qc.Red() << ", "
-                  << qc.Green() << ", "
-                  << qc.Blue() << ")";
-    }
 
-    std::cout << "\n";
+        std::cout << "\n";
 
-    for (std::size_t i=0; i<children.size(); ++i) {
-        bool lastChild = (i == children.size() - 1);
-        DumpAssemblyTreeDeep(
-            children[i],
-            shapeTool,
-            colorTool,
-            visited,
-            depth + 1,
-            lastChild,
-            childPrefix
-        );
+        prefix += isLast ? "   " : "│  ";
+        if (cut.size() < depth + 2) cut.resize(depth + 2);
+        cut[depth + 1] = prefix.size();
+        ++n;
     }
 }
@@ -1,7 +1,13 @@
 #include "Exporter.hpp"
+#include "QueryCommand.hpp"
+
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
+    if (argc >= 2 && !std::strcmp(argv[1], "query")) {
+        return RunQuery(argc - 1, argv + 1);
+    }
     Exporter ex;
     return ex.run(argc, argv);
 }
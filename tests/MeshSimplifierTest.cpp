@@ -0,0 +1,165 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Decimates closed meshes and checks they stay closed 2-manifolds: every
+// edge used by exactly two faces, no face repeated. Returns non-zero on
+// failure (make test).
+
+namespace {
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what, const char* mesh)
+{
+    if (ok) return;
+    std::printf("❌ %s: %s\n", mesh, what);
+    ++g_failures;
+}
+
+// Unit icosahedron, subdivided `levels` times onto the sphere
+TriBucket Icosphere(int levels)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<Vertex> v = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    std::vector<std::uint32_t> f = {
+        0, 11, 5,  0, 5, 1,   0, 1, 7,   0, 7, 10,  0, 10, 11,
+        1, 5, 9,   5, 11, 4,  11, 10, 2, 10, 7, 6,  7, 1, 8,
+        3, 9, 4,   3, 4, 2,   3, 2, 6,   3, 6, 8,   3, 8, 9,
+        4, 9, 5,   2, 4, 11,  6, 2, 10,  8, 6, 7,   9, 8, 1,
+    };
+    auto normalize = [](Vertex p) {
+        const float l = std::sqrt(p.x*p.x + p.y*p.y + p.z*p.z);
+        return Vertex{p.x / l, p.y / l, p.z / l};
+    };
+    for (auto& p : v) p = normalize(p);
+
+    for (int l=0; l<levels; ++l) {
+        std::map<std::pair<std::uint32_t, std::uint32_t>, std::uint32_t> mid;
+        auto midpoint = [&](std::uint32_t a, std::uint32_t b) {
+            auto [it, inserted] = mid.try_emplace({std::min(a, b), std::max(a, b)},
+                                                  static_cast<std::uint32_t>(v.size()));
+            if (inserted) {
+                v.push_back(normalize({(v[a].x + v[b].x) / 2, (v[a].y + v[b].y) / 2,
+                                       (v[a].z + v[b].z) / 2}));
+            }
+            return it->second;
+        };
+        std::vector<std::uint32_t> next;
+        for (std::size_t i=0; i<f.size(); i+=3) {
+            const std::uint32_t a = f[i], b = f[i + 1], c = f[i + 2];
+            const std::uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            next.insert(next.end(), {a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca});
+        }
+        f.swap(next);
+    }
+
+    TriBucket b;
+    b.vertices.assign(v.begin(), v.end());
+    for (const auto& p : v) b.normals.push_back({p.x, p.y, p.z});
+    b.indices.assign(f.begin(), f.end());
+    return b;
+}
+
+// Torus around z, `rings` × `sides` quads split in two
+TriBucket Torus(int rings, int sides)
+{
+    TriBucket b;
+    const float pi = 3.14159265f;
+    for (int i=0; i<rings; ++i) {
+        const float u = 2 * pi * i / rings;
+        for (int j=0; j<sides; ++j) {
+            const float w = 2 * pi * j / sides;
+            const float r = 2.0f + 0.6f * std::cos(w);
+            b.vertices.push_back({r * std::cos(u), r * std::sin(u), 0.6f * std::sin(w)});
+            b.normals.push_back({std::cos(w) * std::cos(u), std::cos(w) * std::sin(u), std::sin(w)});
+        }
+    }
+    auto at = [&](int i, int j) {
+        return static_cast<std::uint32_t>((i % rings) * sides + (j % sides));
+    };
+    for (int i=0; i<rings; ++i) {
+        for (int j=0; j<sides; ++j) {
+            b.indices.insert(b.indices.end(), {at(i, j), at(i + 1, j), at(i + 1, j + 1),
+                                               at(i, j), at(i + 1, j + 1), at(i, j + 1)});
+        }
+    }
+    return b;
+}
+
+// Output vertices are split at creases, so compare corners by position
+void CheckClosed(const TriBucket& b, const char* mesh)
+{
+    using Key = std::array<std::uint32_t, 3>;
+    auto key = [&](std::uint32_t i) {
+        Key k;
+        std::memcpy(k.data(), &b.vertices[i], sizeof(Vertex));
+        return k;
+    };
+
+    std::map<Key, std::uint32_t> welded;
+    std::vector<std::uint32_t> id(b.vertices.size());
+    for (std::size_t i=0; i<b.vertices.size(); ++i) {
+        id[i] = welded.try_emplace(key(static_cast<std::uint32_t>(i)),
+                                   static_cast<std::uint32_t>(welded.size())).first->second;
+    }
+
+    std::map<std::pair<std::uint32_t, std::uint32_t>, int> edgeUse;
+    std::map<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>, int> faceUse;
+    bool degenerate = false;
+    for (std::size_t i=0; i+2<b.indices.size(); i+=3) {
+        std::array<std::uint32_t, 3> t = {id[b.indices[i]], id[b.indices[i + 1]], id[b.indices[i + 2]]};
+        for (int k=0; k<3; ++k) {
+            const std::uint32_t a = t[k], c = t[(k + 1) % 3];
+            ++edgeUse[{std::min(a, c), std::max(a, c)}];
+        }
+        std::sort(t.begin(), t.end());
+        degenerate |= t[0] == t[1] || t[1] == t[2];
+        ++faceUse[{t[0], t[1], t[2]}];
+    }
+
+    bool twoFaces = true, uniqueFaces = true;
+    for (const auto& [e, n] : edgeUse) twoFaces &= n == 2;
+    for (const auto& [f, n] : faceUse) uniqueFaces &= n == 1;
+    Check(!degenerate, "degenerate triangle", mesh);
+    Check(twoFaces, "edge not shared by exactly two faces", mesh);
+    Check(uniqueFaces, "face repeated", mesh);
+}
+
+void Decimate(TriBucket b, std::size_t target, const char* mesh)
+{
+    const std::size_t in = b.indices.size() / 3;
+    const SimplifyStats st = SimplifyBucket(b, target);
+    Check(st.trianglesIn == in, "trianglesIn", mesh);
+    Check(st.trianglesOut == b.indices.size() / 3, "trianglesOut", mesh);
+    Check(st.trianglesOut < in, "no triangle removed", mesh);
+    Check(st.trianglesOut >= 4, "closed mesh decimated below a tetrahedron", mesh);
+    CheckClosed(b, mesh);
+    std::printf("📊 %s: %zu -> %zu triangles (target %zu)\n", mesh, in, st.trianglesOut, target);
+}
+
+} // namespace
+
+int main()
+{
+    for (std::size_t target : {640, 200, 50, 4}) Decimate(Icosphere(3), target, "icosphere");
+    for (std::size_t target : {300, 100, 40, 0})  Decimate(Torus(24, 12), target, "torus");
+
+    if (g_failures) {
+        std::printf("❌ %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("✅ MeshSimplifier\n");
+    return 0;
+}